@@ -9,8 +9,11 @@ struct BoundingBox {
 	static constexpr int EDGE_CT = 12;
 	
 	FVector Vertices[VERTEX_CT];
-	FVector FaceNormals[FACE_CT];
 	FVector OverlapCheckVectors[3];
 	float OverlapCheckSqMags[3];
 	float DiagDistance; // distance diagonally from vertex 0 to vertex 7
+	// for the separating axis test: unit axes along edges 0->1, 0->2, 0->3, and half the box's size along each
+	FVector Center;
+	FVector Axes[3];
+	FVector HalfExtents;
 };
\ No newline at end of file
@@ -10,22 +10,19 @@ namespace Data {
 
 	TArray<UNavMesh> NMeshes;
 	TArray<TriMesh> TMeshes;
-	TArray<Tri*> FailureCaseTris;
+	TArray<FVector> FailureCaseTris; // 3 vertices per tri
 	TArray<Polygon> FailureCasePolygons;
-	TArray<Tri*> CulledTris;
+	TArray<FVector> CulledTris; // 3 vertices per tri
 	AUNav3DBoundsVolume* BoundsVolume;
 	TriMesh BoundsVolumeTMesh;
 	TArray<AVertexCapture*> VertexCaptures;
 	
-	inline void Reset() {
+	// everything but the navmeshes, which an incremental reload keeps
+	inline void ResetForRebuild() {
 		for (int i = 0; i < Data::TMeshes.Num(); i++) {
 			TMeshes[i].ResetVertexData();
 		}
-		for (int i = 0; i < Data::NMeshes.Num(); i++) {
-			NMeshes[i].ResetVertexData();
-		}
 		TMeshes.Empty();
-		NMeshes.Empty();
 		FailureCaseTris.Empty();
 		FailureCasePolygons.Empty();
 		CulledTris.Empty();
@@ -33,5 +30,13 @@ namespace Data {
 		BoundsVolumeTMesh.ResetVertexData();
 		VertexCaptures.Empty();
 	}
+	
+	inline void Reset() {
+		ResetForRebuild();
+		for (int i = 0; i < Data::NMeshes.Num(); i++) {
+			NMeshes[i].ResetVertexData();
+		}
+		NMeshes.Empty();
+	}
 
 }
\ No newline at end of file
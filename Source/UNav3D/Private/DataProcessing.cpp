@@ -9,84 +9,93 @@
 #include "Data.h"
 #include <thread>
 #include <chrono>
-#include "GeoProcThread.h"
+#include "GeometryProcessor.h"
+#include "UNavMesh.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Queue.h"
+#include "HAL/Event.h"
+#include "RenderingThread.h"
+#include "MeshCache.h"
+#include "NavMeshFile.h"
+#include "Geometry.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "Polygon.h"
 
 #define LOCTEXT_NAMESPACE "UNav3D"
 
 namespace {
 
 	constexpr int TOTAL_RESET_TASK_CT = 3;
-	constexpr int MAX_THREAD_CT = 8;
-	constexpr int WAIT_SUCCESS = 0;
-	constexpr int WAIT_FAILURE = -1;
-	constexpr int MAX_START_THREAD_ATTEMPTS = 300;
-
-	int MaxRunningThreadCt = 4;
+	constexpr int MESH_LOD = 0; // just using LOD0 for now, like GeometryProcessor
 
 	FCriticalSection DataProcMutex;
 	GeometryProcessor GProc;
-	FGeoProcThread* GProcThreads[MAX_THREAD_CT] {nullptr};
-	FThreadSafeBool IsGProcTAvail[MAX_THREAD_CT] {true};
-	
-}
+	// outlives reloads; meshes that haven't changed since the last one are copied out instead of processed
+	MeshCache Cache;
+	// cleared to make running reform tasks bail out early
+	FThreadSafeBool IsTaskRun(true);
 
-namespace {
+	// what a mesh's build/batch/simplify tasks have to report; dialogs and debug drawing can only happen on the game
+	// thread, so errors and polygons are held here until the mesh is finished
+	struct MeshTaskResult {
+		
+		MeshTaskResult() :
+			Error(nullptr), IsFatal(false), IsPopulated(false)
+		{}
+		
+		const char* Error;
+		bool IsFatal;
+		bool IsPopulated;
+		TArray<VBufferPolygon> Polygons;
+	};
 
-	bool TryStartThread(FGeoProcThread::GEOPROC_THREAD_TASK Task, int ThreadIndex) {
-		constexpr int WAIT_MS = 10;
+	// indices of meshes whose last task has run, in the order they finished
+	TQueue<int, EQueueMode::Mpsc> FinishedMeshes;
+	// auto-reset; triggered each time a mesh goes in FinishedMeshes, so the game thread can sleep until one does. Only
+	// set while BuildNavMeshes() has mesh tasks out
+	FEvent* MeshFinishedEvent = nullptr;
 
-		for (int AttemptCt = 0; AttemptCt < MAX_START_THREAD_ATTEMPTS; AttemptCt++) {
-			if (GProcThreads[ThreadIndex]->StartThread(Task, &IsGProcTAvail[ThreadIndex], &DataProcMutex)) {
-				return true;	
-			}
-			std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_MS));
-		}
-		return false;
+	// called by a mesh's last task once its result is written
+	void FinishMesh(int MeshIndex) {
+		FinishedMeshes.Enqueue(MeshIndex);
+		MeshFinishedEvent->Trigger();
 	}
+	
+}
 
-	void GProcThreadsStop() {
-		for (int i = 0; i < MAX_THREAD_CT; i++) {
-			if (GProcThreads[i] != nullptr) {
-				GProcThreads[i]->StopThread();
-				IsGProcTAvail[i].AtomicSet(true);
-			}
-		}
-	}
+namespace {
 
-	int GProcWaitForAll(float WaitSeconds) {
-		constexpr int WAIT_MS = 100;
-		constexpr float WAIT_DELTA = WAIT_MS * 1e-3f;
-		
-		for (float WaitCtr = 0.0f; WaitCtr < WaitSeconds; WaitCtr += WAIT_DELTA) {
-			bool AllAvail = true;
-			for (int i = 0; i < MaxRunningThreadCt; i++) {
-				if (!IsGProcTAvail[i]) {
-					AllAvail = false;
-					break;;
-				}
+	// reports every mesh that has finished since the last call, without waiting on the rest; once a fatal error comes
+	// up, later results are dropped. Returns the number of meshes taken off the queue
+	int ReportFinishedMeshes(const TArray<MeshTaskResult>& Results, bool& AnyFatal) {
+		int FinishedCt = 0;
+		int MeshIndex;
+		while (FinishedMeshes.Dequeue(MeshIndex)) {
+			FinishedCt++;
+			const MeshTaskResult& Result = Results[MeshIndex];
+			if (AnyFatal) {
+				continue;
+			}
+			if (Result.Error != nullptr) {
+				UNAV_GENERR(Result.Error)
 			}
-			if (AllAvail) {
-				return WAIT_SUCCESS;
+			if (Result.IsFatal) {
+				AnyFatal = true;
 			}
-			std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_MS));
 		}
-		return WAIT_FAILURE;
+		return FinishedCt;
 	}
 
-	int GProcWaitForAvailable(float WaitSeconds) {
-		constexpr int WAIT_MS = 10;
-		constexpr float WAIT_DELTA = WAIT_MS * 1e-3f;
-		
-		for (float WaitCtr = 0.0f; WaitCtr < WaitSeconds; WaitCtr += WAIT_DELTA) {
-			for (int i = 0; i < MaxRunningThreadCt; i++) {
-				if (IsGProcTAvail[i]) {
-					GProcThreads[i]->StopThread();
-					return i;
-				}
+	// draws the group outlines the simplify tasks left in Results, then frees them; game thread only
+	void DrawMeshPolygons(const UWorld* World, TArray<MeshTaskResult>& Results) {
+		for (MeshTaskResult& Result : Results) {
+			UNavDbg::DrawVBufferPolygons(World, Result.Polygons);
+			for (auto& P : Result.Polygons) {
+				P.Empty();
 			}
-            std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_MS));
+			Result.Polygons.Empty();
 		}
-		return WAIT_FAILURE;
 	}
 
 	// Finds bounds volume in editor viewport; returns false if number of bounds volumes is not 1
@@ -111,11 +120,13 @@ namespace {
 	}
 
 	// TODO: Make an error log for more informative errors
-	bool BatchTris(const TriMesh& TMesh, TArray<TArray<TArray<Tri*>>>& MeshBatches) {
+	// runs on a task graph thread, so errors go in Result instead of a dialog
+	bool BatchTris(TriMesh& TMesh, TArray<TArray<TArray<Tri*>>>& MeshBatches, MeshTaskResult& Result) {
 		constexpr static uint16 BATCH_SZ = 128;
 		uint16 MeshBatch = 1;
 		if (TMesh.Grid.Num() / BATCH_SZ >= Tri::MAX_BATCH_CT) {
-			UNAV_GENERR("Batch size too small for one or more of the meshes. Exiting process.")
+			Result.Error = "Batch size too small for one or more of the meshes. Exiting process.";
+			Result.IsFatal = true;
 			return false;
 		}
 		int StartTriIndex = 0;
@@ -127,18 +138,20 @@ namespace {
 			);
 			if (BatchCt <= 0) {
 				if (BatchCt == 0) {
-					UNAV_GENERR("Got a batch count of zero, which might indicate a problem with a mesh. Continuing process.")
+					Result.Error =
+						"Got a batch count of zero, which might indicate a problem with a mesh. Continuing process.";
 					StartTriIndex = -1;
 				}
 				else if (BatchCt == GeometryProcessor::GEOPROC_MAXED_GROUPS) {
-					UNAV_GENERR(
+					Result.Error =
 						"The batch size was too large for one of the meshes. Try decreasing the batch size, reducing the "
-						"normal angle allowance, or removing any meshes with a large number of triangles. Exiting process."
-					)
+						"normal angle allowance, or removing any meshes with a large number of triangles. Exiting process.";
+					Result.IsFatal = true;
 					return false;
 				}
 				else {
-					UNAV_GENERR("Unexpected problem making batches. Exiting process.")
+					Result.Error = "Unexpected problem making batches. Exiting process.";
+					Result.IsFatal = true;
 					return false;
 				}
 			}
@@ -146,83 +159,334 @@ namespace {
 		return true;
 	}
 
-	// Takes meshes found inside bounds volume and populates TriMeshes with their data
-	// This must run in the game thread, since access to mesh data is only allowed there
-	bool PopulateTriMeshes(const UWorld* World, TArray<TriMesh>& TMeshes) {
-		Data::BoundsVolume->GetOverlappingMeshes(TMeshes);
-		if (TMeshes.Num() == 0) {
-			UNAV_GENERR("No static mesh actors found inside the bounds volume.")
-			return false;
+	// runs on a task graph thread: everything PopulateTriMesh() does after the buffers are read
+	void BuildTriMesh(TriMesh& TMesh, GeometryProcessor::MeshBuffers& Buffers, MeshTaskResult& Result) {
+		if (Buffers.Indices == nullptr) {
+			// readback failed; the error is already in Result
+			return;
+		}
+		const GeometryProcessor::GEOPROC_RESPONSE Response = GProc.BuildTriMesh(TMesh, Buffers);
+		if (Response == GeometryProcessor::GEOPROC_HIGH_INDEX) {
+			Result.Error = "One of the meshes was not processed correctly due to a bad index coming from the index buffer";
+			return;
 		}
+		Result.IsPopulated = true;
+#ifdef UNAV_DBG
+		UNavDbg::PrintTriMesh(TMesh);
+#endif
+	}
 
-		{
-			// populating the bounds volume tmesh for intersection testing in GeomProcessor.PopulateNavMeshes()
-			if (GProc.PopulateTriMesh(Data::BoundsVolumeTMesh) != GeometryProcessor::GEOPROC_SUCCESS) {
-				UNAV_GENERR("Bounds volume mesh was not populated correctly.")
-				return false;
-			}
+	// dispatches a task copying an already processed mesh into TMesh, in place of the build -> batch -> simplify tasks
+	FGraphEventRef DispatchCachedMeshTask(TriMesh& TMesh, const TriMesh& CachedMesh, MeshTaskResult& Result, int MeshIndex) {
+		return FFunctionGraphTask::CreateAndDispatchWhenReady(
+			[&TMesh, &CachedMesh, &Result, MeshIndex]() {
+				if (TMesh.CopyFrom(CachedMesh)) {
+					Result.IsPopulated = true;
+#ifdef UNAV_DBG
+					UNavDbg::PrintTriMesh(TMesh);
+#endif
+				}
+				else {
+					Result.Error = "The Geometry Processor failed to allocate enough space for a mesh.";
+				}
+				FinishMesh(MeshIndex);
+			},
+			TStatId(),
+			nullptr,
+			ENamedThreads::AnyThread
+		);
+	}
+
+	// dispatches a mesh's build -> batch -> simplify tasks; its buffers have to be read in full already. Returns the
+	// event of the simplify task, which keeps the finished mesh in the cache under Key and puts MeshIndex in
+	// FinishedMeshes when it's done
+	FGraphEventRef DispatchMeshTasks(
+		TriMesh& TMesh,
+		GeometryProcessor::MeshBuffers& MeshBuffers,
+		TArray<TArray<TArray<Tri*>>>& Batches,
+		MeshTaskResult& Result,
+		const MeshCacheKey& Key,
+		int MeshIndex
+	) {
+		const FGraphEventRef BuildEvent = FFunctionGraphTask::CreateAndDispatchWhenReady(
+			[&TMesh, &MeshBuffers, &Result]() {
+				BuildTriMesh(TMesh, MeshBuffers, Result);
+			},
+			TStatId(),
+			nullptr,
+			ENamedThreads::AnyThread
+		);
+		const FGraphEventRef BatchEvent = FFunctionGraphTask::CreateAndDispatchWhenReady(
+			[&TMesh, &Batches, &Result]() {
+				if (!Result.IsPopulated) {
+					return;
+				}
+				if (BatchTris(TMesh, Batches, Result)) {
+					UNavDbg::PrintMeshBatches(Batches);
+					// UNavDbg::DrawMeshBatchGroups(World, TMesh.Grid, Batches);
+				}
+			},
+			TStatId(),
+			BuildEvent,
+			ENamedThreads::AnyThread
+		);
+		return FFunctionGraphTask::CreateAndDispatchWhenReady(
+			[&TMesh, &Batches, &Result, &Key, MeshIndex]() {
+				if (Result.IsPopulated && !Result.IsFatal) {
+					uint16 BatchNo = 1;
+					for (auto& Batch : Batches) {
+						GProc.SimplifyMeshBatch(Batch, TMesh, BatchNo, Result.Polygons);
+						BatchNo++;
+					}
+					// only meshes that came through without any trouble are worth keeping
+					if (Result.Error == nullptr) {
+						Cache.AddMesh(Key, TMesh);
+					}
+				}
+				FinishMesh(MeshIndex);
+			},
+			TStatId(),
+			BatchEvent,
+			ENamedThreads::AnyThread
+		);
+	}
+
+	// Takes meshes found inside bounds volume and populates TriMeshes with their data. Only the buffer reads happen
+	// here, since access to mesh data is only allowed on the game thread. Meshes with cpu copies of their buffers are
+	// handed to the task graph as soon as they're read, so their tasks overlap with reading the meshes after them;
+	// meshes that have to be read off the gpu all share one render flush at the end and are dispatched after it.
+	// Meshes unchanged since the last reload are copied from the cache, and instances of an already read static mesh
+	// use its kept local-space data, so neither reads the mesh.
+	// SimplifyEvents gets one event per mesh, and each mesh's index goes in FinishedMeshes once its last task has run.
+	bool PopulateTriMeshes(
+		const UWorld* World,
+		TArray<TriMesh>& TMeshes,
+		TArray<MeshCacheKey>& Keys,
+		TArray<GeometryProcessor::MeshBuffers>& Buffers,
+		TArray<TArray<TArray<TArray<Tri*>>>>& MeshBatches,
+		TArray<MeshTaskResult>& Results,
+		FGraphEventArray& SimplifyEvents
+	) {
+		// populating the bounds volume tmesh for intersection testing in GeomProcessor.PopulateNavMeshes()
+		if (GProc.PopulateTriMesh(Data::BoundsVolumeTMesh) != GeometryProcessor::GEOPROC_SUCCESS) {
+			UNAV_GENERR("Bounds volume mesh was not populated correctly.")
+			return false;
 		}
 
-		// getting geometry data and populating the TriMeshes with it
+		// sized up front; tasks hold on to elements, so these can't reallocate once dispatching starts
+		Keys.SetNum(TMeshes.Num());
+		Buffers.SetNum(TMeshes.Num());
+		MeshBatches.SetNum(TMeshes.Num());
+		Results.SetNum(TMeshes.Num());
+		
+		// getting geometry data and handing each mesh off to the task graph to be populated
+		TArray<int> GPUReadIndices;
 		for (int i = 0; i < TMeshes.Num(); i++) {
 			TriMesh& TMesh = TMeshes[i];
-			GeometryProcessor::GEOPROC_RESPONSE Response = GProc.PopulateTriMesh(TMesh);
-			if (Response == GeometryProcessor::GEOPROC_HIGH_INDEX) {
-				UNAV_GENERR("One of the meshes was not processed correctly due to a bad index coming from the index buffer")
-			}
-			else if (Response == GeometryProcessor::GEOPROC_ALLOC_FAIL) {
-				UNAV_GENERR("The Geometry Processor failed to allocate enough space for a mesh.")
+			GeometryProcessor::MeshBuffers& MeshBuffers = Buffers[i];
+			MeshTaskResult& Result = Results[i];
+			MeshCacheKey& Key = Keys[i];
+			Key = MeshCacheKey(TMesh.MeshActor, MESH_LOD, GProc.GetWeldEpsilon());
+			const TriMesh* CachedMesh = Cache.FindMesh(Key);
+			if (CachedMesh != nullptr) {
+				SimplifyEvents.Add(DispatchCachedMeshTask(TMesh, *CachedMesh, Result, i));
+				continue;
 			}
-
-#ifdef UNAV_DBG
-			UNavDbg::PrintTriMesh(TMesh);
-#endif
 			
-			TArray<TArray<TArray<Tri*>>> Batches;
-			if (!BatchTris(TMesh, Batches)) {
-				return false;
+			const MeshAssetEntry* Asset = Cache.FindAsset(Key.StaticMesh, Key.LOD);
+			const GeometryProcessor::GEOPROC_RESPONSE Response = Asset != nullptr
+				? GProc.ReadCachedMeshBuffers(TMesh, MeshBuffers, *Asset)
+				: GProc.ReadMeshBuffers(TMesh, MeshBuffers);
+			if (Response == GeometryProcessor::GEOPROC_ALLOC_FAIL) {
+				Result.Error = "The Geometry Processor failed to allocate enough space for a mesh.";
 			}
-			UNavDbg::PrintMeshBatches(Batches);
-			// UNavDbg::DrawMeshBatchGroups(World, Batches);
-			
-			uint16 BatchNo = 1;
-			for (auto& Batch : Batches) {
-				GProc.SimplifyMeshBatch(Batch, TMesh, BatchNo);
-				BatchNo++;
+			else if (Response == GeometryProcessor::GEOPROC_NO_MESH_DATA) {
+				Result.Error =
+					"One of the meshes has no CPU-side geometry data, and there is no GPU to read it from. Try "
+					"enabling Allow CPU Access on the static mesh.";
+			}
+			if (MeshBuffers.IsGPURead) {
+				GPUReadIndices.Add(i);
+				continue;
 			}
-			// TODO: thread simplify
-			// simplifymeshbatch
+			if (Asset == nullptr && Response == GeometryProcessor::GEOPROC_SUCCESS) {
+				// vertices aren't transformed until the build task, so they're still in local space here
+				Cache.AddAsset(
+					Key.StaticMesh, Key.LOD, TMesh.Vertices, MeshBuffers.VertexCt,
+					MeshBuffers.Indices, MeshBuffers.IndexCt, MeshBuffers.Is32Bit
+				);
+			}
+			SimplifyEvents.Add(DispatchMeshTasks(TMesh, MeshBuffers, MeshBatches[i], Result, Key, i));
 
 			// process once group no longer needed:
 			// clear flags
 			// static shift flags
 			// set batch
 		}
+
+		if (GPUReadIndices.Num() > 0) {
+			// one render thread stall for every mesh that had to be read off the gpu
+			FlushRenderingCommands();
+			for (const int i : GPUReadIndices) {
+				GeometryProcessor::MeshBuffers& MeshBuffers = Buffers[i];
+				MeshBuffers.IsGPURead = false;
+				Cache.AddAsset(
+					Keys[i].StaticMesh, Keys[i].LOD, TMeshes[i].Vertices, MeshBuffers.VertexCt,
+					MeshBuffers.Indices, MeshBuffers.IndexCt, MeshBuffers.Is32Bit
+				);
+				SimplifyEvents.Add(
+					DispatchMeshTasks(TMeshes[i], MeshBuffers, MeshBatches[i], Results[i], Keys[i], i)
+				);
+			}
+		}
 		
 		return true;
 	}
 
-	bool ReformTriMeshes(TArray<TArray<TriMesh*>>& Groups) {
-		Data::NMeshes.Init(UNavMesh(), Groups.Num());
+	// dispatches grouping once every mesh is simplified, and a reform task per group once grouping is done; the
+	// returned event completes when the last reform does. Each group's navmesh is appended to Data::NMeshes, starting
+	// at FirstNMeshIndex
+	FGraphEventRef DispatchGroupAndReform(
+		TArray<TArray<TriMesh*>>& Groups,
+		const FGraphEventArray& SimplifyEvents,
+		FGraphEventRef& GroupEvent,
+		int& FirstNMeshIndex
+	) {
+		const FGraphEventRef ReformEvent = FGraphEvent::CreateGraphEvent();
+		GroupEvent = FFunctionGraphTask::CreateAndDispatchWhenReady(
+			[&Groups, &FirstNMeshIndex, ReformEvent]() {
+				GProc.GroupTriMeshes(Data::TMeshes, Groups);
+				// constructed in place, since UNavMesh can't be copied
+				FirstNMeshIndex = Data::NMeshes.AddDefaulted(Groups.Num());
+				FGraphEventArray ReformEvents;
+				for (int i = 0; i < Groups.Num(); i++) {
+					TArray<TriMesh*>* Group = &Groups[i];
+					UNavMesh* NMesh = &Data::NMeshes[FirstNMeshIndex + i];
+					ReformEvents.Add(FFunctionGraphTask::CreateAndDispatchWhenReady(
+						[Group, NMesh]() {
+							GeometryProcessor::ReformTriMesh(Group, &DataProcMutex, &IsTaskRun, NMesh);
+						},
+						TStatId(),
+						nullptr,
+						ENamedThreads::AnyThread
+					));
+				}
+				// ReformEvent fires once everything it's waiting on has
+				for (const FGraphEventRef& Event : ReformEvents) {
+					ReformEvent->DontCompleteUntil(Event);
+				}
+				ReformEvent->DispatchSubsequents();
+			},
+			TStatId(),
+			&SimplifyEvents,
+			ENamedThreads::AnyThread
+		);
+		return ReformEvent;
+	}
+
+	// Notes what each new navmesh was built from, so IncrementalReload() can tell what's changed since. Groups hold
+	// pointers into Data::TMeshes, and Keys lines up with Data::TMeshes
+	void RecordBuiltActors(
+		const TArray<TArray<TriMesh*>>& Groups, const TArray<MeshCacheKey>& Keys, int FirstNMeshIndex
+	) {
 		for (int i = 0; i < Groups.Num(); i++) {
-			const int Avail = GProcWaitForAvailable(200.0f);
-			if (Avail < 0) {
-				return false;	
+			UNavMesh& NMesh = Data::NMeshes[FirstNMeshIndex + i];
+			for (const TriMesh* TMesh : Groups[i]) {
+				NMesh.ActorKeys.Add(Keys[TMesh - Data::TMeshes.GetData()]);
+				NMesh.ActorBoxes.Add(TMesh->Box);
 			}
-			GProcThreads[Avail]->InitReformTMesh(&Groups[i], &Data::NMeshes[i]);
-			IsGProcTAvail[Avail].AtomicSet(false);
-			if (!TryStartThread(FGeoProcThread::GEOPROC_REFORM, Avail)) {
-				IsGProcTAvail[Avail].AtomicSet(true);
+		}
+	}
+
+	// Compares the meshes now in the bounds volume against what the navmeshes were built from. A navmesh is dirty if
+	// one of its actors moved, changed or is gone, or if the old or new box of any changed actor overlaps one of its
+	// actors' boxes. DirtyNMeshes gets the indices of dirty navmeshes, in order; Rebuild gets every mesh in Current
+	// that's new, changed or belonged to a dirty navmesh, and so has to be regrouped.
+	void FindDirtyNavMeshes(
+		const TArray<TriMesh>& Current, TArray<int>& DirtyNMeshes, TArray<TriMesh>& Rebuild
+	) {
+		// where each actor ended up: navmesh index, then index in that navmesh's actors
+		TMap<const AStaticMeshActor*, FIntPoint> BuiltActors;
+		TArray<TArray<bool>> IsActorSeen;
+		TArray<bool> IsNMeshDirty;
+		IsActorSeen.SetNum(Data::NMeshes.Num());
+		IsNMeshDirty.Init(false, Data::NMeshes.Num());
+		for (int i = 0; i < Data::NMeshes.Num(); i++) {
+			const UNavMesh& NMesh = Data::NMeshes[i];
+			IsActorSeen[i].Init(false, NMesh.MeshActors.Num());
+			for (int j = 0; j < NMesh.MeshActors.Num(); j++) {
+				BuiltActors.Add(NMesh.MeshActors[j], FIntPoint(i, j));
 			}
 		}
-		if (GProcWaitForAll(200.0f) == WAIT_SUCCESS) {
-			return true;
+
+		// boxes of anything changed, both where it was and where it is
+		TArray<const BoundingBox*> DirtyBoxes;
+		TArray<bool> IsCurrentChanged;
+		IsCurrentChanged.Init(false, Current.Num());
+		for (int i = 0; i < Current.Num(); i++) {
+			const TriMesh& TMesh = Current[i];
+			const FIntPoint* Built = BuiltActors.Find(TMesh.MeshActor);
+			if (Built == nullptr) {
+				IsCurrentChanged[i] = true;
+				DirtyBoxes.Add(&TMesh.Box);
+				continue;
+			}
+			const UNavMesh& NMesh = Data::NMeshes[Built->X];
+			IsActorSeen[Built->X][Built->Y] = true;
+			const MeshCacheKey Key(TMesh.MeshActor, MESH_LOD, GProc.GetWeldEpsilon());
+			if (!(Key == NMesh.ActorKeys[Built->Y])) {
+				IsCurrentChanged[i] = true;
+				IsNMeshDirty[Built->X] = true;
+				DirtyBoxes.Add(&TMesh.Box);
+				DirtyBoxes.Add(&NMesh.ActorBoxes[Built->Y]);
+			}
+		}
+		// actors that were built but aren't in the volume anymore; they may not exist at all, so they aren't touched
+		for (int i = 0; i < Data::NMeshes.Num(); i++) {
+			for (int j = 0; j < IsActorSeen[i].Num(); j++) {
+				if (!IsActorSeen[i][j]) {
+					IsNMeshDirty[i] = true;
+					DirtyBoxes.Add(&Data::NMeshes[i].ActorBoxes[j]);
+				}
+			}
+		}
+
+		// navmeshes near a change may now intersect (or no longer intersect) the changed actor. Groups are split by
+		// intersection, so a navmesh dirtied here can't pull in any other
+		TArray<int> Overlaps;
+		for (int i = 0; i < Data::NMeshes.Num() && DirtyBoxes.Num() > 0; i++) {
+			if (IsNMeshDirty[i]) {
+				continue;
+			}
+			for (const BoundingBox& ActorBox : Data::NMeshes[i].ActorBoxes) {
+				Geometry::GetOverlappingBoxes(ActorBox, DirtyBoxes, Overlaps);
+				if (Overlaps.Num() > 0) {
+					IsNMeshDirty[i] = true;
+					break;
+				}
+			}
+		}
+
+		for (int i = 0; i < Data::NMeshes.Num(); i++) {
+			if (IsNMeshDirty[i]) {
+				DirtyNMeshes.Add(i);
+			}
+		}
+		for (int i = 0; i < Current.Num(); i++) {
+			const FIntPoint* Built = BuiltActors.Find(Current[i].MeshActor);
+			if (IsCurrentChanged[i] || (Built != nullptr && IsNMeshDirty[Built->X])) {
+				Rebuild.Add(Current[i]);
+			}
+		}
+	}
+
+	// frees the given navmeshes and takes them out of Data::NMeshes; the rest keep their order
+	void RemoveNavMeshes(const TArray<int>& NMeshIndices) {
+		for (int i = NMeshIndices.Num() - 1; i >= 0; i--) {
+			const int NMeshIndex = NMeshIndices[i];
+			Data::NMeshes[NMeshIndex].ResetVertexData();
+			Data::NMeshes.RemoveAt(NMeshIndex);
 		}
-		// FThreadSafeBool B(true);
-		// for (int i = 0; i <Groups.Num(); i++) {
-		// 	GProc.ReformTriMesh(&Groups[i], &DataProcMutex, &B, &Data::NMeshes[i]);
-		// }
-		return true;
 	}
 
 	// Advance the progress bar
@@ -260,29 +524,170 @@ namespace {
 
 bool DataProcessing::Init() {
 	Cleanup();
-	for (int i = 0; i < MaxRunningThreadCt; i++) {
-		GProcThreads[i] = new FGeoProcThread();
-		if (GProcThreads[i] == nullptr) {
-			Cleanup();
-			return false;			
-		}
-	}
+	IsTaskRun.AtomicSet(true);
 	return true;
 }
 
 void DataProcessing::Cleanup() {
-	for (int i = 0; i < MAX_THREAD_CT; i++) {
-		if (GProcThreads[i] != nullptr) {
-			GProcThreads[i]->StopThread();
-			delete GProcThreads[i];
-			GProcThreads[i] = nullptr;
+	// every task is waited on before TotalReload() returns, so there's nothing left to stop but any stragglers
+	IsTaskRun.AtomicSet(false);
+}
+
+namespace {
+
+	// what the navmeshes were last built against; when it changes, IncrementalReload() falls back to TotalReload()
+	bool IsBuilt = false;
+	BoundingBox BuiltBoundsBox;
+	float BuiltWeldEpsilon = 0.0f;
+
+	// a moved or resized volume changes what every navmesh is clipped to, and a new weld epsilon changes every mesh;
+	// the volume's box is only up to date after GetOverlappingMeshes()
+	bool IsBoundsVolumeUnchanged() {
+		const BoundingBox& BBox = Data::BoundsVolume->GetBBox();
+		for (int i = 0; i < BoundingBox::VERTEX_CT; i++) {
+			if (BBox.Vertices[i] != BuiltBoundsBox.Vertices[i]) {
+				return false;
+			}
+		}
+		return GProc.GetWeldEpsilon() == BuiltWeldEpsilon;
+	}
+
+#ifdef UNAV_DBG
+	// maps the file at Path back in and checks it against NMeshes
+	bool CheckNavMeshFile(const FString& Path, const TArray<UNavMesh>& NMeshes) {
+		NavMeshFile::MappedFile File;
+		if (!File.Open(Path) || File.Num() != NMeshes.Num()) {
+			printf("TEMP ERROR CheckNavMeshFile() navmesh file doesn't load\n");
+			return false;
+		}
+		bool Success = true;
+		for (int i = 0; i < File.Num(); i++) {
+			if (!NavMeshFile::Matches(File.GetMesh(i), NMeshes[i])) {
+				printf("TEMP ERROR CheckNavMeshFile() navmesh %d doesn't read back as written\n", i);
+				Success = false;
+			}
 		}
-	}	
+		return Success;
+	}
+
+	// Builds a two-tri navmesh by hand, writes it to a scratch file, then maps the file back and checks it against the
+	// navmesh, and loads it and checks the loaded navmesh against the file. Needs nothing built, so the file format is
+	// checked even when no navmesh has ever been saved
+	bool CheckNavMeshFileRoundTrip() {
+		TArray<UNavMesh> Written;
+		UNavMesh& NMesh = Written.AddDefaulted_GetRef();
+		NMesh.VertexCt = 4;
+		NMesh.Vertices = new FVector[4] {
+			FVector(0.0f, 0.0f, 0.0f), FVector(100.0f, 0.0f, 0.0f), FVector(0.0f, 100.0f, 0.0f), FVector(100.0f, 100.0f, 0.0f)
+		};
+		FVector* V = NMesh.Vertices;
+		Geometry::SetBoundingBox(NMesh.Box, V[0], V[3]);
+		TArray<TempTri> Tris;
+		Tris.Add(TempTri(&V[0], &V[1], &V[2]));
+		Tris.Add(TempTri(&V[2], &V[1], &V[3]));
+		NMesh.Grid.SetVertices(V);
+		NMesh.Grid.Init(NMesh, Tris);
+		if (NMesh.Grid.Num() != 2) {
+			printf("TEMP ERROR CheckNavMeshFileRoundTrip() test navmesh didn't build\n");
+			return false;
+		}
+
+		const FString Path = FPaths::Combine(FPaths::ProjectIntermediateDir(), TEXT("UNav3D"), TEXT("RoundTrip.unav3d"));
+		bool Success = NavMeshFile::Write(Written, Path) && CheckNavMeshFile(Path, Written);
+		if (Success) {
+			NavMeshFile::MappedFile File;
+			TArray<UNavMesh> Loaded;
+			Success = File.Open(Path)
+				&& NavMeshFile::Load(File, Loaded)
+				&& Loaded.Num() == 1
+				&& NavMeshFile::Matches(File.GetMesh(0), Loaded[0]);
+		}
+		IFileManager::Get().Delete(*Path);
+		return Success;
+	}
+#endif
+
+	// writes Data::NMeshes out to be loaded with the map; in debug builds, maps the file back and checks it against
+	// what was written
+	void SaveNavMeshes(const UWorld* World) {
+		const FString Path = NavMeshFile::GetPath(World->GetMapName());
+		if (!NavMeshFile::Write(Data::NMeshes, Path)) {
+			UNAV_GENERR(FString::Printf(TEXT("Failed to save navmeshes to %s"), *Path))
+			return;
+		}
+#ifdef UNAV_DBG
+		CheckNavMeshFile(Path, Data::NMeshes);
+#endif
+	}
+
+	// Takes the meshes in Data::TMeshes through populate, group and reform, adding a navmesh per group to
+	// Data::NMeshes. If EvictUnused, anything the cache wasn't asked for this time is dropped from it
+	void BuildNavMeshes(const UWorld* World, FScopedSlowTask& Task, bool EvictUnused) {
+		// the pipeline is a graph of tasks: readback (game thread) -> build -> batch -> simplify, per mesh, then group
+		// once all meshes are simplified, then reform per group. The game thread only blocks where it needs results.
+		EnterProgressFrame(Task, "getting and simplifying static mesh data");
+		TArray<MeshCacheKey> Keys;
+		TArray<GeometryProcessor::MeshBuffers> Buffers;
+		TArray<TArray<TArray<TArray<Tri*>>>> MeshBatches;
+		TArray<MeshTaskResult> Results;
+		FGraphEventArray SimplifyEvents;
+		if (EvictUnused) {
+			Cache.BeginRebuild();
+		}
+		MeshFinishedEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		const bool PopulateSuccess = PopulateTriMeshes(
+			World, Data::TMeshes, Keys, Buffers, MeshBatches, Results, SimplifyEvents
+		);
+		// reporting each mesh as it finishes rather than after the slowest one. The event is auto-reset and every
+		// finished mesh triggers it after it's queued, so a wait can't miss one that finished while the queue was drained
+		bool AnyFatal = false;
+		for (int FinishedCt = 0; FinishedCt < SimplifyEvents.Num(); ) {
+			const int ReportedCt = ReportFinishedMeshes(Results, AnyFatal);
+			if (ReportedCt == 0) {
+				MeshFinishedEvent->Wait();
+			}
+			FinishedCt += ReportedCt;
+		}
+		FTaskGraphInterface::Get().WaitUntilTasksComplete(SimplifyEvents, ENamedThreads::GameThread);
+		// no task can touch the event anymore
+		FPlatformProcess::ReturnSynchEventToPool(MeshFinishedEvent);
+		MeshFinishedEvent = nullptr;
+		DrawMeshPolygons(World, Results);
+		if (EvictUnused) {
+			// whatever wasn't in the bounds volume this time around is let go
+			Cache.EndRebuild();
+		}
+		if (!PopulateSuccess || AnyFatal) {
+			return;
+		}
+
+		EnterProgressFrame(Task, "grouping meshes by intersection");
+		TArray<TArray<TriMesh*>> TMeshGroups;
+		FGraphEventRef GroupEvent;
+		int FirstNMeshIndex;
+		const FGraphEventRef ReformEvent = DispatchGroupAndReform(
+			TMeshGroups, SimplifyEvents, GroupEvent, FirstNMeshIndex
+		);
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(GroupEvent, ENamedThreads::GameThread);
+		
+		EnterProgressFrame(Task, "reforming meshes");
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(ReformEvent, ENamedThreads::GameThread);
+		RecordBuiltActors(TMeshGroups, Keys, FirstNMeshIndex);
+		BuiltBoundsBox = Data::BoundsVolume->GetBBox();
+		BuiltWeldEpsilon = GProc.GetWeldEpsilon();
+		IsBuilt = true;
+		SaveNavMeshes(World);
+
+#ifdef UNAV_DBG
+		UNavDbg::DrawSavedLines(World);
+#endif
+	}
+	
 }
 
 void DataProcessing::TotalReload() {
-	Data::Reset();	
-	GProcThreadsStop();
+	Data::Reset();
+	IsBuilt = false;
 	
 	if (GEditor == nullptr || GEditor->GetEditorWorldContext().World() == nullptr) {
 		UNAV_GENERR("GEditor or World Unavailable")
@@ -294,35 +699,130 @@ void DataProcessing::TotalReload() {
 	if (!SetBoundsVolume(World)) {
 		return;
 	}
+	GProc.SetWeldEpsilon(Data::BoundsVolume->WeldEpsilon);
 
 #ifdef UNAV_DEV
 	// vertex captures can be placed in the world so triangles with matching vertices can be stopped on in debugging
 	InitVertexCaptures(World);
 #endif
+
+	Data::BoundsVolume->GetOverlappingMeshes(Data::TMeshes);
+	if (Data::TMeshes.Num() == 0) {
+		UNAV_GENERR("No static mesh actors found inside the bounds volume.")
+		return;
+	}
 	
 	// starting up progress bar
 	FScopedSlowTask Task(
 		TOTAL_RESET_TASK_CT, LOCTEXT("Unav3D", "UNav3D working on...")
 	);
 	Task.MakeDialog(false);
-	
-	EnterProgressFrame(Task, "getting and simplifying static mesh data");
-	if (!PopulateTriMeshes(World, Data::TMeshes)) {
+	BuildNavMeshes(World, Task, true);
+}
+
+void DataProcessing::LoadNavMeshes() {
+	Data::Reset();
+	IsBuilt = false;
+#ifdef UNAV_DBG
+	if (!CheckNavMeshFileRoundTrip()) {
+		UNAV_GENERR("The navmesh file round trip check failed; navmesh files may not load as they were saved.")
+	}
+#endif
+	if (GEditor == nullptr || GEditor->GetEditorWorldContext().World() == nullptr) {
+		return;
+	}
+	const FString Path = NavMeshFile::GetPath(GEditor->GetEditorWorldContext().World()->GetMapName());
+	if (!FPaths::FileExists(Path)) {
+		return;
+	}
+	NavMeshFile::MappedFile File;
+	if (!File.Open(Path)) {
+		UNAV_GENERR(FString::Printf(TEXT("Navmeshes saved at %s don't load; try rebuilding them"), *Path))
 		return;
 	}
+	if (!NavMeshFile::Load(File, Data::NMeshes)) {
+		UNAV_GENERR("The Geometry Processor failed to allocate enough space for the saved navmeshes.")
+		return;
+	}
+	File.Close();
+
+#ifdef UNAV_DBG
+	// the loaded navmeshes against the file they came from, then a write of them against what was written
+	CheckNavMeshFile(Path, Data::NMeshes);
+	const FString CheckPath = Path + TEXT(".check");
+	if (NavMeshFile::Write(Data::NMeshes, CheckPath)) {
+		CheckNavMeshFile(CheckPath, Data::NMeshes);
+		IFileManager::Get().Delete(*CheckPath);
+	}
+	else {
+		printf("TEMP ERROR LoadNavMeshes() check file couldn't be written\n");
+	}
+#endif
+}
 
-	return;
-	EnterProgressFrame(Task, "grouping meshes by intersection");
-	TArray<TArray<TriMesh*>> TMeshGroups;
-	GProc.GroupTriMeshes(Data::TMeshes, TMeshGroups);
+void DataProcessing::IncrementalReload() {
+	if (!IsBuilt) {
+		TotalReload();
+		return;
+	}
+	// the navmeshes are kept; everything else is rebuilt
+	Data::ResetForRebuild();
 	
-	EnterProgressFrame(Task, "reforming meshes");
-	if (!ReformTriMeshes(TMeshGroups)) {
+	if (GEditor == nullptr || GEditor->GetEditorWorldContext().World() == nullptr) {
+		UNAV_GENERR("GEditor or World Unavailable")
+		return;
+	}
+	const UWorld* World = GEditor->GetEditorWorldContext().World();
+	if (!SetBoundsVolume(World)) {
+		return;
+	}
+	GProc.SetWeldEpsilon(Data::BoundsVolume->WeldEpsilon);
+	TArray<TriMesh> CurrentTMeshes;
+	Data::BoundsVolume->GetOverlappingMeshes(CurrentTMeshes);
+	if (!IsBoundsVolumeUnchanged()) {
+		TotalReload();
 		return;
 	}
 
-#ifdef UNAV_DBG
-	UNavDbg::DrawSavedLines(World);
+#ifdef UNAV_DEV
+	InitVertexCaptures(World);
+#endif
+
+	TArray<int> DirtyNMeshes;
+	FindDirtyNavMeshes(CurrentTMeshes, DirtyNMeshes, Data::TMeshes);
+	RemoveNavMeshes(DirtyNMeshes);
+	if (Data::TMeshes.Num() == 0) {
+		// nothing changed, or the only changes were removals
+		return;
+	}
+
+#ifdef UNAV_DEV
+	// kept navmeshes are relocated by RemoveAt but must keep their buffers through the rebuild
+	TArray<const void*> KeptBuffers;
+	const int KeptCt = Data::NMeshes.Num();
+	for (const UNavMesh& NMesh : Data::NMeshes) {
+		KeptBuffers.Add(NMesh.Vertices);
+		KeptBuffers.Add(NMesh.Grid.GetStore());
+	}
+#endif
+
+	FScopedSlowTask Task(
+		TOTAL_RESET_TASK_CT, LOCTEXT("Unav3D", "UNav3D working on...")
+	);
+	Task.MakeDialog(false);
+	BuildNavMeshes(World, Task, false);
+
+#ifdef UNAV_DEV
+	for (int i = 0; i < KeptCt; i++) {
+		if (
+			Data::NMeshes.Num() <= i
+			|| Data::NMeshes[i].Vertices != KeptBuffers[i * 2]
+			|| Data::NMeshes[i].Grid.GetStore() != KeptBuffers[i * 2 + 1]
+		) {
+			UNAV_GENERR("incremental reload rebuilt a navmesh that was not dirty")
+			break;
+		}
+	}
 #endif
 }
 
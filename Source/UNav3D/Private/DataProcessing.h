@@ -5,5 +5,13 @@ namespace DataProcessing {
 	bool Init();
 	void Cleanup();
 	void TotalReload();
+
+	// Rebuilds only the navmeshes near actors that were added, removed, moved or changed since the last reload; the
+	// rest are kept as they are. Does a TotalReload() if there's nothing to build on
+	void IncrementalReload();
+
+	// Replaces Data::NMeshes with the navmeshes saved for the editor world's map, if there are any. What they were
+	// built from isn't saved, so the next IncrementalReload() is a TotalReload()
+	void LoadNavMeshes();
 	
 }
@@ -8,6 +8,7 @@
 #include "Tri.h"
 #include "Polygon.h"
 #include "UNavMesh.h"
+#include "ScratchArena.h"
 
 namespace {
 	TArray<FVector> LineA;
@@ -16,8 +17,13 @@ namespace {
 
 void UNavDbg::PrintTriMesh(const TriMesh& TMesh) {
 	printf(
-		"Bounds Volume found Mesh %s with %d vertices and %d tris.\n", 
-		TCHAR_TO_ANSI(*TMesh.MeshActor->GetName()), TMesh.VertexCt, TMesh.Grid.Num()
+		"Bounds Volume found Mesh %s with %d vertices (%d welded) and %d tris.\n", 
+		TCHAR_TO_ANSI(*TMesh.MeshActor->GetName()), TMesh.VertexCt, TMesh.WeldedVertexCt, TMesh.Grid.Num()
+	);
+	const FIntVector& CellCounts = TMesh.Grid.GetCellCounts();
+	printf(
+		"-- grid is %d x %d x %d cells, %d of which hold tris.\n",
+		CellCounts.X, CellCounts.Y, CellCounts.Z, TMesh.Grid.GetOccupiedCellCt()
 	);
 }
 
@@ -105,20 +111,23 @@ void UNavDbg::DrawTriMeshVerticesMulti(const UWorld* World, const TArray<TriMesh
 void UNavDbg::DrawTriGridTris(const UWorld* World, const TriGrid& Tris) {
 	for (int i = 0; i < Tris.Num(); i++) {
 		const auto& Tri = Tris[i];
+		const FVector& A = Tris.GetA(i);
+		const FVector& B = Tris.GetB(i);
+		const FVector& C = Tris.GetC(i);
 		if (Tri.IsCull()) {
-			DrawDebugLine(World, Tri.A, Tri.B, FColor::Red, false, DBG_DRAW_TIME, 0, 1.0f);
-			DrawDebugLine(World, Tri.B, Tri.C, FColor::Red, false, DBG_DRAW_TIME, 0, 1.0f); 
-			DrawDebugLine(World, Tri.C, Tri.A, FColor::Red, false, DBG_DRAW_TIME, 0, 1.0f);
+			DrawDebugLine(World, A, B, FColor::Red, false, DBG_DRAW_TIME, 0, 1.0f);
+			DrawDebugLine(World, B, C, FColor::Red, false, DBG_DRAW_TIME, 0, 1.0f); 
+			DrawDebugLine(World, C, A, FColor::Red, false, DBG_DRAW_TIME, 0, 1.0f);
 		}
 		else if (Tri.IsAObscured() || Tri.IsBObscured() || Tri.IsCObscured()) {
-			DrawDebugLine(World, Tri.A, Tri.B, FColor::Magenta, false, DBG_DRAW_TIME, 0, 1.0f);
-			DrawDebugLine(World, Tri.B, Tri.C, FColor::Magenta, false, DBG_DRAW_TIME, 0, 1.0f);
-			DrawDebugLine(World, Tri.C, Tri.A, FColor::Magenta, false, DBG_DRAW_TIME, 0, 1.0f);
+			DrawDebugLine(World, A, B, FColor::Magenta, false, DBG_DRAW_TIME, 0, 1.0f);
+			DrawDebugLine(World, B, C, FColor::Magenta, false, DBG_DRAW_TIME, 0, 1.0f);
+			DrawDebugLine(World, C, A, FColor::Magenta, false, DBG_DRAW_TIME, 0, 1.0f);
 		}
 		else {
-			DrawDebugLine(World, Tri.A, Tri.B, FColor::Green, false, DBG_DRAW_TIME, 0, 1.0f);
-			DrawDebugLine(World, Tri.B, Tri.C, FColor::Green, false, DBG_DRAW_TIME, 0, 1.0f);
-			DrawDebugLine(World, Tri.C, Tri.A, FColor::Green, false, DBG_DRAW_TIME, 0, 1.0f);
+			DrawDebugLine(World, A, B, FColor::Green, false, DBG_DRAW_TIME, 0, 1.0f);
+			DrawDebugLine(World, B, C, FColor::Green, false, DBG_DRAW_TIME, 0, 1.0f);
+			DrawDebugLine(World, C, A, FColor::Green, false, DBG_DRAW_TIME, 0, 1.0f);
 		}
 	}
 }
@@ -153,7 +162,7 @@ void UNavDbg::PrintTriMeshIntersectGroups(const TArray<TArray<TriMesh*>> Interse
 }
 
 void UNavDbg::DrawPolygon(const UWorld* World, const Polygon& P) {
-	const TArray<PolyNode>& Points = P.Vertices;
+	const TScratchArray<PolyNode>& Points = P.Vertices;
 	for (int i = 0; i < Points.Num() - 1; i++) {
 		DrawDebugLine(World, Points[i].Location, Points[i + 1].Location, FColor::Purple, false, DBG_DRAW_TIME, 0, 1.5f);	
 	}
@@ -174,33 +183,38 @@ void UNavDbg::DrawAllPolygons(const UWorld* World, const TArray<TArray<TArray<Po
 
 void UNavDbg::DrawTriMeshNormals(const UWorld* World, const TriMesh& TMesh) {
 	for (int i = 0; i < TMesh.Grid.Num(); i++) {
-		auto& T = TMesh.Grid[i];
-		DrawDebugLine(World, T.GetCenter(), T.GetCenter() + T.Normal * 10.0f, FColor::Green, false, DBG_DRAW_TIME, 0, 1.5f);
+		const FVector Center = TMesh.Grid.GetCenter(i);
+		DrawDebugLine(World, Center, Center + TMesh.Grid.GetNormal(i) * 10.0f, FColor::Green, false, DBG_DRAW_TIME, 0, 1.5f);
 	}
 }
 
 void UNavDbg::DrawNavMeshNormals(const UWorld* World, const UNavMesh& NMesh) {
 	for (int i = 0; i < NMesh.Grid.Num(); i++) {
-		auto& T = NMesh.Grid[i];
-		DrawDebugLine(World, T.GetCenter(), T.GetCenter() + T.Normal * 10.0f, FColor::Red, false, DBG_DRAW_TIME, 0, 1.5f);
+		const FVector Center = NMesh.Grid.GetCenter(i);
+		DrawDebugLine(World, Center, Center + NMesh.Grid.GetNormal(i) * 10.0f, FColor::Red, false, DBG_DRAW_TIME, 0, 1.5f);
 	}
 }
 
-void UNavDbg::DrawTris(const UWorld* World, const TArray<Tri>& Tris, FColor Color) {
-	for (int i = 0; i < Tris.Num(); i++) {
-		const auto& Tri = Tris[i];
-		DrawDebugLine(World, Tri.A, Tri.B, Color, false, DBG_DRAW_TIME, 0, 2.0f);
-		DrawDebugLine(World, Tri.B, Tri.C, Color, false, DBG_DRAW_TIME, 0, 2.0f); 
-		DrawDebugLine(World, Tri.C, Tri.A, Color, false, DBG_DRAW_TIME, 0, 2.0f);
+void UNavDbg::DrawTris(const UWorld* World, const TArray<FVector>& TriVertices, FColor Color) {
+	for (int i = 0; i + 2 < TriVertices.Num(); i += 3) {
+		const FVector& A = TriVertices[i];
+		const FVector& B = TriVertices[i + 1];
+		const FVector& C = TriVertices[i + 2];
+		DrawDebugLine(World, A, B, Color, false, DBG_DRAW_TIME, 0, 2.0f);
+		DrawDebugLine(World, B, C, Color, false, DBG_DRAW_TIME, 0, 2.0f); 
+		DrawDebugLine(World, C, A, Color, false, DBG_DRAW_TIME, 0, 2.0f);
 	}	
 }
 
-void UNavDbg::DrawTris(const UWorld* World, const TArray<Tri*>& Tris, FColor Color) {
+void UNavDbg::DrawTris(const UWorld* World, const TriGrid& Grid, const TArray<Tri*>& Tris, FColor Color) {
 	for (int i = 0; i < Tris.Num(); i++) {
-		const auto& Tri = Tris[i];
-		DrawDebugLine(World, Tri->A, Tri->B, Color, false, DBG_DRAW_TIME, 0, 2.0f);
-		DrawDebugLine(World, Tri->B, Tri->C, Color, false, DBG_DRAW_TIME, 0, 2.0f); 
-		DrawDebugLine(World, Tri->C, Tri->A, Color, false, DBG_DRAW_TIME, 0,2.0f);
+		const int TriIndex = Grid.GetIndex(Tris[i]);
+		const FVector& A = Grid.GetA(TriIndex);
+		const FVector& B = Grid.GetB(TriIndex);
+		const FVector& C = Grid.GetC(TriIndex);
+		DrawDebugLine(World, A, B, Color, false, DBG_DRAW_TIME, 0, 2.0f);
+		DrawDebugLine(World, B, C, Color, false, DBG_DRAW_TIME, 0, 2.0f); 
+		DrawDebugLine(World, C, A, Color, false, DBG_DRAW_TIME, 0,2.0f);
 	}	
 }
 
@@ -210,26 +224,29 @@ void UNavDbg::DrawPolygons(const UWorld* World, const TArray<Polygon>& Polygons,
 	}	
 }
 
-void UNavDbg::PrintTri(const Tri& T) {
-	printf("...\nTri:\nA.X: %2.f, A.Y: %.2f, A.Z: %.2f\n", T.A.X, T.A.Y, T.A.Z);
-	printf("B.X: %2.f, B.Y: %.2f, B.Z: %.2f\n", T.B.X, T.B.Y, T.B.Z);
-	printf("C.X: %2.f, C.Y: %.2f, C.Z: %.2f\n...\n", T.C.X, T.C.Y, T.C.Z);
+void UNavDbg::PrintTri(const TriGrid& Grid, int TriIndex) {
+	const FVector& A = Grid.GetA(TriIndex);
+	const FVector& B = Grid.GetB(TriIndex);
+	const FVector& C = Grid.GetC(TriIndex);
+	printf("...\nTri:\nA.X: %2.f, A.Y: %.2f, A.Z: %.2f\n", A.X, A.Y, A.Z);
+	printf("B.X: %2.f, B.Y: %.2f, B.Z: %.2f\n", B.X, B.Y, B.Z);
+	printf("C.X: %2.f, C.Y: %.2f, C.Z: %.2f\n...\n", C.X, C.Y, C.Z);
 }
 
-bool UNavDbg::DoesTriMatchVertexCaptures(const Tri& T) {
+bool UNavDbg::DoesTriMatchVertexCaptures(const TriGrid& Grid, int TriIndex) {
 	int InsideCt = 0;
 	for (const auto& VC : Data::VertexCaptures) {
-		if (Geometry::IsPointInsideBox(VC->GetBBox(), T.A)) {
+		if (Geometry::IsPointInsideBox(VC->GetBBox(), Grid.GetA(TriIndex))) {
 			if (++InsideCt == 3) {
 				return true;
 			}
 		}
-		if (Geometry::IsPointInsideBox(VC->GetBBox(), T.B)) {
+		if (Geometry::IsPointInsideBox(VC->GetBBox(), Grid.GetB(TriIndex))) {
 			if (++InsideCt == 3) {
 				return true;
 			}
 		}
-		if (Geometry::IsPointInsideBox(VC->GetBBox(), T.C)) {
+		if (Geometry::IsPointInsideBox(VC->GetBBox(), Grid.GetC(TriIndex))) {
 			if (++InsideCt == 3) {
 				return true;
 			}
@@ -238,14 +255,14 @@ bool UNavDbg::DoesTriMatchVertexCaptures(const Tri& T) {
 	return false;
 }
 
-void UNavDbg::BreakOnVertexCaptureMatch(const Tri& T) {
-	if (DoesTriMatchVertexCaptures(T)) {
+void UNavDbg::BreakOnVertexCaptureMatch(const TriGrid& Grid, int TriIndex) {
+	if (DoesTriMatchVertexCaptures(Grid, TriIndex)) {
 		check(false);
 	}
 }
 
-void UNavDbg::BreakOnVertexCaptureMatch(const Tri& A, const Tri& B) {
-	if (DoesTriMatchVertexCaptures(A) && DoesTriMatchVertexCaptures(B)) {
+void UNavDbg::BreakOnVertexCaptureMatch(const TriGrid& GridA, int TriIndexA, const TriGrid& GridB, int TriIndexB) {
+	if (DoesTriMatchVertexCaptures(GridA, TriIndexA) && DoesTriMatchVertexCaptures(GridB, TriIndexB)) {
 		check(false);
 	}
 }
@@ -287,7 +304,21 @@ void UNavDbg::PrintThreadSuccess(FCriticalSection* Mutex) {
 	printf("Thread success\n");
 }
 
-void UNavDbg::DrawMeshBatches(const UWorld* World, TArray<TArray<TArray<Tri*>>>& Batches) {
+void UNavDbg::PrintScratchArenaStats(
+	const TArray<TriMesh*>& Group, const ScratchArena& Arena, FCriticalSection* Mutex
+) {
+	FScopeLock Lock(Mutex);
+	printf(
+		"group of %d: %d scratch allocs (%d failed, moved to heap), %llu bytes peak, %llu bytes of blocks\n",
+		Group.Num(),
+		Arena.GetAllocCt(),
+		Arena.GetFailedAllocCt(),
+		(unsigned long long)Arena.GetUsedBytes(),
+		(unsigned long long)Arena.GetBlockBytes()
+	);
+}
+
+void UNavDbg::DrawMeshBatches(const UWorld* World, const TriGrid& Grid, TArray<TArray<TArray<Tri*>>>& Batches) {
 	const FColor Colors[8] {
 		FColor::Blue, FColor::Cyan, FColor::Green, FColor::Magenta,
 		FColor::Orange, FColor::Purple, FColor::Red, FColor::Yellow
@@ -296,7 +327,7 @@ void UNavDbg::DrawMeshBatches(const UWorld* World, TArray<TArray<TArray<Tri*>>>&
 	for (auto& Batch : Batches) {
 		const FColor& Color = Colors[ColorIndex];
 		for (auto& Group : Batch) {
-			DrawTris(World, Group, Color);
+			DrawTris(World, Grid, Group, Color);
 		}
 		if (++ColorIndex >= 8) {
 			ColorIndex = 0;
@@ -304,7 +335,7 @@ void UNavDbg::DrawMeshBatches(const UWorld* World, TArray<TArray<TArray<Tri*>>>&
 	}
 }
 
-void UNavDbg::DrawMeshBatchGroups(const UWorld* World, TArray<TArray<TArray<Tri*>>>& Batches) {
+void UNavDbg::DrawMeshBatchGroups(const UWorld* World, const TriGrid& Grid, TArray<TArray<TArray<Tri*>>>& Batches) {
 	const FColor Colors[8] {
 		FColor::Blue, FColor::Cyan, FColor::Green, FColor::Magenta,
 		FColor::Orange, FColor::Purple, FColor::Red, FColor::Yellow
@@ -313,7 +344,7 @@ void UNavDbg::DrawMeshBatchGroups(const UWorld* World, TArray<TArray<TArray<Tri*
 	for (auto& Batch : Batches) {
 		for (auto& Group : Batch) {
 			const FColor& Color = Colors[ColorIndex];
-			DrawTris(World, Group, Color);
+			DrawTris(World, Grid, Group, Color);
 			if (++ColorIndex >= 8) {
 				ColorIndex = 0;
 			}
@@ -8,6 +8,7 @@ struct BoundingBox;
 struct UNavMesh;
 class TriGrid;
 struct VBufferPolygon;
+class ScratchArena;
 
 #define UNAV_DBG
 #define UNAV_DEV
@@ -58,21 +59,22 @@ namespace UNavDbg {
 
 	void DrawNavMeshNormals(const UWorld* World, const UNavMesh& NMesh);
 
-	void DrawTris(const UWorld* World, const TArray<Tri>& Tris, FColor Color=FColor::Red);
+	// TriVertices holds 3 per tri
+	void DrawTris(const UWorld* World, const TArray<FVector>& TriVertices, FColor Color=FColor::Red);
 	
-	void DrawTris(const UWorld* World, const TArray<Tri*>& Tris, FColor Color=FColor::Red);
+	void DrawTris(const UWorld* World, const TriGrid& Grid, const TArray<Tri*>& Tris, FColor Color=FColor::Red);
 
 	void DrawPolygons(const UWorld* World, const TArray<Polygon>& Polygons, FColor Color=FColor::Magenta);
 
-	void PrintTri(const Tri& T);
+	void PrintTri(const TriGrid& Grid, int TriIndex);
 
-	bool DoesTriMatchVertexCaptures(const Tri& T);
+	bool DoesTriMatchVertexCaptures(const TriGrid& Grid, int TriIndex);
 	
 	// to use this make sure the build configuration is on debug and set a breakpoint inside the function
-	void BreakOnVertexCaptureMatch(const Tri& T);
+	void BreakOnVertexCaptureMatch(const TriGrid& Grid, int TriIndex);
 	
 	// to use this make sure the build configuration is on debug and set a breakpoint inside the function
-	void BreakOnVertexCaptureMatch(const Tri& A, const Tri& B);
+	void BreakOnVertexCaptureMatch(const TriGrid& GridA, int TriIndexA, const TriGrid& GridB, int TriIndexB);
 	
 	void BreakOnBadNeighborFlags(const Tri& T);
 
@@ -82,9 +84,11 @@ namespace UNavDbg {
 
 	void PrintThreadSuccess(FCriticalSection* Mutex);
 
-	void DrawMeshBatches(const UWorld* World, TArray<TArray<TArray<Tri*>>>& Batches);
+	void PrintScratchArenaStats(const TArray<TriMesh*>& Group, const ScratchArena& Arena, FCriticalSection* Mutex);
+
+	void DrawMeshBatches(const UWorld* World, const TriGrid& Grid, TArray<TArray<TArray<Tri*>>>& Batches);
 	
-	void DrawMeshBatchGroups(const UWorld* World, TArray<TArray<TArray<Tri*>>>& Batches);
+	void DrawMeshBatchGroups(const UWorld* World, const TriGrid& Grid, TArray<TArray<TArray<Tri*>>>& Batches);
 
 	void PrintMeshBatches(TArray<TArray<TArray<Tri*>>>& Batches);
 
@@ -63,11 +63,11 @@ void ADraw::AddNavMesh(UNavMesh& NMesh) {
 	const auto& Grid = NMesh.Grid;
 	for (int j = 0; j < Grid.Num(); j++) {
 		Grid.GetVIndices(j, Triangle);
-		const Tri& T = Grid[j];
+		const FVector& TriNormal = Grid.GetNormal(j);
 		
 		Triangles.Append(Triangle);
 		for (int k = 0; k < Triangle.Num(); k++) {
-			Normals[Triangle[k]] += T.Normal;
+			Normals[Triangle[k]] += TriNormal;
 		}
 		Triangle.Empty(3);
 	}
@@ -1,7 +1,6 @@
 ﻿#include "Geometry.h"
 #include "Data.h"
 #include "Debug.h"
-#include "DoubleVector.h"
 #include "TriMesh.h"
 #include "Tri.h"
 #include "Polygon.h"
@@ -9,6 +8,8 @@
 #include "UNavMesh.h"
 #include "Components/BoxComponent.h"
 #include "Engine/StaticMeshActor.h"
+#include "Async/ParallelFor.h"
+#include "DoubleVector.h"
 
 namespace Geometry {
 	
@@ -16,6 +17,8 @@ namespace Geometry {
 	static constexpr float NEAR_EPSILON = 1e-2f;
 	static constexpr float GLANCE_EPSILON = 1e-4f;
 	static constexpr float NEAR_FACTOR = 1.0f + 1e-4f;
+	// tris handled by one FindIntersections() task; small enough that a single big mesh pair still spreads over cores
+	static constexpr int INTERSECTION_TASK_TRI_CT = 256;
 
 	// -----------------------------------------------------------------------------------------------------------------
 	// -------------------------------------------------------------------------------------------------------- Internal
@@ -35,17 +38,6 @@ namespace Geometry {
 			FVector( 1.0f,  1.0f,  1.0f)
 		};
 		
-		constexpr int BBoxFaceIndices[BoundingBox::FACE_CT][3] {
-			{0, 1, 2}, {0, 1, 3}, {0, 2, 3},
-			{7, 4, 5}, {7, 5, 6}, {7, 4, 6}
-		};
-
-		constexpr int BBoxEdgeIndices[BoundingBox::EDGE_CT][2] {
-			{0, 1}, {0, 2}, {1, 4}, {2, 4},
-			{3, 5}, {3, 6}, {7, 5}, {7, 6},
-			{1, 5}, {4, 7}, {2, 6}, {0, 3}
-		};
-
 		enum RAY_HIT {
 			RAY_HIT_NONE=0,
 			RAY_HIT_ATOB=1,
@@ -56,12 +48,12 @@ namespace Geometry {
 			
 			MeshHit() {}
 			
-			MeshHit(const AStaticMeshActor* _Mesh, const FVector& _Location, const FVector & _Normal, float _Distance) :
-				Mesh{_Mesh}, Location(_Location), Normal(_Normal), Distance(_Distance)
+			MeshHit(int _MeshIndex, const FVector& _Location, const FVector & _Normal, float _Distance) :
+				MeshIndex(_MeshIndex), Location(_Location), Normal(_Normal), Distance(_Distance)
 			{}
 
-			void SetData(const AStaticMeshActor* _Mesh, const FVector& Loc, const FVector& _Normal, float Dist) {
-				Mesh = _Mesh;
+			void SetData(int _MeshIndex, const FVector& Loc, const FVector& _Normal, float Dist) {
+				MeshIndex = _MeshIndex;
 				Location = Loc;
 				Normal = _Normal;
 				Distance = Dist;
@@ -75,78 +67,126 @@ namespace Geometry {
 				return A.Distance > B.Distance;
 			}
 	
-			const AStaticMeshActor* Mesh;
+			int MeshIndex; // in the meshes traced
 			FVector Location;
 			FVector Normal;
 			float Distance;
 		};
 
-		// used for counting mesh hits up to a point to check if a point lies between mesh hits.
-		// mesh data only populated only at constructor
+		// an intersection edge between tri TriIndexA of one mesh and tri TriIndexB of another; it belongs in both tris'
+		// polys, but is only added to them once every task in FindIntersections() is done
+		struct TriPairPolyEdge {
+
+			TriPairPolyEdge(int _TriIndexA, int _TriIndexB, const FVector& A, const FVector& B, uint16 TriEdgeFlags) :
+				TriIndexA(_TriIndexA), TriIndexB(_TriIndexB), Edge(A, B, TriEdgeFlags)
+			{}
+
+			int TriIndexA;
+			int TriIndexB;
+			PolyEdge Edge;
+		};
+
+		// one unit of FindIntersections() work: tris [StartIndex, EndIndex) of mesh A, against all of mesh B for the
+		// pair pass or against nothing (MeshIndexB = -1) for the tri edge pass
+		struct IntersectionTask {
+
+			IntersectionTask(int _MeshIndexA, int _MeshIndexB, int _StartIndex, int _EndIndex) :
+				MeshIndexA(_MeshIndexA), MeshIndexB(_MeshIndexB), StartIndex(_StartIndex), EndIndex(_EndIndex)
+			{}
+
+			int MeshIndexA;
+			int MeshIndexB;
+			int StartIndex;
+			int EndIndex;
+		};
+
+		// used for counting mesh hits up to a point to check if a point lies between mesh hits. Only parity matters, so
+		// each mesh is a bit, indexed by its position in the mesh list given to the constructor; hits must come from
+		// traces through that list or a prefix of it
 		struct MeshHitCounter {
 
-			// FudgeBVCt: on reset, if BoundsVolumeTMesh is in the keys, sets it to 1 instead of 0 so
-			// 'inside' becomes 'outside'
-			MeshHitCounter(const TArray<TriMesh*>& TMeshPtrs) {
+			MeshHitCounter(const TArray<TriMesh*>& TMeshPtrs) :
+				BVIndex(-1)
+			{
+				Parity.SetNumZeroed((TMeshPtrs.Num() + 63) / 64);
 				for (int i = 0; i < TMeshPtrs.Num(); i++) {
-					AStaticMeshActor* MeshActor = TMeshPtrs[i]->MeshActor;
-					MeshToCt.Add(MeshActor, 0);
-					Keys.Add(MeshActor);
-				}		
+					if (TMeshPtrs[i]->MeshActor == Data::BoundsVolumeTMesh.MeshActor) {
+						BVIndex = i;
+					}
+				}
 			}
 		
-			void Add(const AStaticMeshActor* MeshActor) {
-				MeshToCt[MeshActor] += 1;
+			void Add(int MeshIndex) {
+				Parity[MeshIndex >> 6] ^= (uint64)1 << (MeshIndex & 63);
 			}
 
-			bool AnyOdd() {
-				for (int i = 0; i < Keys.Num(); i++) {
-					if (MeshToCt[Keys[i]] % 2 == 1) {
-						return true;
-					}
+			bool AnyOdd() const {
+				uint64 Any = 0;
+				for (int i = 0; i < Parity.Num(); i++) {
+					Any |= Parity[i];
 				}
-				return false;
+				return Any != 0;
 			}
 
 			void Reset() {
-				for (int i = 0; i < Keys.Num(); i++) {
-					MeshToCt[Keys[i]] = 0;
-				}
+				FMemory::Memzero(Parity.GetData(), Parity.Num() * sizeof(uint64));
 			}
 
+			// if BoundsVolumeTMesh is one of the meshes, starts it on 1 instead of 0 so 'inside' becomes 'outside'
 			void ResetBV1() {
-				for (int i = 0; i < Keys.Num(); i++) {
-					auto Key = Keys[i];
-					if (Key == Data::BoundsVolumeTMesh.MeshActor) {
-						MeshToCt[Key] = 1;
-					}
-					else {
-						MeshToCt[Key] = 0;
-					}
+				Reset();
+				if (BVIndex != -1) {
+					Add(BVIndex);
 				}
 			}
 
 		private:
 			
-			TMap<AStaticMeshActor*, int> MeshToCt;
-			TArray<AStaticMeshActor*> Keys;
+			// one word covers groups of up to 64 meshes, which is nearly all of them
+			TArray<uint64, TInlineAllocator<1>> Parity;
+			int BVIndex;
 			
 		};
 
 		void Internal_SetBBoxAfterVertices(BoundingBox& BBox) {
-			for (int i = 0; i < BoundingBox::FACE_CT; i++) {
-				const int* SideFaceIndices = BBoxFaceIndices[i];
-				const FVector& VertA = BBox.Vertices[SideFaceIndices[0]];
-				const FVector& VertB = BBox.Vertices[SideFaceIndices[1]];
-				const FVector& VertC = BBox.Vertices[SideFaceIndices[2]];
-				BBox.FaceNormals[i] = FVector::CrossProduct(VertB - VertA, VertC - VertA).GetUnsafeNormal();
-			}
 			const FVector& RefPoint = BBox.Vertices[0];
+			int DegenerateCt = 0;
 			for (int i = 0; i < 3; i++) {
 				FVector& OverlapCheckVector = BBox.OverlapCheckVectors[i];
 				OverlapCheckVector = BBox.Vertices[i + 1] - RefPoint;
 				BBox.OverlapCheckSqMags[i] = FVector::DotProduct(OverlapCheckVector, OverlapCheckVector);
+				const float Len = FMath::Sqrt(BBox.OverlapCheckSqMags[i]);
+				BBox.HalfExtents[i] = Len * 0.5f;
+				if (Len > SMALL_NUMBER) {
+					BBox.Axes[i] = OverlapCheckVector * (1.0f / Len);
+				}
+				else {
+					BBox.Axes[i] = FVector::ZeroVector;
+					DegenerateCt++;
+				}
 			}
+			// flat boxes (planes) still need a full set of axes for the separating axis test
+			if (DegenerateCt == 1) {
+				for (int i = 0; i < 3; i++) {
+					if (BBox.Axes[i].IsZero()) {
+						BBox.Axes[i] = FVector::CrossProduct(BBox.Axes[(i + 1) % 3], BBox.Axes[(i + 2) % 3]);
+					}
+				}
+			}
+			else if (DegenerateCt > 1) {
+				const FVector Axis = DegenerateCt == 2
+					? BBox.Axes[0] + BBox.Axes[1] + BBox.Axes[2]
+					: FVector::ForwardVector;
+				FVector AxisB;
+				FVector AxisC;
+				Axis.FindBestAxisVectors(AxisB, AxisC);
+				BBox.Axes[0] = Axis;
+				BBox.Axes[1] = AxisB;
+				BBox.Axes[2] = AxisC;
+				const float Len = BBox.HalfExtents[0] + BBox.HalfExtents[1] + BBox.HalfExtents[2];
+				BBox.HalfExtents = FVector(Len, 0.0f, 0.0f);
+			}
+			BBox.Center = (BBox.Vertices[0] + BBox.Vertices[7]) * 0.5f;
 			BBox.DiagDistance = FVector::Dist(BBox.Vertices[0], BBox.Vertices[7]);
 		}
 
@@ -192,281 +232,519 @@ namespace Geometry {
 			Internal_SetBBoxAfterVertices(BBox);
 		}
 
-		FVector Internal_UnitNormal(const FVector& A, const FVector& B, const FVector& C) {
-			return FVector::CrossProduct(B - A, C - B).GetUnsafeNormal();
-		}
-
-		// Does NOT require assumption that P has been projected onto T's plane
-		// clever trick: assume the pt is inside the triangle. then, the pt makes three triangles - one with every pair
-		// of tri vertices. the sum of those areas is equal to the area of the triangle.
-		bool Internal_DoesPointTouchTri(const Tri& T, const FVector& P) {
-			// return (
-			// 	Tri::GetArea(P, T.A, T.B) + Tri::GetArea(P, T.B, T.C) + Tri::GetArea(P, T.C, T.A)
-			// 	<= T.Area * NEAR_FACTOR
-			// );
-			const FVector N1 = Internal_UnitNormal(T.A, T.B, P);	
-			const FVector N2 = Internal_UnitNormal(T.B, T.C, P);
-			if (FVector::DotProduct(N1, N2) < 1.0f - 1e-2f) {
-				return false;
-			}
-			const FVector N3 = Internal_UnitNormal(T.C, T.A, P);
-			if (FVector::DotProduct(N2, N3) < 1.0f - 1e-2f) {
-				return false;
-			}
-			return true;
-		}
+		// up to TRI_PACKET_SZ tris in structure-of-arrays form, one lane per tri, for Internal_RaycastTriPacket(); unused
+		// lanes are zeroed, which makes them degenerate so they never report a hit
+		struct TriPacket {
+			VectorRegister AX, AY, AZ;
+			VectorRegister E1X, E1Y, E1Z; // B - A
+			VectorRegister E2X, E2Y, E2Z; // C - A
+			VectorRegister NX, NY, NZ;
+		};
 
-		// does point touch this rectangular face? assumes pt has been projected onto plane with vertices.
-		// asks if the angles between the edges and the point make sense, and if the line segments of the point projected
-		// onto the edges are both shorter than the lengths of the edges.
-		bool Internal_DoesPointTouchFace(
-			const FVector& VertA,
-			const FVector& VertB,
-			const FVector& VertC,
-			const FVector& Pt
-		) {
-			const FVector FaceEdgeB = VertB - VertA;	
-			const FVector FaceEdgeC = VertC - VertA;
-			const FVector PtVec = Pt - VertA;
-			const float LenFEB = FaceEdgeB.Size() + NEAR_EPSILON;
-			const float LenFEC = FaceEdgeC.Size() + NEAR_EPSILON;
-			const float LenPVC = PtVec.Size();
-			const float CosTheta = FVector::DotProduct(PtVec, FaceEdgeB) / (LenPVC * LenFEB);
-			const float CosPhi = FVector::DotProduct(PtVec, FaceEdgeC) / (LenPVC * LenFEC);
-			return (CosTheta >= 0) && (CosPhi >= 0) && (LenPVC * CosTheta <= LenFEB) && (LenPVC * CosPhi <= LenFEC);
-		}
+		static constexpr int TRI_PACKET_SZ = 4;
+		static constexpr float DET_EPSILON = 1e-8f;
+		static constexpr float BARY_EPSILON = 1e-5f;
 
-		// does the ray hit the rectangular face provided? Omitted vertex is assumed to make the face rectangular
-		// and BAC is assumed to form a right angle
-		bool Internal_Raycast(
-			const FVector& Origin,
-			const FVector& Dir,
-			float Length,
-			const FVector& FacePtA,
-			const FVector& FacePtB,
-			const FVector& FacePtC,
-			const FVector& Normal, // could calc here, but currently precomputed for BoundingBox
-			FVector& POI,
-			float& HitDistance
-		) {
-			const FVector PVec = Origin - FacePtA;
-			const double LenOProj = DoubleVector::DotProduct(Normal, PVec);
-			if (LenOProj <= 0.0) {
-				return false;
-			}
-			const double RayNormCosTheta = DoubleVector::DotProduct(Dir, -Normal);
-			if (RayNormCosTheta <= 0.0) {
-				return false;
+		// gathers the tris at TriIndices[0, Ct) from the grid's flat arrays into a packet
+		void Internal_FillTriPacket(TriPacket& Packet, const TriGrid& Grid, const int* TriIndices, int Ct) {
+			alignas(16) float Lanes[12][TRI_PACKET_SZ] = {};
+			const FVector* Vertices = Grid.GetVertices();
+			const uint32* VIndices = Grid.GetVIndexBuffer();
+			for (int i = 0; i < Ct; i++) {
+				const int TriIndex = TriIndices[i];
+				const uint32* TriVIndices = VIndices + 3 * TriIndex;
+				const FVector& A = Vertices[TriVIndices[0]];
+				const FVector E1 = Vertices[TriVIndices[1]] - A;
+				const FVector E2 = Vertices[TriVIndices[2]] - A;
+				const FVector& N = Grid.GetNormal(TriIndex);
+				Lanes[0][i] = A.X;
+				Lanes[1][i] = A.Y;
+				Lanes[2][i] = A.Z;
+				Lanes[3][i] = E1.X;
+				Lanes[4][i] = E1.Y;
+				Lanes[5][i] = E1.Z;
+				Lanes[6][i] = E2.X;
+				Lanes[7][i] = E2.Y;
+				Lanes[8][i] = E2.Z;
+				Lanes[9][i] = N.X;
+				Lanes[10][i] = N.Y;
+				Lanes[11][i] = N.Z;
+			}
+			VectorRegister* Out = &Packet.AX;
+			for (int i = 0; i < 12; i++) {
+				Out[i] = VectorLoadAligned(Lanes[i]);
 			}
-			HitDistance = LenOProj / RayNormCosTheta;
-			if (HitDistance > Length) {
-				return false;
-			}
-			POI = Origin + Dir * HitDistance;
-			return Internal_DoesPointTouchFace(FacePtA, FacePtB, FacePtC, POI);
 		}
 
-		// thinks in triangles: the one made by the tri plane, origin -> center, origin -> projection
-		// and the one made by the tri plane, origin -> projection, origin -> ray hit. Could be faster, I'm sure.
-		// TODO: check if this could be modified to check in both directions
-		bool Internal_Raycast(
+		// Moller-Trumbore against every tri in the packet at once, for the segment Origin + Dir * t, 0 <= t <= Length.
+		// It's two-sided, so one pass covers both trace directions: bit i of the returned mask is set if tri i was hit,
+		// and bit i of FrontMask if Origin is on the side the tri's normal points to (a hit tracing from Origin;
+		// otherwise it's a hit tracing back from the other end). Like the old one-direction raycasts, a hit exactly at
+		// the origin of a trace doesn't count. HitDistances (aligned, TRI_PACKET_SZ long) are from Origin.
+		int Internal_RaycastTriPacket(
 			const FVector& Origin,
 			const FVector& Dir,
 			float Length,
-			const Tri& T,
-			FVector& POI,
-			float& HitDistance
+			const TriPacket& P,
+			float* HitDistances,
+			int& FrontMask
 		) {
-			const FVector PVec = Origin - T.A;
-			const float LenOProj = FVector::DotProduct(T.Normal, PVec);
-			if (LenOProj <= 0.0f) {
-				return false;
-			}
-			const float RayNormCosTheta = FVector::DotProduct(Dir, -T.Normal);
-			if (RayNormCosTheta <= 0.0f) {
-				return false;
-			}
-			HitDistance = LenOProj / RayNormCosTheta;
-			if (HitDistance > Length) {
-				return false;
-			}
-			POI = Origin + Dir * HitDistance;
-			return Internal_DoesPointTouchTri(T, POI);
+			const VectorRegister Zero = VectorZero();
+			const VectorRegister DX = VectorSetFloat1(Dir.X);
+			const VectorRegister DY = VectorSetFloat1(Dir.Y);
+			const VectorRegister DZ = VectorSetFloat1(Dir.Z);
+
+			// P = Dir x E2
+			const VectorRegister PX = VectorSubtract(VectorMultiply(DY, P.E2Z), VectorMultiply(DZ, P.E2Y));
+			const VectorRegister PY = VectorSubtract(VectorMultiply(DZ, P.E2X), VectorMultiply(DX, P.E2Z));
+			const VectorRegister PZ = VectorSubtract(VectorMultiply(DX, P.E2Y), VectorMultiply(DY, P.E2X));
+			const VectorRegister Det = VectorMultiplyAdd(
+				P.E1X, PX, VectorMultiplyAdd(P.E1Y, PY, VectorMultiply(P.E1Z, PZ))
+			);
+			const VectorRegister InvDet = VectorReciprocalAccurate(Det);
+
+			// S = Origin - A
+			const VectorRegister SX = VectorSubtract(VectorSetFloat1(Origin.X), P.AX);
+			const VectorRegister SY = VectorSubtract(VectorSetFloat1(Origin.Y), P.AY);
+			const VectorRegister SZ = VectorSubtract(VectorSetFloat1(Origin.Z), P.AZ);
+			const VectorRegister U = VectorMultiply(
+				VectorMultiplyAdd(SX, PX, VectorMultiplyAdd(SY, PY, VectorMultiply(SZ, PZ))), InvDet
+			);
+
+			// Q = S x E1
+			const VectorRegister QX = VectorSubtract(VectorMultiply(SY, P.E1Z), VectorMultiply(SZ, P.E1Y));
+			const VectorRegister QY = VectorSubtract(VectorMultiply(SZ, P.E1X), VectorMultiply(SX, P.E1Z));
+			const VectorRegister QZ = VectorSubtract(VectorMultiply(SX, P.E1Y), VectorMultiply(SY, P.E1X));
+			const VectorRegister V = VectorMultiply(
+				VectorMultiplyAdd(DX, QX, VectorMultiplyAdd(DY, QY, VectorMultiply(DZ, QZ))), InvDet
+			);
+			const VectorRegister T = VectorMultiply(
+				VectorMultiplyAdd(P.E2X, QX, VectorMultiplyAdd(P.E2Y, QY, VectorMultiply(P.E2Z, QZ))), InvDet
+			);
+
+			const VectorRegister NegBaryEps = VectorSetFloat1(-BARY_EPSILON);
+			const VectorRegister Len = VectorSetFloat1(Length);
+			VectorRegister Hit = VectorCompareGT(VectorAbs(Det), VectorSetFloat1(DET_EPSILON));
+			Hit = VectorBitwiseAnd(Hit, VectorCompareGE(U, NegBaryEps));
+			Hit = VectorBitwiseAnd(Hit, VectorCompareGE(V, NegBaryEps));
+			Hit = VectorBitwiseAnd(Hit, VectorCompareGE(VectorSetFloat1(1.0f + BARY_EPSILON), VectorAdd(U, V)));
+
+			// which side of the tri the origin is on comes from the stored normal, not the winding, since normals can
+			// be flipped after the grid is built
+			const VectorRegister DirDotN = VectorMultiplyAdd(
+				DX, P.NX, VectorMultiplyAdd(DY, P.NY, VectorMultiply(DZ, P.NZ))
+			);
+			const VectorRegister Front = VectorCompareGT(Zero, DirDotN);
+			const VectorRegister Back = VectorCompareGT(DirDotN, Zero);
+			// 0 < t <= Length from the front, 0 <= t < Length from the back
+			const VectorRegister InRange = VectorBitwiseOr(
+				VectorBitwiseAnd(Front, VectorBitwiseAnd(VectorCompareGT(T, Zero), VectorCompareGE(Len, T))),
+				VectorBitwiseAnd(Back, VectorBitwiseAnd(VectorCompareGE(T, Zero), VectorCompareGT(Len, T)))
+			);
+			Hit = VectorBitwiseAnd(Hit, InRange);
+
+			VectorStoreAligned(T, HitDistances);
+			FrontMask = VectorMaskBits(Front);
+			return VectorMaskBits(Hit);
 		}
-		
-		bool Internal_DoesLineSegmentIntersectBox(
+
+		// traces the segment LSA -> LSB against one tri (and back), via the packet kernel
+		RAY_HIT Internal_TriLineTrace(
 			const FVector& LSA,
 			const FVector& LSB,
-			const BoundingBox& BBox,
+			const TriGrid& Grid,
+			int TriIndex,
 			FVector& PointOfIntersection,
 			float& HitDistance
 		) {
+			TriPacket Packet;
+			Internal_FillTriPacket(Packet, Grid, &TriIndex, 1);
 			FVector Dir = LSB - LSA;
 			const float Length = Dir.Size();
 			Dir *= 1.0f / Length;
-			const FVector* Origin = &LSA;
-			// checking all lsa -> lsb first rather than alternating because: if the intersection exists, and if you do
-			// IsPointInsideBox() checks before this, checking in either direction will return a positive, so in
-			// those cases each alternating check in the opposite direction is superfluous
-			for (int j = 0; j < BoundingBox::FACE_CT; j++) {
-				const int* FaceIndices = BBoxFaceIndices[j];
-				const FVector& FaceA = BBox.Vertices[FaceIndices[0]];
-				const FVector& FaceB = BBox.Vertices[FaceIndices[1]];
-				const FVector& FaceC = BBox.Vertices[FaceIndices[2]];
-				
-				if (Internal_Raycast(
-					*Origin,
-					Dir,
-					Length,
-					FaceA,
-					FaceB,
-					FaceC,
-					BBox.FaceNormals[j],
-					PointOfIntersection,
-					HitDistance
-				)) {
-					return true;
-				}
-			}
-			Dir = -Dir;
-			Origin = &LSB;
-			for (int j = 0; j < BoundingBox::FACE_CT; j++) {
-				const int* FaceIndices = BBoxFaceIndices[j];
-				const FVector& FaceA = BBox.Vertices[FaceIndices[0]];
-				const FVector& FaceB = BBox.Vertices[FaceIndices[1]];
-				const FVector& FaceC = BBox.Vertices[FaceIndices[2]];
-				
-				if (Internal_Raycast(
-					*Origin,
-					Dir,
-					Length,
-					FaceA,
-					FaceB,
-					FaceC,
-					BBox.FaceNormals[j],
-					PointOfIntersection,
-					HitDistance
-				)) {
-					HitDistance = Length - HitDistance;
-					return true;
-				}
+			alignas(16) float HitDistances[TRI_PACKET_SZ];
+			int FrontMask;
+			if ((Internal_RaycastTriPacket(LSA, Dir, Length, Packet, HitDistances, FrontMask) & 0x1) == 0) {
+				return RAY_HIT_NONE;
+			}
+			PointOfIntersection = LSA + Dir * HitDistances[0];
+			if (FrontMask & 0x1) {
+				HitDistance = HitDistances[0];
+				return RAY_HIT_ATOB;
 			}
-			return false;
+			HitDistance = Length - HitDistances[0];
+			return RAY_HIT_BTOA;
 		}
 
-		RAY_HIT Internal_TriLineTrace(
-			const FVector& LSA,
-			const FVector& LSB,
-			const Tri& T,
-			FVector& PointOfIntersection,
-			float& HitDistance
-		) {
+		// does segment LSA -> LSB touch any tri in the packet?
+		bool Internal_DoesSegmentHitTriPacket(const FVector& LSA, const FVector& LSB, const TriPacket& Packet) {
 			FVector Dir = LSB - LSA;
 			const float Length = Dir.Size();
 			Dir *= 1.0f / Length;
-			if (Internal_Raycast(LSA, Dir, Length, T, PointOfIntersection, HitDistance)) {
-				return RAY_HIT_ATOB;
+			alignas(16) float HitDistances[TRI_PACKET_SZ];
+			int FrontMask;
+			return Internal_RaycastTriPacket(LSA, Dir, Length, Packet, HitDistances, FrontMask) != 0;
+		}
+
+		// up to TRI_PACKET_SZ tris in structure-of-arrays form for Internal_GetClosestPointsOnTriPacket(), with the
+		// edge dot products that don't depend on the query point done up front; unused lanes are zeroed
+		struct ClosestPointPacket {
+			VectorRegister AX, AY, AZ;
+			VectorRegister ABX, ABY, ABZ;
+			VectorRegister ACX, ACY, ACZ;
+			VectorRegister ABAB, ABAC, ACAC;
+		};
+
+		void Internal_FillClosestPointPacket(
+			ClosestPointPacket& Packet,
+			const TriGrid& Grid,
+			const uint32* TriIndices,
+			int Ct
+		) {
+			alignas(16) float Lanes[12][TRI_PACKET_SZ] = {};
+			const FVector* Vertices = Grid.GetVertices();
+			const uint32* VIndices = Grid.GetVIndexBuffer();
+			for (int i = 0; i < Ct; i++) {
+				const uint32* TriVIndices = VIndices + 3 * TriIndices[i];
+				const FVector& A = Vertices[TriVIndices[0]];
+				const FVector AB = Vertices[TriVIndices[1]] - A;
+				const FVector AC = Vertices[TriVIndices[2]] - A;
+				Lanes[0][i] = A.X;
+				Lanes[1][i] = A.Y;
+				Lanes[2][i] = A.Z;
+				Lanes[3][i] = AB.X;
+				Lanes[4][i] = AB.Y;
+				Lanes[5][i] = AB.Z;
+				Lanes[6][i] = AC.X;
+				Lanes[7][i] = AC.Y;
+				Lanes[8][i] = AC.Z;
+				Lanes[9][i] = FVector::DotProduct(AB, AB);
+				Lanes[10][i] = FVector::DotProduct(AB, AC);
+				Lanes[11][i] = FVector::DotProduct(AC, AC);
+			}
+			VectorRegister* Out = &Packet.AX;
+			for (int i = 0; i < 12; i++) {
+				Out[i] = VectorLoadAligned(Lanes[i]);
 			}
-			Dir = -Dir;
-			if (Internal_Raycast(LSB, Dir, Length, T, PointOfIntersection, HitDistance)) {
-				return RAY_HIT_BTOA;
+		}
+
+		// closest point on each tri in the packet to the point in the same lane of PX, PY, PZ. Ericson's Voronoi region
+		// test (Real-Time Collision Detection 5.1.5) without branches: every region's answer is worked out as barycentric
+		// coordinates V, W (the point is A + V * AB + W * AC), then picked per lane, the interior first and the vertex
+		// regions last, so that where region tests overlap the same one wins as in the scalar version. Divisions by
+		// zero only happen in lanes whose region isn't picked, except for zero-area tris, as in the scalar version
+		void Internal_GetClosestPointsOnTriPacket(
+			const VectorRegister& PX,
+			const VectorRegister& PY,
+			const VectorRegister& PZ,
+			const ClosestPointPacket& P,
+			VectorRegister& OutX,
+			VectorRegister& OutY,
+			VectorRegister& OutZ
+		) {
+			const VectorRegister Zero = VectorZero();
+			const VectorRegister One = VectorOne();
+			const VectorRegister APX = VectorSubtract(PX, P.AX);
+			const VectorRegister APY = VectorSubtract(PY, P.AY);
+			const VectorRegister APZ = VectorSubtract(PZ, P.AZ);
+			// AB . AP, AC . AP, then the same against BP = AP - AB and CP = AP - AC
+			const VectorRegister D1 = VectorMultiplyAdd(
+				P.ABX, APX, VectorMultiplyAdd(P.ABY, APY, VectorMultiply(P.ABZ, APZ))
+			);
+			const VectorRegister D2 = VectorMultiplyAdd(
+				P.ACX, APX, VectorMultiplyAdd(P.ACY, APY, VectorMultiply(P.ACZ, APZ))
+			);
+			const VectorRegister D3 = VectorSubtract(D1, P.ABAB);
+			const VectorRegister D4 = VectorSubtract(D2, P.ABAC);
+			const VectorRegister D5 = VectorSubtract(D1, P.ABAC);
+			const VectorRegister D6 = VectorSubtract(D2, P.ACAC);
+			const VectorRegister VC = VectorSubtract(VectorMultiply(D1, D4), VectorMultiply(D3, D2));
+			const VectorRegister VB = VectorSubtract(VectorMultiply(D5, D2), VectorMultiply(D1, D6));
+			const VectorRegister VA = VectorSubtract(VectorMultiply(D3, D6), VectorMultiply(D5, D4));
+			const VectorRegister D43 = VectorSubtract(D4, D3);
+			const VectorRegister D56 = VectorSubtract(D5, D6);
+
+			// interior
+			const VectorRegister InvDenom = VectorReciprocalAccurate(VectorAdd(VA, VectorAdd(VB, VC)));
+			VectorRegister V = VectorMultiply(VB, InvDenom);
+			VectorRegister W = VectorMultiply(VC, InvDenom);
+			// edge BC
+			const VectorRegister InBC = VectorBitwiseAnd(
+				VectorCompareGE(Zero, VA), VectorBitwiseAnd(VectorCompareGE(D43, Zero), VectorCompareGE(D56, Zero))
+			);
+			const VectorRegister WBC = VectorMultiply(D43, VectorReciprocalAccurate(VectorAdd(D43, D56)));
+			V = VectorSelect(InBC, VectorSubtract(One, WBC), V);
+			W = VectorSelect(InBC, WBC, W);
+			// edge AC
+			const VectorRegister InAC = VectorBitwiseAnd(
+				VectorCompareGE(Zero, VB), VectorBitwiseAnd(VectorCompareGE(D2, Zero), VectorCompareGE(Zero, D6))
+			);
+			V = VectorSelect(InAC, Zero, V);
+			W = VectorSelect(InAC, VectorMultiply(D2, VectorReciprocalAccurate(VectorSubtract(D2, D6))), W);
+			// vertex C
+			const VectorRegister InC = VectorBitwiseAnd(VectorCompareGE(D6, Zero), VectorCompareGE(D6, D5));
+			V = VectorSelect(InC, Zero, V);
+			W = VectorSelect(InC, One, W);
+			// edge AB
+			const VectorRegister InAB = VectorBitwiseAnd(
+				VectorCompareGE(Zero, VC), VectorBitwiseAnd(VectorCompareGE(D1, Zero), VectorCompareGE(Zero, D3))
+			);
+			V = VectorSelect(InAB, VectorMultiply(D1, VectorReciprocalAccurate(VectorSubtract(D1, D3))), V);
+			W = VectorSelect(InAB, Zero, W);
+			// vertex B
+			const VectorRegister InB = VectorBitwiseAnd(VectorCompareGE(D3, Zero), VectorCompareGE(D3, D4));
+			V = VectorSelect(InB, One, V);
+			W = VectorSelect(InB, Zero, W);
+			// vertex A
+			const VectorRegister InA = VectorBitwiseAnd(VectorCompareGE(Zero, D1), VectorCompareGE(Zero, D2));
+			V = VectorSelect(InA, Zero, V);
+			W = VectorSelect(InA, Zero, W);
+
+			OutX = VectorMultiplyAdd(P.ABX, V, VectorMultiplyAdd(P.ACX, W, P.AX));
+			OutY = VectorMultiplyAdd(P.ABY, V, VectorMultiplyAdd(P.ACY, W, P.AY));
+			OutZ = VectorMultiplyAdd(P.ABZ, V, VectorMultiplyAdd(P.ACZ, W, P.AZ));
+		}
+
+		// closest points on Ct tris; lanes are points broadcast from Points[i * PointStride]
+		void Internal_GetClosestPointsOnTris(
+			const TriGrid& Grid,
+			const FVector* Points,
+			int PointStride,
+			const uint32* TriIndices,
+			int Ct,
+			FVector* ClosestPoints
+		) {
+			ClosestPointPacket Packet;
+			alignas(16) float Lanes[3][TRI_PACKET_SZ] = {};
+			for (int i = 0; i < Ct; i += TRI_PACKET_SZ) {
+				const int PacketCt = FMath::Min(TRI_PACKET_SZ, Ct - i);
+				Internal_FillClosestPointPacket(Packet, Grid, TriIndices + i, PacketCt);
+				for (int j = 0; j < PacketCt; j++) {
+					const FVector& Point = Points[(i + j) * PointStride];
+					Lanes[0][j] = Point.X;
+					Lanes[1][j] = Point.Y;
+					Lanes[2][j] = Point.Z;
+				}
+				VectorRegister OutX, OutY, OutZ;
+				Internal_GetClosestPointsOnTriPacket(
+					VectorLoadAligned(Lanes[0]),
+					VectorLoadAligned(Lanes[1]),
+					VectorLoadAligned(Lanes[2]),
+					Packet,
+					OutX,
+					OutY,
+					OutZ
+				);
+				VectorStoreAligned(OutX, Lanes[0]);
+				VectorStoreAligned(OutY, Lanes[1]);
+				VectorStoreAligned(OutZ, Lanes[2]);
+				for (int j = 0; j < PacketCt; j++) {
+					ClosestPoints[i + j] = FVector(Lanes[0][j], Lanes[1][j], Lanes[2][j]);
+				}
 			}
-			return RAY_HIT_NONE;
 		}
 
-		bool Internal_DoBoundingBoxesIntersect(const BoundingBox& BBoxA, const BoundingBox& BBoxB, bool BothWays=false) {
-			const BoundingBox* EdgesBoxPtr = &BBoxA;
-			const BoundingBox* FacesBoxPtr = &BBoxB;
-			FVector POI;
-			float HitDist;
-			for (int i = 0; i < 2; i++) {
-				const BoundingBox& EdgesBox = *EdgesBoxPtr;
-				const BoundingBox& FacesBox = *FacesBoxPtr;
-				for (int j = 0; j < BoundingBox::EDGE_CT; j++) {
-					const int* EdgeIndices = BBoxEdgeIndices[j];
-					const FVector EdgeA = EdgesBox.Vertices[EdgeIndices[0]];
-					const FVector EdgeB = EdgesBox.Vertices[EdgeIndices[1]];
-					if (Internal_DoesLineSegmentIntersectBox(
-						EdgeA, EdgeB, FacesBox, POI, HitDist
-					)) {
-						return true;
-					}
-					// if a test for whether either has points inside each other has already been done,
-					// this is unnecessary, since an intersection would only occur if an edge passed through a box,
-					// making that edge checkable in either direction
-					if (
-						BothWays 
-						&& Internal_DoesLineSegmentIntersectBox(
-							EdgeB, EdgeA, FacesBox, POI, HitDist
-					)) {
-						return true;
-					}
+		// up to BOX_PACKET_SZ boxes in structure-of-arrays form, for Internal_GetBoxPacketOverlaps()
+		struct BoxPacket {
+			VectorRegister CX, CY, CZ;
+			VectorRegister AX[3], AY[3], AZ[3];
+			VectorRegister E[3];
+		};
+		
+		static constexpr int BOX_PACKET_SZ = 4;
+		// added to the rotation terms so nearly parallel edges don't produce a bogus separating cross product axis
+		static constexpr float SAT_EPSILON = 1e-5f;
+		
+		void Internal_FillBoxPacket(BoxPacket& Packet, const BoundingBox* const* Boxes, int Ct) {
+			alignas(16) float Lanes[15][BOX_PACKET_SZ] = {};
+			for (int i = 0; i < Ct; i++) {
+				const BoundingBox& BBox = *Boxes[i];
+				Lanes[0][i] = BBox.Center.X;
+				Lanes[1][i] = BBox.Center.Y;
+				Lanes[2][i] = BBox.Center.Z;
+				for (int j = 0; j < 3; j++) {
+					Lanes[3 + j][i] = BBox.Axes[j].X;
+					Lanes[6 + j][i] = BBox.Axes[j].Y;
+					Lanes[9 + j][i] = BBox.Axes[j].Z;
+					Lanes[12 + j][i] = BBox.HalfExtents[j];
 				}
-				EdgesBoxPtr = &BBoxB;
-				FacesBoxPtr = &BBoxA;
 			}
-			return false;
+			VectorRegister* Out = &Packet.CX;
+			for (int i = 0; i < 15; i++) {
+				Out[i] = VectorLoadAligned(Lanes[i]);
+			}
+		}
+
+		// separating axis test of BBox against every box in the packet: the 3 face axes of each box, then the 9 cross
+		// products of their edges. Returns a lane mask of the boxes that overlap BBox; touching isn't overlapping
+		int Internal_GetBoxPacketOverlaps(const BoundingBox& BBox, const BoxPacket& P) {
+			// distance between centers, and the packet boxes' axes, in BBox's frame
+			const VectorRegister TX = VectorSubtract(P.CX, VectorSetFloat1(BBox.Center.X));
+			const VectorRegister TY = VectorSubtract(P.CY, VectorSetFloat1(BBox.Center.Y));
+			const VectorRegister TZ = VectorSubtract(P.CZ, VectorSetFloat1(BBox.Center.Z));
+			const VectorRegister Eps = VectorSetFloat1(SAT_EPSILON);
+			VectorRegister T[3];
+			VectorRegister EA[3];
+			VectorRegister R[3][3];
+			VectorRegister AbsR[3][3];
+			for (int i = 0; i < 3; i++) {
+				const VectorRegister AiX = VectorSetFloat1(BBox.Axes[i].X);
+				const VectorRegister AiY = VectorSetFloat1(BBox.Axes[i].Y);
+				const VectorRegister AiZ = VectorSetFloat1(BBox.Axes[i].Z);
+				T[i] = VectorMultiplyAdd(TX, AiX, VectorMultiplyAdd(TY, AiY, VectorMultiply(TZ, AiZ)));
+				EA[i] = VectorSetFloat1(BBox.HalfExtents[i]);
+				for (int j = 0; j < 3; j++) {
+					R[i][j] = VectorMultiplyAdd(AiX, P.AX[j], VectorMultiplyAdd(AiY, P.AY[j], VectorMultiply(AiZ, P.AZ[j])));
+					AbsR[i][j] = VectorAdd(VectorAbs(R[i][j]), Eps);
+				}
+			}
+
+			VectorRegister Separated = VectorZero();
+			// BBox's axes
+			for (int i = 0; i < 3; i++) {
+				const VectorRegister RB = VectorMultiplyAdd(
+					P.E[0], AbsR[i][0], VectorMultiplyAdd(P.E[1], AbsR[i][1], VectorMultiply(P.E[2], AbsR[i][2]))
+				);
+				Separated = VectorBitwiseOr(Separated, VectorCompareGE(VectorAbs(T[i]), VectorAdd(EA[i], RB)));
+			}
+			// the packet boxes' axes
+			for (int j = 0; j < 3; j++) {
+				const VectorRegister RA = VectorMultiplyAdd(
+					EA[0], AbsR[0][j], VectorMultiplyAdd(EA[1], AbsR[1][j], VectorMultiply(EA[2], AbsR[2][j]))
+				);
+				const VectorRegister Proj = VectorMultiplyAdd(
+					T[0], R[0][j], VectorMultiplyAdd(T[1], R[1][j], VectorMultiply(T[2], R[2][j]))
+				);
+				Separated = VectorBitwiseOr(Separated, VectorCompareGE(VectorAbs(Proj), VectorAdd(RA, P.E[j])));
+			}
+			if (VectorMaskBits(Separated) == 0xf) {
+				return 0;
+			}
+			// BBox axis i x packet axis j
+			for (int i = 0; i < 3; i++) {
+				const int I1 = (i + 1) % 3;
+				const int I2 = (i + 2) % 3;
+				for (int j = 0; j < 3; j++) {
+					const int J1 = (j + 1) % 3;
+					const int J2 = (j + 2) % 3;
+					const VectorRegister RA = VectorMultiplyAdd(EA[I1], AbsR[I2][j], VectorMultiply(EA[I2], AbsR[I1][j]));
+					const VectorRegister RB = VectorMultiplyAdd(P.E[J1], AbsR[i][J2], VectorMultiply(P.E[J2], AbsR[i][J1]));
+					const VectorRegister Proj = VectorSubtract(VectorMultiply(T[I2], R[I1][j]), VectorMultiply(T[I1], R[I2][j]));
+					Separated = VectorBitwiseOr(Separated, VectorCompareGE(VectorAbs(Proj), VectorAdd(RA, RB)));
+				}
+			}
+			return ~VectorMaskBits(Separated) & 0xf;
 		}
 
 		bool Internal_DoTriMeshesIntersect(const TriMesh& TMeshA, const TriMesh& TMeshB) {
 			const auto& TMeshATris = TMeshA.Grid;
 			const auto& TMeshBTris = TMeshB.Grid;
-			const int TMeshBTriCt = TMeshBTris.Num();
-			FVector POI;
-			float HitDistance;
+			if (TMeshA.BVH.Num() == 0 || TMeshB.BVH.Num() == 0) {
+				return false;
+			}
+			const TriBVHNode& RootB = TMeshB.BVH.GetRoot();
+			TriPacket T0Packet;
+			TriPacket T1Packet;
+			TArray<int> Candidates;
 			for (int i = 0; i < TMeshATris.Num(); i++) {
-				const Tri& T0 = TMeshATris[i];
-				for (int j = 0; j < TMeshBTriCt; j++) {
-					const Tri& T1 = TMeshBTris[j];
-					// checking if it's possible they could intersect
-					const float DistSq = FVector::DistSquared(T0.A, T1.A);
+				FVector T0Min, T0Max;
+				TMeshATris.GetBounds(i, T0Min, T0Max);
+				if (
+					T0Min.X > RootB.Max.X || T0Max.X < RootB.Min.X
+					|| T0Min.Y > RootB.Max.Y || T0Max.Y < RootB.Min.Y
+					|| T0Min.Z > RootB.Max.Z || T0Max.Z < RootB.Min.Z
+				) {
+					continue;
+				}
+				// only tris of B whose bounds overlap T0's can intersect it
+				Candidates.Reset();
+				TMeshB.BVH.QueryBox(T0Min, T0Max, Candidates);
+				if (Candidates.Num() == 0) {
+					continue;
+				}
+				Internal_FillTriPacket(T0Packet, TMeshATris, &i, 1);
+				const FVector& T0A = TMeshATris.GetA(i);
+				const FVector& T0B = TMeshATris.GetB(i);
+				const FVector& T0C = TMeshATris.GetC(i);
+				for (int j = 0; j < Candidates.Num(); j += TRI_PACKET_SZ) {
+					const int PacketCt = FMath::Min(TRI_PACKET_SZ, Candidates.Num() - j);
+					Internal_FillTriPacket(T1Packet, TMeshBTris, &Candidates[j], PacketCt);
 					if (
-						(DistSq < T0.LongestSidelenSq + T1.LongestSidelenSq)
-						&& (
-							Internal_TriLineTrace(T0.A, T0.B, T1, POI, HitDistance)
-							|| Internal_TriLineTrace(T0.B, T0.C, T1, POI, HitDistance)
-							|| Internal_TriLineTrace(T0.C, T0.A, T1, POI, HitDistance)
-							|| Internal_TriLineTrace(T1.A, T1.B, T0, POI, HitDistance)
-							|| Internal_TriLineTrace(T1.B, T1.C, T0, POI, HitDistance)
-							|| Internal_TriLineTrace(T1.C, T1.A, T0, POI, HitDistance)
-						)
+						Internal_DoesSegmentHitTriPacket(T0A, T0B, T1Packet)
+						|| Internal_DoesSegmentHitTriPacket(T0B, T0C, T1Packet)
+						|| Internal_DoesSegmentHitTriPacket(T0C, T0A, T1Packet)
 					) {
 						return true;
 					}
+					for (int k = 0; k < PacketCt; k++) {
+						const int T1Index = Candidates[j + k];
+						const FVector& T1A = TMeshBTris.GetA(T1Index);
+						const FVector& T1B = TMeshBTris.GetB(T1Index);
+						const FVector& T1C = TMeshBTris.GetC(T1Index);
+						if (
+							Internal_DoesSegmentHitTriPacket(T1A, T1B, T0Packet)
+							|| Internal_DoesSegmentHitTriPacket(T1B, T1C, T0Packet)
+							|| Internal_DoesSegmentHitTriPacket(T1C, T1A, T0Packet)
+						) {
+							return true;
+						}
+					}
 				}
 			}
 			return false;
 		}
-		
+
+		// traces TMesh both ways between TrStart and TrEnd in one pass, testing only tris the mesh's BVH says the segment
+		// reaches, TRI_PACKET_SZ at a time
+		void Internal_LineTraceThroughMesh(
+			const FVector& TrStart,
+			const FVector& TrEnd,
+			const FVector& Dir,
+			float Length,
+			const TriMesh& TMesh,
+			int MeshIndex,
+			TArray<int>& Candidates,
+			TArray<MeshHit>& MHits
+		) {
+			const TriGrid& Grid = TMesh.Grid;
+			Candidates.Reset();
+			TMesh.BVH.QuerySegment(TrStart, TrEnd, Candidates);
+			TriPacket Packet;
+			alignas(16) float HitDistances[TRI_PACKET_SZ];
+			int FrontMask;
+			for (int i = 0; i < Candidates.Num(); i += TRI_PACKET_SZ) {
+				const int PacketCt = FMath::Min(TRI_PACKET_SZ, Candidates.Num() - i);
+				Internal_FillTriPacket(Packet, Grid, &Candidates[i], PacketCt);
+				const int HitMask = Internal_RaycastTriPacket(TrStart, Dir, Length, Packet, HitDistances, FrontMask);
+				if (HitMask == 0) {
+					continue;
+				}
+				for (int j = 0; j < PacketCt; j++) {
+					if (HitMask & (1 << j)) {
+						// a hit from either end is the same distance from TrStart
+						const float HitDistance = HitDistances[j];
+						MHits.Add(MeshHit(
+							MeshIndex, TrStart + Dir * HitDistance, Grid.GetNormal(Candidates[i + j]), HitDistance
+						));
+					}
+				}
+			}
+		}
 
 		// equivalent of LineTraceMulti, but targets only provided TriMeshes, goes both directions, and doesn't
-		// ignore an actor after one overlap/hit. currently significantly slower but has the needed features.
+		// ignore an actor after one overlap/hit.
 		void Internal_LineTraceThrough(
 			const FVector& TrStart,
 			const FVector& TrEnd,
 			const TArray<TriMesh*>& TriMeshes,
 			TArray<MeshHit>& MHits
 		) {
-			const float TraceDistance = FVector::Dist(TrStart, TrEnd);
-			float HitDistance;
-			FVector PointOfIntersection;
 			FVector Dir = TrEnd - TrStart;
 			const float Length = Dir.Size();
 			Dir *= 1 / Length;
-			const FVector OppDir = -Dir;
-			for (const TriMesh* TMesh : TriMeshes) {
-				const AStaticMeshActor* MeshActor = TMesh->MeshActor;
-				const auto& Tris = TMesh->Grid;
-				for (int i = 0; i < Tris.Num(); i++) {
-					const Tri& T = Tris[i];
-					if (Internal_Raycast(TrStart, Dir, Length, T, PointOfIntersection, HitDistance)) {
-						MHits.Add(MeshHit(MeshActor, PointOfIntersection, T.Normal, HitDistance));
-					}
-					if (Internal_Raycast(TrEnd, OppDir, Length, T, PointOfIntersection, HitDistance)) {
-						HitDistance = TraceDistance - HitDistance;
-						MHits.Add(MeshHit(MeshActor, PointOfIntersection, T.Normal, HitDistance));
-					}
-				}
+			TArray<int> Candidates;
+			for (int i = 0; i < TriMeshes.Num(); i++) {
+				Internal_LineTraceThroughMesh(TrStart, TrEnd, Dir, Length, *TriMeshes[i], i, Candidates, MHits);
 			}
 		}
 		
@@ -477,26 +755,12 @@ namespace Geometry {
 			const TArrayView<TriMesh*>& TriMeshes,
 			TArray<MeshHit>& MHits
 		) {
-			const float TraceDistance = FVector::Dist(TrStart, TrEnd);
-			float HitDistance;
-			FVector PointOfIntersection;
 			FVector Dir = TrEnd - TrStart;
 			const float Length = Dir.Size();
 			Dir *= 1 / Length;
-			const FVector OppDir = -Dir;
-			for (const TriMesh* TMesh : TriMeshes) {
-				const AStaticMeshActor* MeshActor = TMesh->MeshActor;
-				const auto& Tris = TMesh->Grid;
-				for (int i = 0; i < Tris.Num(); i++) {
-					const Tri& T = Tris[i];
-					if (Internal_Raycast(TrStart, Dir, Length, T, PointOfIntersection, HitDistance)) {
-						MHits.Add(MeshHit(MeshActor, PointOfIntersection, T.Normal, HitDistance));
-					}
-					if (Internal_Raycast(TrEnd, OppDir, Length, T, PointOfIntersection, HitDistance)) {
-						HitDistance = TraceDistance - HitDistance;
-						MHits.Add(MeshHit(MeshActor, PointOfIntersection, T.Normal, HitDistance));
-					}
-				}
+			TArray<int> Candidates;
+			for (int i = 0; i < TriMeshes.Num(); i++) {
+				Internal_LineTraceThroughMesh(TrStart, TrEnd, Dir, Length, *TriMeshes[i], i, Candidates, MHits);
 			}
 		}
 
@@ -518,7 +782,7 @@ namespace Geometry {
 			// count through sorted mesh hits
 			MHitCtr.Reset();
 			for (int i = 0; i < MHits.Num(); i++) {
-				MHitCtr.Add(MHits[i].Mesh);
+				MHitCtr.Add(MHits[i].MeshIndex);
 			}
 			// once we've gone to the point, any odd mesh hit cts mean pt is enclosed
 			return MHitCtr.AnyOdd();
@@ -533,7 +797,7 @@ namespace Geometry {
 			const FVector& A,
 			const FVector& B,
 			const TArray<TriMesh*>& OtherMeshes,
-			TArray<FVector>& ObscuredLocations,
+			TScratchArray<FVector>& ObscuredLocations,
 			float BBoxDiagDistance,
 			MeshHitCounter& MHitCtr,
 			bool BVIntersection=false
@@ -569,7 +833,7 @@ namespace Geometry {
 						if (MHitCtr.AnyOdd()) {
 							// note that A is inside a mesh
 							AEnclosed = true;
-							MHitCtr.Add(MHit.Mesh);
+							MHitCtr.Add(MHit.MeshIndex);
 							if (MHitCtr.AnyOdd()) {
 								CurrentlyInsideMesh = true;
 							}
@@ -579,19 +843,19 @@ namespace Geometry {
 						}
 						else {
 							// hits are all even
-							MHitCtr.Add(MHit.Mesh);
+							MHitCtr.Add(MHit.MeshIndex);
 							// must now be odd: if hits were even, adding another hit will definitely make a count odd
 							CurrentlyInsideMesh = true;
 							ObscuredLocations.Add(MHit.Location);	
 						}
 					}
 					else {
-						MHitCtr.Add(MHit.Mesh);
+						MHitCtr.Add(MHit.MeshIndex);
 					}
 				}
 				else {
 					// keep track of any distance from pt A where we pass in or out of all other meshes
-					MHitCtr.Add(MHit.Mesh);
+					MHitCtr.Add(MHit.MeshIndex);
 					if (CurrentlyInsideMesh) {
 						if (!MHitCtr.AnyOdd()) {
 							ObscuredLocations.Add(MHit.Location);	
@@ -613,67 +877,76 @@ namespace Geometry {
 		
 		// params should be set to complex and to ignore the mesh of the given tri; does NOT clear flags beforehand
 		bool Internal_IsTriObscured(
-			Tri& T,
+			TriGrid& Grid,
+			int TriIndex,
 			const TArrayView<TriMesh*>& OtherMeshes,
 			float MinZ,
 			MeshHitCounter& MHitCtr
 		) {
-			if (Internal_IsPointObscured(T.A, OtherMeshes, MinZ, MHitCtr)) {
+			Tri& T = Grid[TriIndex];
+			if (Internal_IsPointObscured(Grid.GetA(TriIndex), OtherMeshes, MinZ, MHitCtr)) {
 				T.SetAObscured();
 			}
-			if (Internal_IsPointObscured(T.B, OtherMeshes, MinZ, MHitCtr)) {
+			if (Internal_IsPointObscured(Grid.GetB(TriIndex), OtherMeshes, MinZ, MHitCtr)) {
 				T.SetBObscured();
 			}
-			if (Internal_IsPointObscured(T.C, OtherMeshes, MinZ, MHitCtr)) {
+			if (Internal_IsPointObscured(Grid.GetC(TriIndex), OtherMeshes, MinZ, MHitCtr)) {
 				T.SetCObscured();
 			}
 			return T.AnyObscured();
 		}
 
-		// if exists, find an intersection between tris, add PolyEdge to both polys
+		// if exists, find an intersection between tris, add it to Edges
 		// NOTE: NOT using flags! (since they're currently unused)
 		bool Internal_GetTriPairPolyEdge(
-			const Tri& T0,
-			const Tri& T1,
-			UnstructuredPolygon& PolyA,
-			UnstructuredPolygon& PolyB
+			const TriGrid& Grid0,
+			int TriIndex0,
+			const TriGrid& Grid1,
+			int TriIndex1,
+			TArray<TriPairPolyEdge>& Edges
 		) {
-			
+			const FVector& T0A = Grid0.GetA(TriIndex0);
+			const FVector& T0B = Grid0.GetB(TriIndex0);
+			const FVector& T0C = Grid0.GetC(TriIndex0);
+			const FVector& T1A = Grid1.GetA(TriIndex1);
+			const FVector& T1B = Grid1.GetB(TriIndex1);
+			const FVector& T1C = Grid1.GetC(TriIndex1);
+
 			FVector PointOfIntersection;
 			FVector TruePOI[2];
 			int HitCt = 0;
 			uint16 TriEdgeFlags = 0x0;
 			float HitDistance;
 			
-			if (Internal_TriLineTrace(T0.A, T0.B, T1, PointOfIntersection, HitDistance)) {
+			if (Internal_TriLineTrace(T0A, T0B, Grid1, TriIndex1, PointOfIntersection, HitDistance)) {
 				TruePOI[HitCt] = PointOfIntersection;
 				++HitCt;
 			}
-			if (Internal_TriLineTrace(T0.B, T0.C, T1, PointOfIntersection, HitDistance)) {
+			if (Internal_TriLineTrace(T0B, T0C, Grid1, TriIndex1, PointOfIntersection, HitDistance)) {
 				TruePOI[HitCt] = PointOfIntersection;
 				if (++HitCt == 2) {
 					goto HIT_CT_2;
 				}
 			}
-			if (Internal_TriLineTrace(T0.C, T0.A, T1, PointOfIntersection, HitDistance)) {
+			if (Internal_TriLineTrace(T0C, T0A, Grid1, TriIndex1, PointOfIntersection, HitDistance)) {
 				TruePOI[HitCt] = PointOfIntersection;
 				if (++HitCt == 2) {
 					goto HIT_CT_2;
 				}
 			}
-			if(Internal_TriLineTrace(T1.A, T1.B, T0, PointOfIntersection, HitDistance)) {
+			if(Internal_TriLineTrace(T1A, T1B, Grid0, TriIndex0, PointOfIntersection, HitDistance)) {
 				TruePOI[HitCt] = PointOfIntersection;
 				if (++HitCt == 2) {
 					goto HIT_CT_2;
 				}
 			}
-			if(Internal_TriLineTrace(T1.B, T1.C, T0, PointOfIntersection, HitDistance)) {
+			if(Internal_TriLineTrace(T1B, T1C, Grid0, TriIndex0, PointOfIntersection, HitDistance)) {
 				TruePOI[HitCt] = PointOfIntersection;
 				if (++HitCt == 2) {
 					goto HIT_CT_2;
 				}
 			}
-			if(Internal_TriLineTrace(T1.C, T1.A, T0, PointOfIntersection, HitDistance)) {
+			if(Internal_TriLineTrace(T1C, T1A, Grid0, TriIndex0, PointOfIntersection, HitDistance)) {
 				TruePOI[HitCt] = PointOfIntersection;
 				if (++HitCt == 2) {
 					goto HIT_CT_2;
@@ -687,87 +960,88 @@ namespace Geometry {
 			// - two of T1's edges intersect T0's center
 			HIT_CT_2:
 			// could be using refs here, so polyedge could just store refs
-			const PolyEdge P(TruePOI[0], TruePOI[1], TriEdgeFlags);
-			PolyA.Edges.Add(P);
-			PolyB.Edges.Add(P);
+			Edges.Add(TriPairPolyEdge(TriIndex0, TriIndex1, TruePOI[0], TruePOI[1], TriEdgeFlags));
 			return true;
 		}
 
 		// finds intersections between triangles on meshes, creating PolyEdges for use in building polygons
+		// only looks at tris [StartIndex, EndIndex) of A, and writes nothing but Edges, so ranges can run in parallel
 		void Internal_FindPolyEdges(
 			const TriMesh& TMeshA,
 			const TriMesh& TMeshB,
 			const TArray<TriMesh*>& OtherMeshes,
-			TArray<UnstructuredPolygon>& UPolysA,
-			TArray<UnstructuredPolygon>& UPolysB,
+			int StartIndex,
+			int EndIndex,
+			TArray<TriPairPolyEdge>& Edges,
 			const float BBoxDiagDist
 		) {
 			const auto& TrisA = TMeshA.Grid;
 			const auto& TrisB = TMeshB.Grid;
 			MeshHitCounter MHitCtr(OtherMeshes);
+			TArray<int> Candidates;
 			
-			for (int i = 0; i < TrisA.Num(); i++) {
+			for (int i = StartIndex; i < EndIndex; i++) {
 				const Tri& T0 = TrisA[i];
 				if (T0.IsCull()) {
 					continue;
 				}
 				
-				UnstructuredPolygon& PolyA = UPolysA[i];
-				for (int j = 0; j < TrisB.Num(); j++) {
+				// only tris of B whose bounds overlap T0's can intersect it; sorted so edges are added in the same
+				// order as a full scan would add them
+				Candidates.Reset();
+				FVector T0Min, T0Max;
+				TrisA.GetBounds(i, T0Min, T0Max);
+				TMeshB.BVH.QueryBox(T0Min, T0Max, Candidates);
+				Candidates.Sort();
+				for (int k = 0; k < Candidates.Num(); k++) {
+					const int j = Candidates[k];
 					const Tri& T1 = TrisB[j];
 					if (T1.IsCull()) {
 						continue;
 					}
 					
-					const float DistSq = FVector::DistSquared(T0.A, T1.A);
-					if (DistSq < 0.5f * (T0.Area * T1.Area)) {
-						UnstructuredPolygon& PolyB = UPolysB[j];
-						
-						// if an intersection between these triangles exists, put it in both polys
-						if (Internal_GetTriPairPolyEdge(T0, T1, PolyA, PolyB)) {
-							PolyEdge& PolyEdge0 = PolyA.Edges.Last();
-							PolyEdge& PolyEdge1 = PolyB.Edges.Last();
-
-							// check where the edge line segment is inside and outside all other meshes to help
-							// with polygon creation
-							const bool AEnclosed = Internal_GetObscuredDistances(
-								PolyEdge0.A,
-								PolyEdge0.B,
-								OtherMeshes,
-								PolyEdge0.ObscuredLocations,
-								BBoxDiagDist,
-								MHitCtr
-							);
-							if (AEnclosed) {
-								PolyEdge0.SetAEnclosed();
-								PolyEdge1.SetAEnclosed();
-								// if A is enclosed and the inside-outside distance point ct is even, B is also enclosed
-								if (PolyEdge0.ObscuredLocations.Num() % 2 == 0) {
-									PolyEdge0.SetBEnclosed();
-									PolyEdge1.SetBEnclosed();
-								}
-							}
-							else if (PolyEdge0.ObscuredLocations.Num() % 2 == 1) {
-								// if A is not enclosed and the distance point ct is odd, B is enclosed	
+					// if an intersection between these triangles exists, it goes in both polys
+					if (Internal_GetTriPairPolyEdge(TrisA, i, TrisB, j, Edges)) {
+						PolyEdge& PolyEdge0 = Edges.Last().Edge;
+
+						// check where the edge line segment is inside and outside all other meshes to help
+						// with polygon creation
+						const bool AEnclosed = Internal_GetObscuredDistances(
+							PolyEdge0.A,
+							PolyEdge0.B,
+							OtherMeshes,
+							PolyEdge0.ObscuredLocations,
+							BBoxDiagDist,
+							MHitCtr
+						);
+						if (AEnclosed) {
+							PolyEdge0.SetAEnclosed();
+							// if A is enclosed and the inside-outside distance point ct is even, B is also enclosed
+							if (PolyEdge0.ObscuredLocations.Num() % 2 == 0) {
 								PolyEdge0.SetBEnclosed();
-								PolyEdge1.SetBEnclosed();
 							}
-							PolyEdge1.ObscuredLocations = PolyEdge0.ObscuredLocations;
+						}
+						else if (PolyEdge0.ObscuredLocations.Num() % 2 == 1) {
+							// if A is not enclosed and the distance point ct is odd, B is enclosed	
+							PolyEdge0.SetBEnclosed();
 						}
 					}
 				}
 			}
 		}
 
+		// only touches tris [StartIndex, EndIndex) and their polys, so ranges can run in parallel
 		void Internal_PopulatePolyEdgesFromTriEdges(
-			const TriMesh& TMesh,
+			TriMesh& TMesh,
 			TArray<TriMesh*>& OtherMeshes,
 			TArray<UnstructuredPolygon>& UPolys,
+			int StartIndex,
+			int EndIndex,
 			float BBoxDiagDistance,
 			float MinZ
 		) {
 			MeshHitCounter MHitCtr(OtherMeshes);
-			const auto& TriGrid = TMesh.Grid;
+			auto& TriGrid = TMesh.Grid;
 			constexpr uint32 flags = PolyEdge::ON_EDGE_AB | PolyEdge::ON_EDGE_BC | PolyEdge::ON_EDGE_CA;
 			
 			const int OtherMeshCt = OtherMeshes.Num();
@@ -777,9 +1051,9 @@ namespace Geometry {
 				ExcludingBV = TArrayView<TriMesh*>(OtherMeshes).Slice(0, OtherMeshes.Num() - 1);
 			}
 			
-			for (int i = 0; i < TriGrid.Num(); i++) {
+			for (int i = StartIndex; i < EndIndex; i++) {
 				Tri& T = TriGrid[i];
-				UNavDbg::BreakOnVertexCaptureMatch(T);
+				UNavDbg::BreakOnVertexCaptureMatch(TriGrid, i);
 				if (T.IsCull()) {
 					// Tri already culled because it's outside of the bounds volume
 					continue;
@@ -787,22 +1061,25 @@ namespace Geometry {
 				UnstructuredPolygon& UPoly = UPolys[i];
 				if (OtherMeshCt > 1 && UPoly.Edges.Num() == 0) {
 					// if there are no intersections, just check if the tri points are inside other meshes
-					Internal_IsTriObscured(T, ExcludingBV, MinZ, MHitCtr);
+					Internal_IsTriObscured(TriGrid, i, ExcludingBV, MinZ, MHitCtr);
 					continue;
 				}
-				PolyEdge PEdgeAB(T.A, T.B, flags);
+				const FVector& A = TriGrid.GetA(i);
+				const FVector& B = TriGrid.GetB(i);
+				const FVector& C = TriGrid.GetC(i);
+				PolyEdge PEdgeAB(A, B, flags);
 				const bool AObscured = Internal_GetObscuredDistances(
-					T.A, T.B, OtherMeshes, PEdgeAB.ObscuredLocations, BBoxDiagDistance, MHitCtr
+					A, B, OtherMeshes, PEdgeAB.ObscuredLocations, BBoxDiagDistance, MHitCtr
 				);
-				PolyEdge PEdgeBC(T.B, T.C, flags);
+				PolyEdge PEdgeBC(B, C, flags);
 				const bool BObscured = Internal_GetObscuredDistances(
-					T.B, T.C, OtherMeshes, PEdgeBC.ObscuredLocations, BBoxDiagDistance, MHitCtr
+					B, C, OtherMeshes, PEdgeBC.ObscuredLocations, BBoxDiagDistance, MHitCtr
 				);
-				PolyEdge PEdgeCA(T.C, T.A, flags);
+				PolyEdge PEdgeCA(C, A, flags);
 				const bool CObscured = Internal_GetObscuredDistances(
-					T.C, T.A, OtherMeshes, PEdgeCA.ObscuredLocations, BBoxDiagDistance, MHitCtr
+					C, A, OtherMeshes, PEdgeCA.ObscuredLocations, BBoxDiagDistance, MHitCtr
 				);
-				TArray<PolyEdge>& Edges = UPoly.Edges;
+				TScratchArray<PolyEdge>& Edges = UPoly.Edges;
 				if (AObscured) {
 					T.SetAObscured();
 					PEdgeAB.SetAEnclosed();
@@ -868,70 +1145,99 @@ namespace Geometry {
 			}
 		}
 
-		// Asks if Tris with indices A and indices B are neighbors (do they share a side?)
-		bool Internal_AreNeighbors(const uint32* IndicesA, const uint32* IndicesB, uint32& Flags, int SideIndex) {
-			enum {A=0, B=1, C=2};
-			constexpr int j[2][2] {{B, C}, {A, C}};
-			for (int i = A; i < C; i++) {
-				const int j0 = j[i][0];
-				const int j1 = j[i][1];
-				if (IndicesA[i] == IndicesB[A]) {
-					if (IndicesA[j0] == IndicesB[B]) {
-						Tri::AddNeighborFlag(Flags, i, j0, SideIndex);
-						return true;
-					}
-					if (IndicesA[j0] == IndicesB[C]) {
-						Tri::AddNeighborFlag(Flags, i, j0, SideIndex);
-						return true;
-					}
-					if (IndicesA[j1] == IndicesB[B]) {
-						Tri::AddNeighborFlag(Flags, i, j1, SideIndex);
-						return true;
-					}
-					if (IndicesA[j1] == IndicesB[C]) {
-						Tri::AddNeighborFlag(Flags, i, j1, SideIndex);
-						return true;
-					}
+#ifdef UNAV_DEV
+		// The box overlap test DoBoundingBoxesOverlap() used before the separating axis test, kept as a reference for
+		// CompareBoxOverlapTests(): vertex containment either way, then each box's edges raycast against the other's
+		// faces. Face normals aren't kept on BoundingBox anymore, so they're found as needed
+		
+		constexpr int RefBBoxFaceIndices[BoundingBox::FACE_CT][3] {
+			{0, 1, 2}, {0, 1, 3}, {0, 2, 3},
+			{7, 4, 5}, {7, 5, 6}, {7, 4, 6}
+		};
+
+		constexpr int RefBBoxEdgeIndices[BoundingBox::EDGE_CT][2] {
+			{0, 1}, {0, 2}, {1, 4}, {2, 4},
+			{3, 5}, {3, 6}, {7, 5}, {7, 6},
+			{1, 5}, {4, 7}, {2, 6}, {0, 3}
+		};
+
+		bool Internal_RefDoesPointTouchFace(
+			const FVector& VertA, const FVector& VertB, const FVector& VertC, const FVector& Pt
+		) {
+			const FVector FaceEdgeB = VertB - VertA;	
+			const FVector FaceEdgeC = VertC - VertA;
+			const FVector PtVec = Pt - VertA;
+			const float LenFEB = FaceEdgeB.Size() + NEAR_EPSILON;
+			const float LenFEC = FaceEdgeC.Size() + NEAR_EPSILON;
+			const float LenPVC = PtVec.Size();
+			const float CosTheta = FVector::DotProduct(PtVec, FaceEdgeB) / (LenPVC * LenFEB);
+			const float CosPhi = FVector::DotProduct(PtVec, FaceEdgeC) / (LenPVC * LenFEC);
+			return (CosTheta >= 0) && (CosPhi >= 0) && (LenPVC * CosTheta <= LenFEB) && (LenPVC * CosPhi <= LenFEC);
+		}
+
+		bool Internal_RefRaycastFace(
+			const FVector& Origin, const FVector& Dir, float Length, const BoundingBox& BBox, int Face
+		) {
+			const int* FaceIndices = RefBBoxFaceIndices[Face];
+			const FVector& FacePtA = BBox.Vertices[FaceIndices[0]];
+			const FVector& FacePtB = BBox.Vertices[FaceIndices[1]];
+			const FVector& FacePtC = BBox.Vertices[FaceIndices[2]];
+			const FVector Normal = FVector::CrossProduct(FacePtB - FacePtA, FacePtC - FacePtA).GetUnsafeNormal();
+			const FVector PVec = Origin - FacePtA;
+			const double LenOProj = DoubleVector::DotProduct(Normal, PVec);
+			if (LenOProj <= 0.0) {
+				return false;
+			}
+			const double RayNormCosTheta = DoubleVector::DotProduct(Dir, -Normal);
+			if (RayNormCosTheta <= 0.0) {
+				return false;
+			}
+			const float HitDistance = LenOProj / RayNormCosTheta;
+			if (HitDistance > Length) {
+				return false;
+			}
+			return Internal_RefDoesPointTouchFace(FacePtA, FacePtB, FacePtC, Origin + Dir * HitDistance);
+		}
+
+		bool Internal_RefDoesLineSegmentIntersectBox(const FVector& LSA, const FVector& LSB, const BoundingBox& BBox) {
+			FVector Dir = LSB - LSA;
+			const float Length = Dir.Size();
+			Dir *= 1.0f / Length;
+			for (int j = 0; j < BoundingBox::FACE_CT; j++) {
+				if (Internal_RefRaycastFace(LSA, Dir, Length, BBox, j)) {
+					return true;
 				}
-				else if (IndicesA[i] == IndicesB[B]) {
-					if (IndicesA[j0] == IndicesB[A]) {
-						Tri::AddNeighborFlag(Flags, i, j0, SideIndex);
-						return true;
-					}
-					if (IndicesA[j0] == IndicesB[C]) {
-						Tri::AddNeighborFlag(Flags, i, j0, SideIndex);
-						return true;
-					}
-					if (IndicesA[j1] == IndicesB[A]) {
-						Tri::AddNeighborFlag(Flags, i, j1, SideIndex);
-						return true;
-					}
-					if (IndicesA[j1] == IndicesB[C]) {
-						Tri::AddNeighborFlag(Flags, i, j1, SideIndex);
-						return true;
-					}
+			}
+			for (int j = 0; j < BoundingBox::FACE_CT; j++) {
+				if (Internal_RefRaycastFace(LSB, -Dir, Length, BBox, j)) {
+					return true;
 				}
-				else if (IndicesA[i] == IndicesB[C]) {
-					if (IndicesA[j0] == IndicesB[B]) {
-						Tri::AddNeighborFlag(Flags, i, j0, SideIndex);
-						return true;
-					}
-					if (IndicesA[j0] == IndicesB[A]) {
-						Tri::AddNeighborFlag(Flags, i, j0, SideIndex);
-						return true;
-					}
-					if (IndicesA[j1] == IndicesB[B]) {
-						Tri::AddNeighborFlag(Flags, i, j1, SideIndex);
-						return true;
-					}
-					if (IndicesA[j1] == IndicesB[A]) {
-						Tri::AddNeighborFlag(Flags, i, j1, SideIndex);
+			}
+			return false;
+		}
+
+		bool Internal_RefDoBoundingBoxesOverlap(const BoundingBox& BBoxA, const BoundingBox& BBoxB) {
+			for (int i = 0; i < BoundingBox::VERTEX_CT; i++) {
+				if (IsPointInsideBox(BBoxA, BBoxB.Vertices[i]) || IsPointInsideBox(BBoxB, BBoxA.Vertices[i])) {
+					return true;
+				}
+			}
+			const BoundingBox* EdgesBox = &BBoxA;
+			const BoundingBox* FacesBox = &BBoxB;
+			for (int i = 0; i < 2; i++) {
+				for (int j = 0; j < BoundingBox::EDGE_CT; j++) {
+					const int* EdgeIndices = RefBBoxEdgeIndices[j];
+					if (Internal_RefDoesLineSegmentIntersectBox(
+						EdgesBox->Vertices[EdgeIndices[0]], EdgesBox->Vertices[EdgeIndices[1]], *FacesBox
+					)) {
 						return true;
 					}
 				}
+				Swap(EdgesBox, FacesBox);
 			}
 			return false;
 		}
+#endif
 	}
 
 	// -----------------------------------------------------------------------------------------------------------------
@@ -958,6 +1264,10 @@ namespace Geometry {
 		GetGroupExtrema(Group, Min, Max);
 		Internal_SetBoundingBoxFromExtrema(NMesh.Box, Min, Max);	
 	}
+
+	void SetBoundingBox(BoundingBox& BBox, const FVector& Min, const FVector& Max) {
+		Internal_SetBoundingBoxFromExtrema(BBox, Min, Max);
+	}
 	
 	// If the points were all on a line, you would only need to check magnitude; implicit scaling by cos(theta) in
 	// dot product does the work of checking in 3 dimensions
@@ -989,17 +1299,77 @@ namespace Geometry {
 	}
 
 	bool DoBoundingBoxesOverlap(const BoundingBox& BBoxA, const BoundingBox& BBoxB) {
-		for (int i = 0; i < BoundingBox::VERTEX_CT; i++) {
-			if (IsPointInsideBox(BBoxA, BBoxB.Vertices[i])) {
-				return true;
+		const BoundingBox* Boxes = &BBoxB;
+		BoxPacket Packet;
+		Internal_FillBoxPacket(Packet, &Boxes, 1);
+		return (Internal_GetBoxPacketOverlaps(BBoxA, Packet) & 0x1) != 0;
+	}
+
+#ifdef UNAV_DEV
+	int CompareBoxOverlapTests(const BoundingBox& BBox, const TArray<const BoundingBox*>& Others, int PairedCt) {
+		int MismatchCt = 0;
+		int PairCt = 0;
+		auto Compare = [&MismatchCt, &PairCt](const BoundingBox& BBoxA, const BoundingBox& BBoxB, int A, int B) {
+			PairCt++;
+			const bool IsSATOverlap = DoBoundingBoxesOverlap(BBoxA, BBoxB);
+			const bool IsRefOverlap = Internal_RefDoBoundingBoxesOverlap(BBoxA, BBoxB);
+			if (IsSATOverlap != IsRefOverlap) {
+				MismatchCt++;
+				printf(
+					"box overlap mismatch, boxes %d and %d: separating axis %d, raycast %d\n",
+					A, B, IsSATOverlap, IsRefOverlap
+				);
 			}
+		};
+		for (int i = 0; i < Others.Num(); i++) {
+			Compare(BBox, *Others[i], -1, i);
 		}
-		for (int i = 0; i < BoundingBox::VERTEX_CT; i++) {
-			if (IsPointInsideBox(BBoxB, BBoxA.Vertices[i])) {
-				return true;
+		for (int i = 0; i < PairedCt; i++) {
+			for (int j = i + 1; j < PairedCt; j++) {
+				Compare(*Others[i], *Others[j], i, j);
+			}
+		}
+		printf("box overlap tests: %d of %d pairs differ\n", MismatchCt, PairCt);
+		return MismatchCt;
+	}
+#endif
+
+	void GetOverlappingBoxes(
+		const BoundingBox& BBox,
+		const TArray<const BoundingBox*>& Others,
+		TArray<int>& OverlapIndices
+	) {
+		BoxPacket Packet;
+		for (int i = 0; i < Others.Num(); i += BOX_PACKET_SZ) {
+			const int PacketCt = FMath::Min(BOX_PACKET_SZ, Others.Num() - i);
+			Internal_FillBoxPacket(Packet, &Others[i], PacketCt);
+			const int Overlaps = Internal_GetBoxPacketOverlaps(BBox, Packet) & ((1 << PacketCt) - 1);
+			for (int j = 0; j < PacketCt; j++) {
+				if (Overlaps & (1 << j)) {
+					OverlapIndices.Add(i + j);
+				}
 			}
 		}
-		return Internal_DoBoundingBoxesIntersect(BBoxA, BBoxB);
+	}
+
+	void GetClosestPointsOnTris(
+		const TriGrid& Grid,
+		const FVector* Points,
+		const uint32* TriIndices,
+		int Ct,
+		FVector* ClosestPoints
+	) {
+		Internal_GetClosestPointsOnTris(Grid, Points, 1, TriIndices, Ct, ClosestPoints);
+	}
+
+	void GetClosestPointsOnTris(
+		const TriGrid& Grid,
+		const FVector& Point,
+		const uint32* TriIndices,
+		int Ct,
+		FVector* ClosestPoints
+	) {
+		Internal_GetClosestPointsOnTris(Grid, &Point, 0, TriIndices, Ct, ClosestPoints);
 	}
 
 	bool IsBoxAInBoxB(const BoundingBox& BBoxA, const BoundingBox& BBoxB) {
@@ -1036,6 +1406,72 @@ namespace Geometry {
 		return false;
 	}
 	
+	void GetAABBOverlapPairs(const TArray<TriMesh>& TMeshes, TArray<uint64>& Pairs) {
+		const int TMeshCt = TMeshes.Num();
+		if (TMeshCt < 2) {
+			return;
+		}
+		TArray<FVector> Mins;
+		TArray<FVector> Maxes;
+		Mins.SetNumUninitialized(TMeshCt);
+		Maxes.SetNumUninitialized(TMeshCt);
+		FVector CenterSum = FVector::ZeroVector;
+		FVector CenterSqSum = FVector::ZeroVector;
+		for (int i = 0; i < TMeshCt; i++) {
+			GetAxisAlignedExtrema(TMeshes[i].Box, Mins[i], Maxes[i]);
+			const FVector Center = (Mins[i] + Maxes[i]) * 0.5f;
+			CenterSum += Center;
+			CenterSqSum += Center * Center;
+		}
+		
+		// sweeping along the axis the boxes are most spread out on leaves the fewest boxes active at once
+		const FVector Variance = CenterSqSum - CenterSum * CenterSum / TMeshCt;
+		int SweepAxis = 0;
+		if (Variance.Y > Variance[SweepAxis]) {
+			SweepAxis = 1;
+		}
+		if (Variance.Z > Variance[SweepAxis]) {
+			SweepAxis = 2;
+		}
+		const int AxisB = (SweepAxis + 1) % 3;
+		const int AxisC = (SweepAxis + 2) % 3;
+		
+		TArray<int> Order;
+		Order.SetNumUninitialized(TMeshCt);
+		for (int i = 0; i < TMeshCt; i++) {
+			Order[i] = i;
+		}
+		Order.Sort([&Mins, SweepAxis](int A, int B) {
+			return Mins[A][SweepAxis] < Mins[B][SweepAxis];
+		});
+
+		// boxes whose extent along the sweep axis hasn't been passed yet
+		TArray<int> Active;
+		for (int i = 0; i < TMeshCt; i++) {
+			const int Index = Order[i];
+			const FVector& Min = Mins[Index];
+			const FVector& Max = Maxes[Index];
+			for (int j = 0; j < Active.Num(); ) {
+				const int Other = Active[j];
+				if (Maxes[Other][SweepAxis] < Min[SweepAxis]) {
+					Active.RemoveAtSwap(j);
+					continue;
+				}
+				if (
+					Mins[Other][AxisB] <= Max[AxisB] && Maxes[Other][AxisB] >= Min[AxisB]
+					&& Mins[Other][AxisC] <= Max[AxisC] && Maxes[Other][AxisC] >= Min[AxisC]
+				) {
+					const uint64 Low = FMath::Min(Index, Other);
+					const uint64 High = FMath::Max(Index, Other);
+					Pairs.Add(Low << 32 | High);
+				}
+				j++;
+			}
+			Active.Add(Index);
+		}
+		Pairs.Sort();
+	}
+	
 	void GetGroupExtrema(const TArray<TriMesh*>& TMeshes, FVector& Min, FVector& Max, bool NudgeOutward) {
 		const int TMeshCt = TMeshes.Num();
 		if (TMeshCt == 0) {
@@ -1106,32 +1542,31 @@ namespace Geometry {
 		}
 	}
 
-	void FlagTrisOutsideBoxForCull(const BoundingBox& BBox, const TriMesh& TMesh) {
-		const auto& Grid = TMesh.Grid;
+	void FlagTrisOutsideBoxForCull(const BoundingBox& BBox, TriMesh& TMesh) {
+		auto& Grid = TMesh.Grid;
 		for (int i = 0; i < Grid.Num(); i++) {
-			Tri& T = Grid[i];
 			if (
-				!IsPointInsideBox(BBox, T.A)
-				&& !IsPointInsideBox(BBox, T.B)
-				&& !IsPointInsideBox(BBox,T.C)
+				!IsPointInsideBox(BBox, Grid.GetA(i))
+				&& !IsPointInsideBox(BBox, Grid.GetB(i))
+				&& !IsPointInsideBox(BBox, Grid.GetC(i))
 			) {
-				T.MarkForCull();	
+				Grid[i].MarkForCull();	
 			}	
 		}	
 	}
 
-	void FlagTriVerticesInsideBoundsVolume(const TriMesh& TMesh) {
-		const auto& Grid = TMesh.Grid;
+	void FlagTriVerticesInsideBoundsVolume(TriMesh& TMesh) {
+		auto& Grid = TMesh.Grid;
 		const auto& BBox = Data::BoundsVolumeTMesh.Box;
 		for (int i = 0; i < Grid.Num(); i++) {
 			Tri& T = Grid[i];
-			if (IsPointInsideBox(BBox, T.A)) {
+			if (IsPointInsideBox(BBox, Grid.GetA(i))) {
 				T.SetAInsideBV();
 			}
-			if (IsPointInsideBox(BBox, T.B)) {
+			if (IsPointInsideBox(BBox, Grid.GetB(i))) {
 				T.SetBInsideBV();
 			}
-			if (IsPointInsideBox(BBox, T.C)) {
+			if (IsPointInsideBox(BBox, Grid.GetC(i))) {
 				T.SetCInsideBV();
 			}
 			if (!T.AnyInsideBV()) {
@@ -1153,31 +1588,69 @@ namespace Geometry {
 		
 		const int GroupCt = Group.Num();
 		// find all intersections between tris in this group and mark where those intersections are inside
-		// and where they are outside other meshes
+		// and where they are outside other meshes; each mesh pair is split into ranges of A's tris, and every range
+		// collects its edges on its own so the tasks never share a poly
+		TArray<IntersectionTask> Tasks;
 		for (int i = 0; i < GroupCt - 1; i++) {
-			TriMesh& TMeshA = *Group[i];
-			TArray<UnstructuredPolygon>& UPolysA = GroupUPolys[i];
+			const int TriCt = Group[i]->Grid.Num();
 			for (int j = i + 1; j < GroupCt; j++) {
-				TriMesh& TMeshB = *Group[j];
-				TArray<UnstructuredPolygon>& UPolysB = GroupUPolys[j];
-				TArray<TriMesh*> GroupExcludingAandB = Group;
-				GroupExcludingAandB.Remove(&TMeshA);
-				GroupExcludingAandB.Remove(&TMeshB);
-				Internal_FindPolyEdges(
-					TMeshA, TMeshB, GroupExcludingAandB, UPolysA, UPolysB, BBoxDiagDist
-				);	
+				for (int k = 0; k < TriCt; k += INTERSECTION_TASK_TRI_CT) {
+					Tasks.Add(IntersectionTask(i, j, k, FMath::Min(k + INTERSECTION_TASK_TRI_CT, TriCt)));
+				}
 			}
 		}
+		TArray<TArray<TriPairPolyEdge>> TaskEdges;
+		TaskEdges.SetNum(Tasks.Num());
+		// tasks allocate from the caller's scratch arena, if it has one, whichever thread they land on
+		ScratchArena* Arena = ScratchArena::GetCurrent();
+		ParallelFor(Tasks.Num(), [&](int32 TaskIndex) {
+			const ScratchArena::Scope Scope(Arena);
+			const IntersectionTask& Task = Tasks[TaskIndex];
+			TriMesh* TMeshA = Group[Task.MeshIndexA];
+			TriMesh* TMeshB = Group[Task.MeshIndexB];
+			TArray<TriMesh*> GroupExcludingAandB = Group;
+			GroupExcludingAandB.Remove(TMeshA);
+			GroupExcludingAandB.Remove(TMeshB);
+			Internal_FindPolyEdges(
+				*TMeshA, *TMeshB, GroupExcludingAandB, Task.StartIndex, Task.EndIndex, TaskEdges[TaskIndex], BBoxDiagDist
+			);
+		});
+		// merging in task order, which is the order a single thread would have added the edges in
+		for (int i = 0; i < Tasks.Num(); i++) {
+			TArray<UnstructuredPolygon>& UPolysA = GroupUPolys[Tasks[i].MeshIndexA];
+			TArray<UnstructuredPolygon>& UPolysB = GroupUPolys[Tasks[i].MeshIndexB];
+			for (TriPairPolyEdge& PairEdge : TaskEdges[i]) {
+				UPolysA[PairEdge.TriIndexA].Edges.Add(PairEdge.Edge);
+				UPolysB[PairEdge.TriIndexB].Edges.Add(MoveTemp(PairEdge.Edge));
+			}
+		}
+		
 		// for any tri that has intersections, mark where the tri edges are inside and outside other meshes;
-		// if no intersections, just note which vertices are inside and which are outside
+		// if no intersections, just note which vertices are inside and which are outside. Ranges write to their
+		// own tris and polys only, so there's nothing to merge
+		Tasks.Reset();
 		for (int i = 0; i < GroupCt; i++) {
-			TriMesh& TMesh = *Group[i];
+			const int TriCt = Group[i]->Grid.Num();
+			for (int k = 0; k < TriCt; k += INTERSECTION_TASK_TRI_CT) {
+				Tasks.Add(IntersectionTask(i, -1, k, FMath::Min(k + INTERSECTION_TASK_TRI_CT, TriCt)));
+			}
+		}
+		ParallelFor(Tasks.Num(), [&](int32 TaskIndex) {
+			const ScratchArena::Scope Scope(Arena);
+			const IntersectionTask& Task = Tasks[TaskIndex];
+			TriMesh* TMesh = Group[Task.MeshIndexA];
 			TArray<TriMesh*> GroupExcludingThisMesh = Group;
-			GroupExcludingThisMesh.Remove(&TMesh);
+			GroupExcludingThisMesh.Remove(TMesh);
 			Internal_PopulatePolyEdgesFromTriEdges(
-				TMesh, GroupExcludingThisMesh, GroupUPolys[i], BBoxDiagDist, MinZ
+				*TMesh,
+				GroupExcludingThisMesh,
+				GroupUPolys[Task.MeshIndexA],
+				Task.StartIndex,
+				Task.EndIndex,
+				BBoxDiagDist,
+				MinZ
 			);
-		}
+		});
 	}
 	
 	// clever trick: assume the pt is inside the triangle. then, the pt makes three triangles - one with every pair
@@ -1190,38 +1663,43 @@ namespace Geometry {
 		);
 	}
 
-	bool DoesTriHaveSimilarVectors(const Tri& T, const FVector& A, const FVector& B, const FVector& C) {
+	bool DoesTriHaveSimilarVectors(
+		const TriGrid& Grid, int TriIndex, const FVector& A, const FVector& B, const FVector& C
+	) {
 		constexpr float Epsilon = 1000.0f;
+		const FVector& TA = Grid.GetA(TriIndex);
+		const FVector& TB = Grid.GetB(TriIndex);
+		const FVector& TC = Grid.GetC(TriIndex);
 		if (
 			(
-				FVector::DistSquared(T.A, A) <= Epsilon
-				&& FVector::DistSquared(T.B, B) <= Epsilon
-				&& FVector::DistSquared(T.C, C) <= Epsilon
+				FVector::DistSquared(TA, A) <= Epsilon
+				&& FVector::DistSquared(TB, B) <= Epsilon
+				&& FVector::DistSquared(TC, C) <= Epsilon
 			)
 			|| (
-				FVector::DistSquared(T.A, A) <= Epsilon
-				&& FVector::DistSquared(T.B, C) <= Epsilon
-				&& FVector::DistSquared(T.C, B) <= Epsilon
+				FVector::DistSquared(TA, A) <= Epsilon
+				&& FVector::DistSquared(TB, C) <= Epsilon
+				&& FVector::DistSquared(TC, B) <= Epsilon
 			)
 			|| (
-				FVector::DistSquared(T.A, B) <= Epsilon
-				&& FVector::DistSquared(T.B, A) <= Epsilon
-				&& FVector::DistSquared(T.C, C) <= Epsilon
+				FVector::DistSquared(TA, B) <= Epsilon
+				&& FVector::DistSquared(TB, A) <= Epsilon
+				&& FVector::DistSquared(TC, C) <= Epsilon
 			)
 			|| (
-				FVector::DistSquared(T.A, B) <= Epsilon
-				&& FVector::DistSquared(T.B, C) <= Epsilon
-				&& FVector::DistSquared(T.C, A) <= Epsilon
+				FVector::DistSquared(TA, B) <= Epsilon
+				&& FVector::DistSquared(TB, C) <= Epsilon
+				&& FVector::DistSquared(TC, A) <= Epsilon
 			)
 			|| (
-				FVector::DistSquared(T.A, C) <= Epsilon
-				&& FVector::DistSquared(T.B, A) <= Epsilon
-				&& FVector::DistSquared(T.C, B) <= Epsilon
+				FVector::DistSquared(TA, C) <= Epsilon
+				&& FVector::DistSquared(TB, A) <= Epsilon
+				&& FVector::DistSquared(TC, B) <= Epsilon
 			)
 			|| (
-				FVector::DistSquared(T.A, C) <= Epsilon
-				&& FVector::DistSquared(T.B, B) <= Epsilon
-				&& FVector::DistSquared(T.C, A) <= Epsilon
+				FVector::DistSquared(TA, C) <= Epsilon
+				&& FVector::DistSquared(TB, B) <= Epsilon
+				&& FVector::DistSquared(TC, A) <= Epsilon
 			)
 		) {
 			return true;
@@ -1258,31 +1736,5 @@ namespace Geometry {
 		}
 		return VERTEX_INTERIOR;
 	}
-
-	int GetNeighborTris(const TriGrid& Grid, int TIndex, const uint32* TriVIndices, Tri** Neighbors, uint32& Flags) {
-		int NeighborCt = 0;
-		for (int i = 0; i < TIndex; i++) {
-			uint32 VIndices[3];
-			Grid.GetVIndices(i, VIndices);
-			if (Internal_AreNeighbors(TriVIndices, VIndices, Flags, NeighborCt)) {
-				Neighbors[NeighborCt] = &Grid[i];
-				if (++NeighborCt == 3) {
-					return 3;
-				}
-			}
-		}
-		for (int i = TIndex + 1; i < Grid.Num(); i++) {
-			uint32 VIndices[3];
-			Grid.GetVIndices(i, VIndices);
-			if (Internal_AreNeighbors(TriVIndices, VIndices, Flags, NeighborCt)) {
-				Neighbors[NeighborCt] = &Grid[i];
-				if (++NeighborCt == 3) {
-					return 3;
-				}
-			}
-		}
-	
-		return NeighborCt;
-	}
 	
 }
@@ -4,6 +4,7 @@
 struct PolyNode;
 class AStaticMeshActor;
 class UBoxComponent;
+class TriGrid;
 
 
 struct BoundingBox;
@@ -24,15 +25,55 @@ namespace Geometry {
 	// Populates a BoundingBox from a UNavMesh
 	void SetBoundingBox(UNavMesh& NMesh, const TArray<TriMesh*> Group);
 
+	// Populates an axis-aligned BoundingBox from its extrema
+	void SetBoundingBox(BoundingBox& BBox, const FVector& Min, const FVector& Max);
+
 	// Checks if the point lies inside the bounding box
 	bool IsPointInsideBox(const BoundingBox& BBox, const FVector& Point);
 
 	// Checks whether or not the two bounding boxes overlap. Seemingly necessary to do this on our own for editor plugin.
+	// Separating axis test on the centers, axes and half extents precomputed when the boxes were set
 	bool DoBoundingBoxesOverlap(const BoundingBox& BBoxA, const BoundingBox& BBoxB);
 
+	// Dev check of DoBoundingBoxesOverlap() against the edge raycast test it replaced: BBox against each of Others, then
+	// every pair among the first PairedCt of Others. Prints each pair the two disagree on (index -1 is BBox) and
+	// returns how many there were. Only defined with UNAV_DEV
+	int CompareBoxOverlapTests(const BoundingBox& BBox, const TArray<const BoundingBox*>& Others, int PairedCt);
+
+	// DoBoundingBoxesOverlap() of BBox against each of Others, several at a time; adds the indices (in Others) of the
+	// boxes that overlap BBox to OverlapIndices, in order
+	void GetOverlappingBoxes(
+		const BoundingBox& BBox,
+		const TArray<const BoundingBox*>& Others,
+		TArray<int>& OverlapIndices
+	);
+
+	// Closest point on tri TriIndices[i] of Grid to Points[i], for i < Ct, into ClosestPoints[i]; four at a time with
+	// SIMD, e.g. for keeping many agents on the tris they're known to be on
+	void GetClosestPointsOnTris(
+		const TriGrid& Grid,
+		const FVector* Points,
+		const uint32* TriIndices,
+		int Ct,
+		FVector* ClosestPoints
+	);
+
+	// as above, with the same point for every tri
+	void GetClosestPointsOnTris(
+		const TriGrid& Grid,
+		const FVector& Point,
+		const uint32* TriIndices,
+		int Ct,
+		FVector* ClosestPoints
+	);
+
 	// checks whether B fully envelops A
 	bool IsBoxAInBoxB(const BoundingBox& BBoxA, const BoundingBox& BBoxB);
 
+	// Sort-and-sweep over the world axis-aligned bounds of each mesh's box. Fills Pairs with (i << 32 | j), i < j, for
+	// every pair of meshes whose bounds overlap, in ascending order
+	void GetAABBOverlapPairs(const TArray<TriMesh>& TMeshes, TArray<uint64>& Pairs);
+
 	// Checks whether two meshes overlap. Only those meshes in TMeshes with an index in PotentialOverlapIndices are checked.
 	bool GetTriMeshIntersectGroups(
 		TArray<int>& OverlapIndices,
@@ -46,12 +87,13 @@ namespace Geometry {
 
 	inline void GetAxisAlignedExtrema(const BoundingBox& BBox, FVector& Min, FVector& Max, float NudgeOutward=0.0f);
 
-	void FlagTrisOutsideBoxForCull(const BoundingBox& BBox, const TriMesh& TMesh);
+	void FlagTrisOutsideBoxForCull(const BoundingBox& BBox, TriMesh& TMesh);
 
-	void FlagTriVerticesInsideBoundsVolume(const TriMesh& TMesh);
+	void FlagTriVerticesInsideBoundsVolume(TriMesh& TMesh);
 
 	// find all intersections between tris and create a picture of where each tri is inside and where it's outside
-	// other meshes; if 'inside' edges connect, they form polygons. Assumes the bounds volume is the last member of group
+	// other meshes; if 'inside' edges connect, they form polygons. Assumes the bounds volume is the last member of group.
+	// Work is spread over the task graph, but the output is the same as doing it all on the calling thread
 	void FindIntersections(
 		TArray<TriMesh*>& Group,
 		TArray<TArray<UnstructuredPolygon>>& GroupUPolys
@@ -60,8 +102,10 @@ namespace Geometry {
 	// Does P (roughly) lie on/inside Triangle ABC?
 	inline bool DoesPointTouchTri(const FVector& A, const FVector& B, const FVector& C, const FVector& P);
 
-	// Do A, B, C come close to T.X, T.Y, T.Z in any order? Useful for finding a specific tri and debugging it
-	inline bool DoesTriHaveSimilarVectors(const Tri& T, const FVector& A, const FVector& B, const FVector& C);
+	// Do A, B, C come close to the vertices of tri TriIndex in any order? Useful for finding a specific tri and debugging it
+	inline bool DoesTriHaveSimilarVectors(
+		const TriGrid& Grid, int TriIndex, const FVector& A, const FVector& B, const FVector& C
+	);
 
 	// Tests if P.Prev, P and P.Next make a triangle that contains no other points in the polygon
 	// polygon must have >= 4 vertices
@@ -76,12 +120,4 @@ namespace Geometry {
 	inline VERTEX_T GetPolyVertexType(
 		const FVector& Normal, const FVector& W, const FVector& V, const FVector& U, VERTEX_T PrevType
 	);
-
-	inline int GetNeighborTris(
-		const TriGrid& Grid,
-		int TIndex,
-		const uint32* TriVIndices,
-		Tri** Neighbors,
-		uint32& Flags
-	);
 }
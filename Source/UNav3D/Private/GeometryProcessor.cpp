@@ -3,6 +3,7 @@
 #include "Geometry.h"
 #include "Rendering/PositionVertexBuffer.h"
 #include "RenderingThread.h"
+#include "RHI.h"
 #include "Engine/StaticMeshActor.h"
 #include "TriMesh.h"
 #include "Tri.h"
@@ -12,16 +13,45 @@
 #include "SelectionSet.h"
 #include "UNavMesh.h"
 #include "Containers/ArrayView.h"
+#include "MeshCache.h"
 
 // TODO: currently just using LOD0, and it would be nice to parameterize this, but I wouldn't do it until...
 // TODO: ... there is a good system in place to take that input from the user
 // TODO: batch processing, at least per group
 
-GeometryProcessor::GeometryProcessor() {}
+GeometryProcessor::GeometryProcessor() :
+	WeldEpsilon(DEFAULT_WELD_EPSILON)
+{}
 
 GeometryProcessor::~GeometryProcessor() {}
 
+namespace {
+
+	// without an RHI (e.g. a headless -nullrhi build) buffers can't be read back, so cpu copies are the only source
+	bool GPUReadUnavailable() {
+		return GUsingNullRHI;
+	}
+	
+}
+
 GeometryProcessor::GEOPROC_RESPONSE GeometryProcessor::PopulateTriMesh(TriMesh& TMesh, bool DoTransform) const {
+	MeshBuffers Buffers;
+	const GEOPROC_RESPONSE Response = ReadMeshBuffers(TMesh, Buffers, DoTransform);
+	if (Response != GEOPROC_SUCCESS) {
+		return Response;
+	}
+	if (Buffers.IsGPURead) {
+		FlushRenderingCommands();
+		Buffers.IsGPURead = false;
+	}
+	return BuildTriMesh(TMesh, Buffers);
+}
+
+GeometryProcessor::GEOPROC_RESPONSE GeometryProcessor::ReadMeshBuffers(
+	TriMesh& TMesh,
+	MeshBuffers& Buffers,
+	bool DoTransform
+) const {
 	// forcing CPU access to the mesh seems like the most user-friendly option
 	UStaticMesh* StaticMesh = TMesh.MeshActor->GetStaticMeshComponent()->GetStaticMesh();
 	StaticMesh->bAllowCPUAccess = true;
@@ -30,122 +60,196 @@ GeometryProcessor::GEOPROC_RESPONSE GeometryProcessor::PopulateTriMesh(TriMesh&
 	const FStaticMeshLODResources& LOD = StaticMesh->GetRenderData()->LODResources[0];
 	
 	TMesh.ResetVertexData();
-	uint32 IndexCt;
-	uint32 VertexCt;
 
-	// get indices and vertices from gpu buffers
-	uint16* Indices = GetIndices(LOD, IndexCt);
-	if (Indices == nullptr) {
+	// get indices and vertices from cpu copies if there are any, gpu buffers if not
+	GEOPROC_RESPONSE Response = GetIndices(LOD, Buffers);
+	if (Response != GEOPROC_SUCCESS) {
+		return Response;
+	}
+	bool IsVertexGPURead = false;
+	Response = GetVertices(LOD, TMesh, Buffers.VertexCt, IsVertexGPURead);
+	Buffers.IsGPURead |= IsVertexGPURead;
+	if (Response != GEOPROC_SUCCESS) {
+		// a pending read still writes into the buffers, so it has to land before they're freed
+		if (Buffers.IsGPURead) {
+			FlushRenderingCommands();
+			Buffers.IsGPURead = false;
+		}
+		TMesh.ResetVertexData();
+		Buffers.ReleaseIndices();
+		return Response;
+	}
+	
+	// the actor can't be asked for its transform off the game thread, so it's held on to here
+	Buffers.DoTransform = DoTransform;
+	if (DoTransform) {
+		Buffers.TForm = TMesh.MeshActor->GetTransform();
+	}
+	return GEOPROC_SUCCESS;
+}
+
+GeometryProcessor::GEOPROC_RESPONSE GeometryProcessor::ReadCachedMeshBuffers(
+	TriMesh& TMesh,
+	MeshBuffers& Buffers,
+	const MeshAssetEntry& Asset,
+	bool DoTransform
+) const {
+	TMesh.ResetVertexData();
+	
+	Buffers.VertexCt = Asset.Vertices.Num();
+	TMesh.Vertices = new FVector[Buffers.VertexCt];
+	TMesh.Grid.SetVertices(TMesh.Vertices);
+	if (TMesh.Vertices == nullptr) {
 		return GEOPROC_ALLOC_FAIL;
 	}
-	GEOPROC_RESPONSE Response = GetVertices(LOD, TMesh, VertexCt);
+	memcpy(TMesh.Vertices, Asset.Vertices.GetData(), Buffers.VertexCt * sizeof(FVector));
+
+	// the asset's indices outlive the build, so they're used in place
+	Buffers.Indices = Asset.Indices.GetData();
+	Buffers.OwnedIndices = nullptr;
+	Buffers.IndexCt = Asset.Indices.Num();
+	Buffers.Is32Bit = true;
+	Buffers.IsGPURead = false;
 	
+	Buffers.DoTransform = DoTransform;
+	if (DoTransform) {
+		Buffers.TForm = TMesh.MeshActor->GetTransform();
+	}
+	return GEOPROC_SUCCESS;
+}
+
+GeometryProcessor::GEOPROC_RESPONSE GeometryProcessor::BuildTriMesh(TriMesh& TMesh, MeshBuffers& Buffers) const {
+	// optionally use passed-in transform
+	if (Buffers.DoTransform) {
+		FVector* Vertices = TMesh.Vertices;
+		const FTransform& TForm = Buffers.TForm;
+		for (uint32 i = 0; i < Buffers.VertexCt; i++) {
+			Vertices[i] = TForm.TransformPosition(Vertices[i]);
+		}
+	}
+	// indices are read where they are, at whatever width the mesh stores them
+	const uint16* Indices16 = (const uint16*)Buffers.Indices;
+	const uint32* Indices32 = (const uint32*)Buffers.Indices;
+	TArray<uint32> Remap;
+	uint32 WeldedCt;
+	const GEOPROC_RESPONSE Response = Buffers.Is32Bit
+		? FixDuplicateVertices(
+			TMesh.Vertices, Indices32, Buffers.IndexCt, Buffers.VertexCt, WeldEpsilon, Remap, WeldedCt
+		)
+		: FixDuplicateVertices(
+			TMesh.Vertices, Indices16, Buffers.IndexCt, Buffers.VertexCt, WeldEpsilon, Remap, WeldedCt
+		);
 	if (Response == GEOPROC_SUCCESS) {
-		// optionally use passed-in transform
-		if (DoTransform) {
-			FVector* Vertices = TMesh.Vertices;
-			const FTransform TForm = TMesh.MeshActor->GetTransform();
-			for (uint32 i = 0; i < VertexCt; i++) {
-				Vertices[i] = TForm.TransformPosition(Vertices[i]);
-			}
+		TMesh.WeldedVertexCt = WeldedCt;
+		if (Buffers.Is32Bit) {
+			Populate(TMesh, Indices32, Buffers.IndexCt, Remap, Buffers.VertexCt);
 		}
-		Response = FixDuplicateVertices(TMesh.Vertices, Indices, IndexCt, VertexCt);
-		if (Response == GEOPROC_SUCCESS) {
-			// populate mesh; fails if any indices outside of reasonable bounds
-			Populate(TMesh, Indices, IndexCt, VertexCt);
+		else {
+			Populate(TMesh, Indices16, Buffers.IndexCt, Remap, Buffers.VertexCt);
 		}
 	}
-
-	if (Response != GEOPROC_SUCCESS) {
-		TMesh.ResetVertexData();
-	}
 	else {
-		
+		TMesh.ResetVertexData();
 	}
-	delete Indices;
+	Buffers.ReleaseIndices();
 	return Response;
 }
 
+void GeometryProcessor::SetWeldEpsilon(float Epsilon) {
+	WeldEpsilon = FMath::Max(Epsilon, 0.0f);
+}
+
+float GeometryProcessor::GetWeldEpsilon() const {
+	return WeldEpsilon;
+}
+
+namespace {
+
+	// union-find root of i, halving the path along the way
+	int FindGroupRoot(TArray<int>& Parents, int i) {
+		while (Parents[i] != i) {
+			Parents[i] = Parents[Parents[i]];
+			i = Parents[i];
+		}
+		return i;
+	}
+
+	// the lower index becomes the root, so roots are always the first mesh of their group
+	void MergeGroups(TArray<int>& Parents, int a, int b) {
+		a = FindGroupRoot(Parents, a);
+		b = FindGroupRoot(Parents, b);
+		if (a < b) {
+			Parents[b] = a;
+		}
+		else if (b < a) {
+			Parents[a] = b;
+		}
+	}
+	
+}
+
 // Does not group Mesh A and Mesh B if Mesh A is entirely inside MeshB, unless Mesh C intersects both
 void GeometryProcessor::GroupTriMeshes(
 	TArray<TriMesh>& TMeshes,
 	TArray<TArray<TriMesh*>>& Groups
 ) {
-	Groups.Reserve(TMeshes.Num());
 	const int InMeshCt = TMeshes.Num();
-	TArray<int> GroupIndices;
-	GroupIndices.Init(-1, InMeshCt);
+	TArray<int> Parents;
+	Parents.SetNumUninitialized(InMeshCt);
+	for (int i = 0; i < InMeshCt; i++) {
+		Parents[i] = i;
+	}
+
+	// broadphase: only meshes whose world-aligned bounds overlap can intersect; pairs come back sorted by first index
+	TArray<uint64> Pairs;
+	Geometry::GetAABBOverlapPairs(TMeshes, Pairs);
+	
+	TArray<int> CandidateIndices;
+	TArray<const BoundingBox*> CandidateBoxes;
+	TArray<int> BoxOverlaps;
 	TArray<int> PotentialIntersectIndices;
 	TArray<int> IntersectIndices;
-	TArray<TriMesh*> Remove;
-	
-	for (int i = 0; i < InMeshCt - 1; i++) {
+	for (int PairIndex = 0; PairIndex < Pairs.Num(); ) {
+		const int i = Pairs[PairIndex] >> 32;
 		TriMesh& TMeshA = TMeshes[i];
 		
-		// if the TMesh already belongs to a group, get the group, otherwise make a group
-		int GrpIndex = GroupIndices[i];
-		if (GrpIndex == -1) {
-			GrpIndex = Groups.Add(TArray<TriMesh*>());
-			GroupIndices[i] = GrpIndex;
-		}
-		
-		// check forward for bbox overlaps
-		for (int j = i + 1; j < InMeshCt; j++) {
-			const int& OtherGrpIndex = GroupIndices[j];
+		// narrowphase on this mesh's pairs: exact box test, then tris
+		for ( ; PairIndex < Pairs.Num() && (int)(Pairs[PairIndex] >> 32) == i; PairIndex++) {
+			const int j = Pairs[PairIndex] & MAX_uint32;
 			// if TMeshA and TMeshB are already grouped, no need to check overlap
-			if (OtherGrpIndex == GrpIndex) {
+			if (FindGroupRoot(Parents, i) == FindGroupRoot(Parents, j)) {
 				continue;
 			}
-			TriMesh& TMeshB = TMeshes[j];
-			if (Geometry::DoBoundingBoxesOverlap(TMeshA.Box, TMeshB.Box)) {
-				PotentialIntersectIndices.Add(j);
-			}
+			CandidateIndices.Add(j);
+			CandidateBoxes.Add(&TMeshes[j].Box);
 		}
-
-		// populate group indices array with indices of mesh intersections
-		if(Geometry::GetTriMeshIntersectGroups(IntersectIndices, PotentialIntersectIndices, TMeshA, TMeshes)) {
+		Geometry::GetOverlappingBoxes(TMeshA.Box, CandidateBoxes, BoxOverlaps);
+		for (int k = 0; k < BoxOverlaps.Num(); k++) {
+			PotentialIntersectIndices.Add(CandidateIndices[BoxOverlaps[k]]);
+		}
+		CandidateIndices.Reset();
+		CandidateBoxes.Reset();
+		BoxOverlaps.Reset();
+		
+		if (Geometry::GetTriMeshIntersectGroups(IntersectIndices, PotentialIntersectIndices, TMeshA, TMeshes)) {
 			for (int j = 0; j < IntersectIndices.Num(); j++) {
-				const int& IndexOfOverlap = IntersectIndices[j];
-				const int OverlapGrpIndex = GroupIndices[IndexOfOverlap];
-				// merge groups if overlapping TMesh belongs to a different group (already checked if in same group)
-				if (OverlapGrpIndex == -1) {
-					GroupIndices[IndexOfOverlap] = GrpIndex;
-				}
-				else {
-					for (int m = 0; m < InMeshCt; m++) {
-						if (GroupIndices[m] == OverlapGrpIndex) {
-							GroupIndices[m] = GrpIndex;
-						}	
-					}
-				}
-			}	
+				MergeGroups(Parents, i, IntersectIndices[j]);
+			}
 		}
-
-		PotentialIntersectIndices.Empty(InMeshCt);
-		IntersectIndices.Empty(InMeshCt);
-	}
-	// the very last mesh may be an island (no overlaps)
-	const int EndIndex = InMeshCt - 1;
-	if (GroupIndices[EndIndex] == -1) {
-		GroupIndices[EndIndex] = Groups.Add(TArray<TriMesh*>());
+		PotentialIntersectIndices.Reset();
+		IntersectIndices.Reset();
 	}
 
-	// populate groups with known group indices
+	// populate groups in mesh order; a group is made when its first (root) mesh comes up
+	TArray<int> GroupIndices;
+	GroupIndices.Init(-1, InMeshCt);
+	Groups.Reserve(InMeshCt);
 	for (int i = 0; i < InMeshCt; i++) {
-		const int& GrpIndex = GroupIndices[i];
-		Groups[GrpIndex].Add(&TMeshes[i]);
-	}
-	
-	for (int i = 0; ; ) {
-		if (i >= Groups.Num()) {
-			break;
-		}
-		if (Groups[i].Num() == 0) {
-			Groups.RemoveAtSwap(i);
-		}
-		else {
-			i++;
+		const int Root = FindGroupRoot(Parents, i);
+		if (GroupIndices[Root] == -1) {
+			GroupIndices[Root] = Groups.Add(TArray<TriMesh*>());
 		}
+		Groups[GroupIndices[Root]].Add(&TMeshes[i]);
 	}
 	
 	UNavDbg::PrintTriMeshIntersectGroups(Groups);
@@ -154,23 +258,32 @@ void GeometryProcessor::GroupTriMeshes(
 void GeometryProcessor::ReformTriMesh(
 	TArray<TriMesh*>* Group, FCriticalSection* Mutex, const FThreadSafeBool* IsThreadRun, UNavMesh* NMesh
 ) {
-	TArray<TArray<Polygon>> Polygons;
-	auto& GroupRef = *Group;
-	// SimplifyTriMesh()
-	FlagTrisWithBV(GroupRef);
-	if (!IsThreadRun) {
-		return;
-	}
-	BuildPolygonsAtMeshIntersections(GroupRef, Polygons, Mutex);
-	if (!IsThreadRun) {
-		return;
+	// polygon building scratch (intersection edges, polygon graphs, ear clipping arrays) is all dropped once the
+	// group's mesh is formed, so it comes from an arena kept per thread and reset per group instead of the heap. The
+	// reset frees blocks past ScratchArena::MAX_KEPT_BYTES, so idle workers don't keep their largest group's peak
+	static thread_local ScratchArena Arena;
+	{
+		const ScratchArena::Scope Scope(&Arena);
+		TArray<TArray<Polygon>> Polygons;
+		auto& GroupRef = *Group;
+		// SimplifyTriMesh()
+		FlagTrisWithBV(GroupRef);
+		if (*IsThreadRun) {
+			BuildPolygonsAtMeshIntersections(GroupRef, Polygons, Mutex);
+			if (*IsThreadRun) {
+				FormMeshFromGroup(GroupRef, Polygons, NMesh, Mutex);
+			}
+		}
 	}
-	FormMeshFromGroup(GroupRef, Polygons, NMesh, Mutex);
+#ifdef UNAV_DEV
+	UNavDbg::PrintScratchArenaStats(*Group, Arena, Mutex);
+#endif
+	Arena.Reset();
 }
 
 int GeometryProcessor::GetMeshBatch(
 	TArray<TArray<Tri*>>& BatchTris,
-	const TriMesh& TMesh,
+	TriMesh& TMesh,
 	int& StartTriIndex,
 	int BatchSz,
 	uint16 BatchNo
@@ -182,7 +295,7 @@ int GeometryProcessor::GetMeshBatch(
 		return GEOPROC_BATCH_SZ_LEQ_0;
 	}
 	
-	const TriGrid& Grid = TMesh.Grid;
+	TriGrid& Grid = TMesh.Grid;
 	const int GridCt = Grid.Num();
 	if (StartTriIndex < 0 || StartTriIndex >= GridCt) {
 		return GEOPROC_BAD_START_TRI;
@@ -204,7 +317,7 @@ int GeometryProcessor::GetMeshBatch(
 		// new group (within batch)
 		const uint32 PrevStartTriIndex = StartTriIndex;
 		Tri& StartTri = Grid[StartTriIndex];
-		const FVector& GrpTriNormal = StartTri.Normal;
+		const FVector& GrpTriNormal = Grid.GetNormal(StartTriIndex);
 		const int GrpIndex = BatchTris.Add(TArray<Tri*>());
 		const int GrpNum = GrpIndex + 1;
 		if (GrpIndex >= Tri::MAX_GROUP_CT) {
@@ -230,9 +343,6 @@ int GeometryProcessor::GetMeshBatch(
 				BFSTri.SetGroup(GrpNum);
 				++TriCt;
 				
-				const int NeighborCt = GetNeighbors(
-					Grid, BatchSz, BFSTri, TriCt, OnlyAssignNeighbors, BatchFinished
-				);
 				if (TriCt >= BatchSz) {
 					GetNewStartTriIndex(Grid, StartTriIndex);
 					goto BATCH_END_PROCESSING;
@@ -240,15 +350,18 @@ int GeometryProcessor::GetMeshBatch(
 				if (OnlyAssignNeighbors) {
 					continue;
 				}
-				// iterating over neighbors...
-				for (int j = 0; j < NeighborCt; j++) {
-					Tri* Neighbor = BFSTri.Neighbors[j];
+				// iterating over neighbors, which TriGrid::Init() has already found...
+				for (int j = Tri::AB; j <= Tri::CA; j++) {
+					const uint32 TIndex = Grid.GetNeighbor(BFSTriIndex, j);
+					if (TIndex == TriGrid::NO_NEIGHBOR) {
+						continue;
+					}
+					Tri* Neighbor = &Grid[TIndex];
 					// checking if they're already part of a group or have been searched by this group...
 					if (!Neighbor->IsSearched()) {
-						const int TIndex = Grid.GetIndex(Neighbor);
 						Neighbor->SetSearched();
 						// and checking if this neighbor's normal is similar enough to start tri's to be added to the group
-						const float CosPhi = FVector::DotProduct(GrpTriNormal, Neighbor->Normal);
+						const float CosPhi = FVector::DotProduct(GrpTriNormal, Grid.GetNormal(TIndex));
 						// not && CosPhi... because TempSearched have their searched flags unset
 						if (CosPhi > DEVIATION_CUTOFF) {
 							BFSTrisNext.Add(TIndex); // this neighbor will become an outer member (a search node)
@@ -299,8 +412,6 @@ int GeometryProcessor::GetMeshBatch(
 		auto& Group = BatchTris[i];
 		const uint16 GrpNum = i + 1;
 		for (const auto T : Group) {
-			check(T->Neighbors.Num() == 3);
-			T->OrganizeNeighbors();
 			T->ClearFlags();
 			T->SetSearched();
 			T->SetBatch(BatchNo);
@@ -325,7 +436,12 @@ int GeometryProcessor::GetMeshBatch(
 	return TriCt;
 }
 
-void GeometryProcessor::SimplifyMeshBatch(TArray<TArray<Tri*>>& BatchTris, const TriMesh& TMesh, uint16 BatchNo) {
+void GeometryProcessor::SimplifyMeshBatch(
+	TArray<TArray<Tri*>>& BatchTris,
+	TriMesh& TMesh,
+	uint16 BatchNo,
+	TArray<VBufferPolygon>& Polygons
+) {
 	//		create polygon group array
 	//		per tri group:
 	//			form a polygon with the edge of group
@@ -343,21 +459,22 @@ void GeometryProcessor::SimplifyMeshBatch(TArray<TArray<Tri*>>& BatchTris, const
 	
 	// create polygons from group edges
 	const int BatchTriCt = BatchTris.Num();
-	TArray<VBufferPolygon> Polygons;
 	for (int i = 0; i < BatchTriCt; i++) {
 		TArray<Tri*>& Group = BatchTris[i];
 		VBufferUnstructuredPolygon UPoly;
 		
 		const uint16 GroupNo = i + 1;
 		for (const auto T : Group) {
+			const int TIndex = TMesh.Grid.GetIndex(T);
 			for (int j = Tri::AB; j <= Tri::CA; j++) { // 0 to 2, inclusive
-				Tri* Neighbor = T->Neighbors[j];
-				if (
-					Neighbor != nullptr
-					&& (Neighbor->GetGroup() != GroupNo || Neighbor->GetBatch() != BatchNo) 
-				) {
+				const uint32 NIndex = TMesh.Grid.GetNeighbor(TIndex, j);
+				if (NIndex == TriGrid::NO_NEIGHBOR) {
+					continue;
+				}
+				Tri* Neighbor = &TMesh.Grid[NIndex];
+				if (Neighbor->GetGroup() != GroupNo || Neighbor->GetBatch() != BatchNo) {
 					// find neighbors who are either not in this batch or in the same batch, but another group
-					AddVBufferUPolyEdge(UPoly, *T, j, Neighbor);
+					AddVBufferUPolyEdge(UPoly, TMesh.Grid, TIndex, j, Neighbor);
 				}
 			}
 		}
@@ -372,24 +489,45 @@ void GeometryProcessor::SimplifyMeshBatch(TArray<TArray<Tri*>>& BatchTris, const
 			}
 		}
 	}
-	UNavDbg::DrawVBufferPolygons(GEditor->GetEditorWorldContext().World(), Polygons);
-	for (auto& P : Polygons) {
-		P.Empty();
-	}
 }
 
-uint16* GeometryProcessor::GetIndices(const FStaticMeshLODResources& LOD, uint32& IndexCt) const {
-	IndexCt = LOD.IndexBuffer.IndexBufferRHI->GetSize() / sizeof(uint16);
-	uint16* TriIndices = new uint16[IndexCt];
+GeometryProcessor::GEOPROC_RESPONSE GeometryProcessor::GetIndices(
+	const FStaticMeshLODResources& LOD,
+	MeshBuffers& Buffers
+) const {
+	const FRawStaticIndexBuffer* IndBuf = &LOD.IndexBuffer;
+	Buffers.IsGPURead = false;
+	Buffers.Is32Bit = IndBuf->Is32Bit();
+	
+	// the index buffer keeps a cpu copy unless it was thrown away after upload; it's read in place
+	const FIndexArrayView IndexView = IndBuf->GetArrayView();
+	if (IndexView.Num() > 0) {
+		Buffers.IndexCt = IndexView.Num();
+		if (Buffers.Is32Bit) {
+			Buffers.Indices = IndBuf->AccessStream32();
+		}
+		else {
+			Buffers.Indices = IndBuf->AccessStream16();
+		}
+		return GEOPROC_SUCCESS;
+	}
+	if (GPUReadUnavailable()) {
+		return GEOPROC_NO_MESH_DATA;
+	}
+
+	const uint32 IndexBufferSz = IndBuf->IndexBufferRHI->GetSize();
+	Buffers.IndexCt = IndexBufferSz / (Buffers.Is32Bit ? sizeof(uint32) : sizeof(uint16));
+	uint8* TriIndices = new uint8[IndexBufferSz];
 	if (TriIndices == nullptr) {
-		return nullptr;
+		return GEOPROC_ALLOC_FAIL;
 	}
-	const FRawStaticIndexBuffer* IndBuf = &LOD.IndexBuffer;
+	Buffers.OwnedIndices = TriIndices;
+	Buffers.Indices = TriIndices;
 
-	// Asking the GPU to kindly relinquish the goods
+	// Asking the GPU to kindly relinquish the goods; the caller flushes
 	ENQUEUE_RENDER_COMMAND(GetIndexBuffer) (
 		[TriIndices, IndBuf] (FRHICommandList& RHICmd) {
-			const uint16* Indices = (uint16*)RHILockIndexBuffer(
+			const void* Indices = RHILockIndexBuffer(
 				IndBuf->IndexBufferRHI,
 				0,
 				IndBuf->IndexBufferRHI->GetSize(),
@@ -399,26 +537,39 @@ uint16* GeometryProcessor::GetIndices(const FStaticMeshLODResources& LOD, uint32
 			RHIUnlockIndexBuffer(IndBuf->IndexBufferRHI);
 		}
 	);
-	FlushRenderingCommands(); 
+	Buffers.IsGPURead = true;
 	
-	return TriIndices;
+	return GEOPROC_SUCCESS;
 }
 
 GeometryProcessor::GEOPROC_RESPONSE GeometryProcessor::GetVertices(
 	const FStaticMeshLODResources& LOD,
 	TriMesh& TMesh,
-	uint32& VertexCt
+	uint32& VertexCt,
+	bool& IsGPURead
 ) const {
-	VertexCt = LOD.VertexBuffers.PositionVertexBuffer.GetNumVertices();
+	IsGPURead = false;
+	const FPositionVertexBuffer* PosBuf = &LOD.VertexBuffers.PositionVertexBuffer;
+	const void* CPUVertices = PosBuf->GetVertexData();
+	if (CPUVertices == nullptr && GPUReadUnavailable()) {
+		return GEOPROC_NO_MESH_DATA;
+	}
+	
+	VertexCt = PosBuf->GetNumVertices();
 	TMesh.Vertices = new FVector[VertexCt];
 	TMesh.Grid.SetVertices(TMesh.Vertices);
 	if (TMesh.Vertices == nullptr) {
 		return GEOPROC_ALLOC_FAIL;
 	}
 	FVector* Vertices = TMesh.Vertices;
-	const FPositionVertexBuffer* PosBuf = &LOD.VertexBuffers.PositionVertexBuffer;
+
+	// the position buffer keeps a cpu copy unless it was thrown away after upload
+	if (CPUVertices != nullptr) {
+		memcpy(Vertices, CPUVertices, VertexCt * sizeof(FVector));
+		return GEOPROC_SUCCESS;
+	}
 	
-	// Asking the GPU to kindly relinquish the goods
+	// Asking the GPU to kindly relinquish the goods; the caller flushes
 	ENQUEUE_RENDER_COMMAND(GetPositionVertexBuffer) (
 		[Vertices, PosBuf] (FRHICommandList& rhi_cmd) {
 			const FVector* Verts = (FVector*)RHILockVertexBuffer(
@@ -431,34 +582,12 @@ GeometryProcessor::GEOPROC_RESPONSE GeometryProcessor::GetVertices(
 			RHIUnlockVertexBuffer(PosBuf->VertexBufferRHI);
 		}
 	);
-	FlushRenderingCommands();
+	IsGPURead = true;
 
 	return GEOPROC_SUCCESS;
 }
 
-int GeometryProcessor::GetNeighbors(
-	const TriGrid& Grid, int BatchSz, Tri& T, int& TriCt, bool& OnlyAssignNeighbors, bool& BatchFinished
-) {
-	uint32 BFSTriVIndices[3];
-	const int TriIndex = Grid.GetIndex(&T);
-	Grid.GetVIndices(TriIndex, BFSTriVIndices);
-	
-	uint32 NeighborFlags = 0x0;
-	Tri* Neighbors[3] {nullptr};
-	const int NeighborCt = Geometry::GetNeighborTris(
-		Grid, TriIndex, BFSTriVIndices, Neighbors, NeighborFlags
-	);
-	
-	T.AddFlags(NeighborFlags);
-	
-	for (int j = 0; j < NeighborCt; j++) {
-		Tri* Neighbor = Neighbors[j];
-		T.Neighbors.Add(Neighbor);
-	}
-	return NeighborCt;
-}
-
-Tri* GeometryProcessor::GetUnbatchedTri(const TriGrid& Grid) {
+const Tri* GeometryProcessor::GetUnbatchedTri(const TriGrid& Grid) {
 	for (int i = 0; i < Grid.Num(); i++) {
 		auto& T = Grid[i];
 		if (!T.IsInBatch()) {
@@ -468,7 +597,7 @@ Tri* GeometryProcessor::GetUnbatchedTri(const TriGrid& Grid) {
 	return nullptr;
 }
 
-Tri* GeometryProcessor::GetUngroupedTri(const TriGrid& Grid) {
+const Tri* GeometryProcessor::GetUngroupedTri(const TriGrid& Grid) {
 	for (int i = 0; i < Grid.Num(); i++) {
 		auto& T = Grid[i];
 		if (!T.IsInGroup()) {
@@ -489,16 +618,18 @@ bool GeometryProcessor::GetNewStartTriIndex(const TriGrid& Grid, int& StartTriIn
 	return false;
 }
 
-void GeometryProcessor::AddVBufferUPolyEdge(VBufferUnstructuredPolygon& UPoly, const Tri& T, int Side, Tri* Neighbor) {
+void GeometryProcessor::AddVBufferUPolyEdge(
+	VBufferUnstructuredPolygon& UPoly, TriGrid& Grid, int TriIndex, int Side, Tri* Neighbor
+) {
 	switch(Side) {
 	case Tri::AB:
-		UPoly.Edges.Add(VBufferPolyEdge(&T.A, &T.B, Neighbor));
+		UPoly.Edges.Add(VBufferPolyEdge(&Grid.GetA(TriIndex), &Grid.GetB(TriIndex), Neighbor));
 		break;
 	case Tri::BC:
-		UPoly.Edges.Add(VBufferPolyEdge(&T.B, &T.C, Neighbor));
+		UPoly.Edges.Add(VBufferPolyEdge(&Grid.GetB(TriIndex), &Grid.GetC(TriIndex), Neighbor));
 		break;
 	case Tri::CA:
-		UPoly.Edges.Add(VBufferPolyEdge(&T.C, &T.A, Neighbor));
+		UPoly.Edges.Add(VBufferPolyEdge(&Grid.GetC(TriIndex), &Grid.GetA(TriIndex), Neighbor));
 		break;
 	default:
 		check(Side < Tri::AB || Side > Tri::CA);
@@ -603,47 +734,123 @@ void GeometryProcessor::SmoothPolygon(VBufferPolygon& Polygon, float Sigma, int
 	}	
 }
 
+template<typename IndexType>
 GeometryProcessor::GEOPROC_RESPONSE GeometryProcessor::FixDuplicateVertices(
-	FVector* Vertices, uint16* Indices, uint32 IndexCt, uint32 VertexCt
+	const FVector* Vertices,
+	const IndexType* Indices,
+	uint32 IndexCt,
+	uint32 VertexCt,
+	float Epsilon,
+	TArray<uint32>& Remap,
+	uint32& WeldedCt
 ) {
+	WeldedCt = 0;
 	for (uint32 i = 0; i < IndexCt; i++) {
-		const uint16& Index = Indices[i];
-		if (Index >= VertexCt) {
+		if (Indices[i] >= VertexCt) {
 			return GEOPROC_HIGH_INDEX;	
 		}
 	}
-	for (uint32 i = 0; i < VertexCt - 1; i++) {
-		FVector& A = Vertices[i];
-		for (uint32 j = i + 1; j < VertexCt; j++) {
-			FVector& B = Vertices[j];
-			if (A == B) {
-				for (uint32 k = 0; k < IndexCt; k++) {
-					if (Indices[k] == j) {
-						Indices[k] = i;
+	// the index buffer may belong to the mesh, so it's left alone; Populate() reads indices through Remap instead
+	BuildWeldRemap(Vertices, VertexCt, Epsilon, Remap, WeldedCt);
+	return GEOPROC_SUCCESS;
+}
+
+// Vertices are hashed into cells at least Epsilon wide, so any vertex within Epsilon of another lies in the same cell
+// or one of the 26 around it. Only vertices that weren't welded are put in cells, which keeps each vertex's search
+// short and means vertices always weld to a vertex that is kept.
+void GeometryProcessor::BuildWeldRemap(
+	const FVector* Vertices, uint32 VertexCt, float Epsilon, TArray<uint32>& Remap, uint32& WeldedCt
+) {
+	constexpr uint32 NO_VERTEX = MAX_uint32;
+	// cells per axis across the mesh, with headroom below MAX_int32 for float rounding and the +-1 neighbor cells
+	constexpr float MAX_CELL_COORD = 1 << 30;
+	
+	// cell coordinates are taken from the mesh's min corner and the cell size is grown until the mesh's extent fits
+	// in MAX_CELL_COORD cells, so a tiny Epsilon on a large mesh can't overflow them; cells only get wider than
+	// Epsilon, so the 26-cell search still finds everything
+	FVector Min(MAX_FLT);
+	FVector Max(-MAX_FLT);
+	for (uint32 i = 0; i < VertexCt; i++) {
+		Min = Min.ComponentMin(Vertices[i]);
+		Max = Max.ComponentMax(Vertices[i]);
+	}
+	const float Extent = VertexCt > 0 ? (Max - Min).GetMax() : 0.0f;
+	const float CellSz = FMath::Max3(Epsilon, Extent / MAX_CELL_COORD, KINDA_SMALL_NUMBER);
+	const float InvCellSz = 1.0f / CellSz;
+	const float EpsilonSq = Epsilon * Epsilon;
+
+	// each cell holds the first kept vertex in a chain; NextInCell links the rest of the cell's kept vertices
+	TMap<FIntVector, uint32> CellHeads;
+	CellHeads.Reserve(VertexCt);
+	TArray<uint32> NextInCell;
+	NextInCell.Init(NO_VERTEX, VertexCt);
+	Remap.SetNumUninitialized(VertexCt);
+	WeldedCt = 0;
+
+	for (uint32 i = 0; i < VertexCt; i++) {
+		const FVector& V = Vertices[i];
+		const FIntVector Cell(
+			FMath::FloorToInt((V.X - Min.X) * InvCellSz),
+			FMath::FloorToInt((V.Y - Min.Y) * InvCellSz),
+			FMath::FloorToInt((V.Z - Min.Z) * InvCellSz)
+		);
+		
+		uint32 WeldTo = NO_VERTEX;
+		for (int x = -1; x <= 1 && WeldTo == NO_VERTEX; x++) {
+			for (int y = -1; y <= 1 && WeldTo == NO_VERTEX; y++) {
+				for (int z = -1; z <= 1 && WeldTo == NO_VERTEX; z++) {
+					const uint32* Head = CellHeads.Find(Cell + FIntVector(x, y, z));
+					if (Head == nullptr) {
+						continue;
+					}
+					for (uint32 j = *Head; j != NO_VERTEX; j = NextInCell[j]) {
+						if (FVector::DistSquared(V, Vertices[j]) <= EpsilonSq) {
+							WeldTo = j;
+							break;
+						}
 					}
 				}
 			}
 		}
+		
+		if (WeldTo != NO_VERTEX) {
+			Remap[i] = WeldTo;
+			++WeldedCt;
+			continue;
+		}
+		Remap[i] = i;
+		uint32* Head = CellHeads.Find(Cell);
+		if (Head != nullptr) {
+			NextInCell[i] = *Head;
+			*Head = i;
+		}
+		else {
+			CellHeads.Add(Cell, i);
+		}
 	}
-	return GEOPROC_SUCCESS;
 }
 
-void GeometryProcessor::Populate(TriMesh& TMesh, uint16* Indices, uint32 IndexCt, uint32 VertexCt) {
-	// Vertices[Indices[0]] = Tri0.A, Vertices[Indices[1]] = Tri0.B, Vertices[Indices[2]] = Tri0.C,
-	// Vertices[Indices[3]] = Tri1.A ... and so on
+template<typename IndexType>
+void GeometryProcessor::Populate(
+	TriMesh& TMesh, const IndexType* Indices, uint32 IndexCt, const TArray<uint32>& Remap, uint32 VertexCt
+) {
+	// Vertices[Remap[Indices[0]]] = Tri0.A, Vertices[Remap[Indices[1]]] = Tri0.B, Vertices[Remap[Indices[2]]] = Tri0.C,
+	// Vertices[Remap[Indices[3]]] = Tri1.A ... and so on
 	
-	const uint32 VEnd = IndexCt - 3;
+	const uint32 TriCt = IndexCt / 3;
 	FVector* Vertices = TMesh.Vertices;
 	TArray<TempTri> Tris;
-	for (uint16* IndexPtr = Indices; (IndexPtr - Indices) <= VEnd; ) {
-		FVector* A = &Vertices[*IndexPtr++];
-		FVector* B = &Vertices[*IndexPtr++];
-		FVector* C = &Vertices[*IndexPtr++];
+	Tris.Reserve(TriCt);
+	for (const IndexType* IndexPtr = Indices; IndexPtr < Indices + TriCt * 3; ) {
+		FVector* A = &Vertices[Remap[*IndexPtr++]];
+		FVector* B = &Vertices[Remap[*IndexPtr++]];
+		FVector* C = &Vertices[Remap[*IndexPtr++]];
 		TempTri T(A, B, C);
 		Tris.Add(T);
 	}
 	TMesh.VertexCt = VertexCt;
 	TMesh.Grid.Init(TMesh, Tris);
+	TMesh.BVH.Build(TMesh.Grid);
 }
 
 void GeometryProcessor::FlagTrisWithBV(TArray<TriMesh*>& TMeshes) {
@@ -667,10 +874,7 @@ void GeometryProcessor::BuildPolygonsAtMeshIntersections(
 	TArray<TArray<Polygon>>& GroupPolygons,
 	FCriticalSection* Mutex
 ) {
-	const auto& Grid = Data::BoundsVolumeTMesh.Grid;
-	for (int i = 0; i < Grid.Num(); i++) {
-		Grid[i].Normal = -Grid[i].Normal;
-	}
+	Data::BoundsVolumeTMesh.Grid.FlipNormals();
 	
 	TArray<TArray<UnstructuredPolygon>> UPolys;
 
@@ -700,7 +904,7 @@ void GeometryProcessor::BuildPolygonsAtMeshIntersections(
 		for (int k = 0; k < MeshUPolys.Num(); k++) {
 			Tri& T = TMesh.Grid[k];
 
-			TArray<UPolyNode> PolygonNodes;
+			TScratchArray<UPolyNode> PolygonNodes;
 			if (T.IsCull()) {
 				// Tris are marked for cull early if they fall outside of the bounds box
 				continue;
@@ -717,7 +921,7 @@ void GeometryProcessor::BuildPolygonsAtMeshIntersections(
 					T.MarkProblemCase();
 					T.MarkForCull();
 					FScopeLock Lock(Mutex);
-					Data::FailureCaseTris.Add(&T);
+					Data::FailureCaseTris.Append({TMesh.Grid.GetA(k), TMesh.Grid.GetB(k), TMesh.Grid.GetC(k)});
 				}	
 				continue;
 			}
@@ -725,14 +929,14 @@ void GeometryProcessor::BuildPolygonsAtMeshIntersections(
 			// creating graphs where edges (intersections and tri edges) connect, and where they're visible
 			PopulateNodes(T, UPoly, PolygonNodes);
 			
-			Polygonize(T, PolygonNodes, TMeshPolygons, k);
+			Polygonize(T, TMesh.Grid.GetNormal(k), PolygonNodes, TMeshPolygons, k);
 			
 			// TODO: each tri might come out with more than one polygon; for example, a set of intersections in the center...
 			// TODO: ... of the tri that do not touch tri edges - one outside, one inside; but, we start with one...
 			// TODO: ... add if ever touches edge, else subtract unless enclosed by subtract polygon
 			if (T.IsCull() || T.IsProblemCase()) {
 				FScopeLock Lock(Mutex);
-				Data::FailureCaseTris.Add(&T);
+				Data::FailureCaseTris.Append({TMesh.Grid.GetA(k), TMesh.Grid.GetB(k), TMesh.Grid.GetC(k)});
 			}
 		}
 	}
@@ -814,23 +1018,27 @@ void GeometryProcessor::FormMeshFromGroup(
 	NMesh->Vertices = NewVertexBuffer;
 	NMesh->VertexCt = NewVertCt;
 	Geometry::SetBoundingBox(*NMesh, Group);
-	NMesh->Grid.Init(*NMesh, NewTris);
 	NMesh->Grid.SetVertices(NewVertexBuffer);
+	NMesh->Grid.Init(*NMesh, NewTris);
+	NMesh->BVH.Build(NMesh->Grid);
+	NMesh->Hierarchy.Build(*NMesh);
 	for (const auto& TMesh : Group) {
 		NMesh->MeshActors.Add(TMesh->MeshActor);	
 	}
 		
 }
 
-void GeometryProcessor::PopulateNodes(const Tri& T, const UnstructuredPolygon& UPoly, TArray<UPolyNode>& PolygonNodes) {
-	const TArray<PolyEdge>& Edges = UPoly.Edges;
-	TArray<const PolyEdge*> RecheckEdges;
+void GeometryProcessor::PopulateNodes(
+	const Tri& T, const UnstructuredPolygon& UPoly, TScratchArray<UPolyNode>& PolygonNodes
+) {
+	const TScratchArray<PolyEdge>& Edges = UPoly.Edges;
+	TScratchArray<const PolyEdge*> RecheckEdges;
 	const int InitNodeCt = PolygonNodes.Num();
 	int AddedNodes = 0;
 	
 	for (int i = 0; i < Edges.Num(); i++) {
 		const PolyEdge& PEdge = Edges[i];
-		const TArray<FVector>& ObscuredLocations = PEdge.ObscuredLocations;
+		const TScratchArray<FVector>& ObscuredLocations = PEdge.ObscuredLocations;
 		if (ObscuredLocations.Num() == 0) {
 			// if A is not enclosed here, so is B, so create 2 nodes. if both enclosed, create none.
 			if (!PEdge.IsAEnclosed()) {
@@ -912,7 +1120,9 @@ bool GeometryProcessor::DoesEdgeConnect(const TArrayView<UPolyNode>& Nodes, cons
 	return false;
 }
 
-void GeometryProcessor::AddUPolyNodes(TArray<UPolyNode>& Nodes, const FVector& A, const FVector& B, int& NodeCtr) {
+void GeometryProcessor::AddUPolyNodes(
+	TScratchArray<UPolyNode>& Nodes, const FVector& A, const FVector& B, int& NodeCtr
+) {
 	int i0 = -1;
 	int i1 = -1;
 	for (int i = 0; i < Nodes.Num(); i++) {
@@ -945,7 +1155,8 @@ void GeometryProcessor::AddUPolyNodes(TArray<UPolyNode>& Nodes, const FVector& A
 
 void GeometryProcessor::Polygonize(
 	Tri& T,
-	TArray<UPolyNode>& PolygonNodes,
+	FVector& Normal,
+	TScratchArray<UPolyNode>& PolygonNodes,
 	TArray<Polygon>& TMeshPolygons,
 	int TriIndex
 ) {
@@ -962,7 +1173,7 @@ void GeometryProcessor::Polygonize(
 	// loops that can be used to form polygon(s)
 	for (int StartIndex = 0; StartIndex < NodeCt; ) {
 		UPolyNode& StartNode = PolygonNodes[StartIndex];
-		TArray<int>* EdgeIndices = &StartNode.Edges;
+		TScratchArray<int>* EdgeIndices = &StartNode.Edges;
 		
 		// check to make sure the node isn't exhausted
 		if (EdgeIndices->Num() == 0) {
@@ -970,7 +1181,7 @@ void GeometryProcessor::Polygonize(
 			continue;
 		}
 		
-		Polygon BuildingPolygon(TriIndex, T.Normal);
+		Polygon BuildingPolygon(TriIndex, Normal);
 		BuildingPolygon.Vertices.Add(PolyNode(StartNode.Location));
 		int PrevIndex = StartIndex;
 		
@@ -985,7 +1196,7 @@ void GeometryProcessor::Polygonize(
 				}
 				if (BuildingPolygon.Vertices.Num() >= 3) {
 					T.MarkForPolygon();	
-					TMeshPolygons.Add(BuildingPolygon);
+					TMeshPolygons.Add(MoveTemp(BuildingPolygon));
 				}
 				break;
 			}
@@ -1023,7 +1234,7 @@ void GeometryProcessor::PopulateUnmarkedTriData(
 	int SliceStart = 0;
 	for (int j = 0; j < Group.Num(); j++) {
 		const auto& TMesh = Group[j];
-		const auto& Grid = TMesh->Grid;
+		auto& Grid = TMesh->Grid;
 
 		// finding first fully exposed tri on mesh to add, because Slicing the Vertex Array (in next step) requires
 		// at least one item in the slice
@@ -1033,9 +1244,9 @@ void GeometryProcessor::PopulateUnmarkedTriData(
 		for ( ; StartK < GridCt; StartK++) {
 			const auto& T = Grid[StartK];
 			if (!T.IsChanged()) {
-				const int AIndex = TempVertices.Add(&T.A);
-				const int BIndex = TempVertices.Add(&T.B);
-				const int CIndex = TempVertices.Add(&T.C);
+				const int AIndex = TempVertices.Add(&Grid.GetA(StartK));
+				const int BIndex = TempVertices.Add(&Grid.GetB(StartK));
+				const int CIndex = TempVertices.Add(&Grid.GetC(StartK));
 				TempTriVertexIndices.Add(FIntVector(AIndex, BIndex, CIndex));
 				VerticesAdded += 3;
 				StartK++;
@@ -1056,25 +1267,28 @@ void GeometryProcessor::PopulateUnmarkedTriData(
 			if (!Tri.IsChanged()) {
 				TArrayView<FVector*> TempVerticesSlice =
 					TArrayView<FVector*>(TempVertices).Slice(SliceStart, VerticesAdded);
-				int AIndex = TempVerticesSlice.Find(&Tri.A);
+				FVector* A = &Grid.GetA(k);
+				int AIndex = TempVerticesSlice.Find(A);
 				if (AIndex == -1) {
-					AIndex = TempVertices.Add(&Tri.A);
+					AIndex = TempVertices.Add(A);
 					VerticesAdded++;
 				}
 				else {
 					AIndex += SliceStart;
 				}
-				int BIndex = TempVerticesSlice.Find(&Tri.B);
+				FVector* B = &Grid.GetB(k);
+				int BIndex = TempVerticesSlice.Find(B);
 				if (BIndex == -1) {
-					BIndex = TempVertices.Add(&Tri.B);
+					BIndex = TempVertices.Add(B);
 					VerticesAdded++;
 				}
 				else {
 					BIndex += SliceStart;
 				}
-				int CIndex = TempVerticesSlice.Find(&Tri.C);
+				FVector* C = &Grid.GetC(k);
+				int CIndex = TempVerticesSlice.Find(C);
 				if (CIndex == -1) {
-					CIndex = TempVertices.Add(&Tri.C);
+					CIndex = TempVertices.Add(C);
 					VerticesAdded++;
 				}
 				else {
@@ -1095,9 +1309,10 @@ void GeometryProcessor::Triangulize(
 	TArray<FIntVector>& TriVertexIndices,
 	TArray<FVector*>& Normals
 ) {
-	TArray<Geometry::VERTEX_T> VertTypes;
+	TScratchArray<Geometry::VERTEX_T> VertTypes;
+	TArray<FIntVector> TempTriVertexIndices;
 	for (auto& Polygon : Polygons) {
-		TArray<PolyNode>& PolyVerts = Polygon.Vertices;
+		TScratchArray<PolyNode>& PolyVerts = Polygon.Vertices;
 		const int PolyVertCt = PolyVerts.Num();
 		const int AddVerticesOffset = Vertices.Num();
 
@@ -1115,8 +1330,8 @@ void GeometryProcessor::Triangulize(
 		double LongestDistSq = DBL_MIN;
 		int LongestDistIndex = -1;
 		
-		TArray<bool> IsEar;
-		TArray<FVector> NextVertVec;
+		TScratchArray<bool> IsEar;
+		TScratchArray<FVector> NextVertVec;
 		IsEar.Init(false, PolyVertCt);
 		NextVertVec.Reserve(PolyVertCt);
 		
@@ -1158,7 +1373,7 @@ void GeometryProcessor::Triangulize(
 
 		int AvailableCt = PolyVertCt;
 		bool FillSuccess = false;
-		TArray<FIntVector> TempTriVertexIndices;
+		TempTriVertexIndices.Reset();
 
 		const PolyNode* WalkNode = &PolyVerts[0];
 		for (int FailCt = 0; FailCt < AvailableCt; ) {
@@ -1216,12 +1431,15 @@ void GeometryProcessor::Triangulize(
 				Vertices.Add(PolyVerts[i].Location);
 			}
 			TriVertexIndices.Append(TempTriVertexIndices);
-			TArray<FVector*> TriNormals;
-			TriNormals.Init(&Polygon.Normal, TempTriVertexIndices.Num());
-			Normals.Append(TriNormals);
+			for (int i = 0; i < TempTriVertexIndices.Num(); i++) {
+				Normals.Add(&Polygon.Normal);
+			}
 		}
 		else {
-			Data::FailureCasePolygons.Add(Polygon);
+			// kept past the arena's reset, so copied onto the heap; the copy's links would still point into the
+			// original
+			const ScratchArena::Scope HeapScope(nullptr);
+			LinkPolygonEdges(Data::FailureCasePolygons.Add_GetRef(Polygon));
 		}
 	}
 }
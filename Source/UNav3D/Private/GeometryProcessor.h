@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include "ScratchArena.h"
+
 struct VBufferUnstructuredPolygon;
 struct PolyEdge;
 struct PolyNode;
@@ -13,6 +15,7 @@ struct UNavMesh;
 struct VBufferPolygon;
 struct VBufferPolyNode;
 class TriGrid;
+struct MeshAssetEntry;
 
 // GeometryProcessor's job to work on geometrical objects, given information learned by using Geometry.h
 class GeometryProcessor {
@@ -26,7 +29,8 @@ public:
 		GEOPROC_BATCH_SZ_LEQ_0=-3,
 		GEOPROC_BAD_BATCH_SZ=-4,
 		GEOPROC_BAD_START_TRI=-5,
-		GEOPROC_MAXED_GROUPS=-6
+		GEOPROC_MAXED_GROUPS=-6,
+		GEOPROC_NO_MESH_DATA=-7
 	};
 
 	GeometryProcessor();
@@ -34,21 +38,73 @@ public:
 	
 	static int GetMeshBatch(
 		TArray<TArray<Tri*>>& BatchTris,
-		const TriMesh& TMesh,
+		TriMesh& TMesh,
 		int& StartTriIndex,
 		int BatchSz,
 		uint16 BatchNo
 	);
 
+	// Polygons gets the batch's group outlines appended; they point into TMesh's vertices and are the caller's to
+	// Empty(). This runs off the game thread, so drawing them is left to the caller
 	static void SimplifyMeshBatch(
 		TArray<TArray<Tri*>>& BatchTris,
-		const TriMesh& TMesh,
-		uint16 BatchNo
+		TriMesh& TMesh,
+		uint16 BatchNo,
+		TArray<VBufferPolygon>& Polygons
 	);
 	
-	// Pulls Static Mesh data and populates TMesh with it. If TForm != nullptr, it will be used to transform the vertices
+	// mesh data pulled off the GPU by ReadMeshBuffers(), waiting to be built into a TriMesh by BuildTriMesh()
+	struct MeshBuffers {
+
+		MeshBuffers() :
+			Indices(nullptr), OwnedIndices(nullptr), IndexCt(0), Is32Bit(false), VertexCt(0), DoTransform(false),
+			IsGPURead(false)
+		{}
+
+		// frees OwnedIndices if the indices had to be copied; a view over the mesh's own buffer is just dropped
+		void ReleaseIndices() {
+			delete[] OwnedIndices;
+			OwnedIndices = nullptr;
+			Indices = nullptr;
+		}
+
+		// uint16 or uint32 indices, by Is32Bit; points into the mesh's cpu-side index buffer when it has one, or
+		// into OwnedIndices if they had to be read off the gpu
+		const void* Indices;
+		uint8* OwnedIndices;
+		uint32 IndexCt;
+		bool Is32Bit;
+		uint32 VertexCt;
+		FTransform TForm;
+		bool DoTransform;
+		// the buffers are waiting on a render command; FlushRenderingCommands() has to be called before they're used
+		bool IsGPURead;
+	};
+	
+	// Pulls Static Mesh data and populates TMesh with it. If DoTransform, the actor's transform is applied to the vertices
 	GEOPROC_RESPONSE PopulateTriMesh(TriMesh& TMesh, bool DoTransform=true) const;
 
+	// First half of PopulateTriMesh(): points Buffers at the index buffer and copies the vertex buffer into
+	// TMesh.Vertices. Reads the CPU-side copies of the buffers when the mesh has them; otherwise enqueues a GPU read and sets
+	// Buffers.IsGPURead without flushing, so reads for many meshes can share one FlushRenderingCommands().
+	// Must run on the game thread, since mesh and actor data is only accessible there
+	GEOPROC_RESPONSE ReadMeshBuffers(TriMesh& TMesh, MeshBuffers& Buffers, bool DoTransform=true) const;
+
+	// Stands in for ReadMeshBuffers() when the mesh has been read before: fills TMesh.Vertices from the asset's kept
+	// local-space vertices and points Buffers at its indices, so the mesh itself isn't read
+	GEOPROC_RESPONSE ReadCachedMeshBuffers(
+		TriMesh& TMesh, MeshBuffers& Buffers, const MeshAssetEntry& Asset, bool DoTransform=true
+	) const;
+
+	// Second half of PopulateTriMesh(): transforms, welds and populates TMesh from Buffers, then frees the indices.
+	// Touches nothing but TMesh and Buffers, so it can run on any thread
+	GEOPROC_RESPONSE BuildTriMesh(TriMesh& TMesh, MeshBuffers& Buffers) const;
+
+	// Vertices closer together than Epsilon (after transform) are welded into one vertex by PopulateTriMesh()
+	void SetWeldEpsilon(float Epsilon);
+
+	float GetWeldEpsilon() const;
+
 	// Takes Populated TriMeshes and groups them by overlap
 	static void GroupTriMeshes(TArray<TriMesh>& TMeshes, TArray<TArray<TriMesh*>>& Groups);
 
@@ -60,24 +116,30 @@ public:
 private:
 
 	static constexpr float EPSILON = 3e-4f;
+	static constexpr float DEFAULT_WELD_EPSILON = 1e-3f;
 
-	// Copies the index buffer of the mesh into a new buffer
-	uint16* GetIndices(const FStaticMeshLODResources& LOD, uint32& IndexCt) const;
-	
-	// Copies the vertex buffer of the mesh into TMesh.Vertices
-	GEOPROC_RESPONSE GetVertices(const FStaticMeshLODResources& LOD, TriMesh& TMesh, uint32& VertexCt) const;
+	float WeldEpsilon;
 
-	static int GetNeighbors(
-		const TriGrid& Grid, int BatchSz, Tri& T, int& TriCt, bool& OnlyAssignNeighbors, bool& BatchFinished
-	);
+	// Points Buffers at the cpu-side index buffer of the mesh, or if there isn't one, enqueues a copy of the gpu index
+	// buffer on the render thread and sets Buffers.IsGPURead
+	GEOPROC_RESPONSE GetIndices(const FStaticMeshLODResources& LOD, MeshBuffers& Buffers) const;
+	
+	// Copies the vertex buffer of the mesh into TMesh.Vertices; IsGPURead is set if the copy was enqueued on the
+	// render thread instead of made right away
+	GEOPROC_RESPONSE GetVertices(
+		const FStaticMeshLODResources& LOD, TriMesh& TMesh, uint32& VertexCt, bool& IsGPURead
+	) const;
 
-	static inline Tri* GetUnbatchedTri(const TriGrid& Grid);
+	static inline const Tri* GetUnbatchedTri(const TriGrid& Grid);
 	
-	static inline Tri* GetUngroupedTri(const TriGrid& Grid);
+	static inline const Tri* GetUngroupedTri(const TriGrid& Grid);
 
 	static bool GetNewStartTriIndex(const TriGrid& Grid, int& StartTriIndex);
 
-	static void AddVBufferUPolyEdge(VBufferUnstructuredPolygon& UPoly, const Tri& T, int Side, Tri* Neighbor=nullptr);
+	// adds the given side of tri TriIndex, pointing into the grid's vertex buffer
+	static void AddVBufferUPolyEdge(
+		VBufferUnstructuredPolygon& UPoly, TriGrid& Grid, int TriIndex, int Side, Tri* Neighbor=nullptr
+	);
 
 	static inline bool FormPolygon(VBufferPolygon& Polygon, VBufferUnstructuredPolygon& UPoly);
 
@@ -89,12 +151,31 @@ private:
 
 	static inline void SmoothPolygon(VBufferPolygon& Polygon, float Sigma=0.2f, int PassCt=3);
 
+	// Welds vertices within Epsilon of each other: Remap maps each vertex to the one it's welded to (or itself), and is
+	// applied by Populate(). WeldedCt is the number of vertices no longer referenced by any index. IndexType is
+	// uint16 or uint32
+	template<typename IndexType>
 	static GEOPROC_RESPONSE FixDuplicateVertices(
-		FVector* Vertices, uint16* Indices, uint32 IndexCt, uint32 VertexCt
+		const FVector* Vertices,
+		const IndexType* Indices,
+		uint32 IndexCt,
+		uint32 VertexCt,
+		float Epsilon,
+		TArray<uint32>& Remap,
+		uint32& WeldedCt
+	);
+
+	// Spatially hashes the vertices and maps each one to the first vertex found within Epsilon of it (or itself)
+	static void BuildWeldRemap(
+		const FVector* Vertices, uint32 VertexCt, float Epsilon, TArray<uint32>& Remap, uint32& WeldedCt
 	);
 
-	// Populates TMesh with Tris given the previously filled vertex and index buffers
-	static void Populate(TriMesh& TMesh, uint16* Indices, uint32 IndexCt, uint32 VertexCt);
+	// Populates TMesh with Tris given the previously filled vertex buffer and the index buffer, read in place through
+	// the weld remap. IndexType is uint16 or uint32
+	template<typename IndexType>
+	static void Populate(
+		TriMesh& TMesh, const IndexType* Indices, uint32 IndexCt, const TArray<uint32>& Remap, uint32 VertexCt
+	);
 
 	// flag tris with flags that relate to their location relative to the bounds volume
 	static void FlagTrisWithBV(TArray<TriMesh*>& TMeshes);
@@ -117,18 +198,19 @@ private:
 	// is inside and where it's outside of other meshes. those points *should* link up with points on
 	// other edges, and exposed sections should link up to form polygons. this function creates nodes
 	// and links them together into graphs
-	static void PopulateNodes(const Tri& T, const UnstructuredPolygon& UPoly, TArray<UPolyNode>& PolygonNodes);
+	static void PopulateNodes(const Tri& T, const UnstructuredPolygon& UPoly, TScratchArray<UPolyNode>& PolygonNodes);
 
 	static bool DoesEdgeConnect(const TArrayView<UPolyNode>& Nodes, const PolyEdge& Edge);
 
 	// helper to PopulateNodes that searches for whether or not nodes exist at A and B first, adds
 	// if not, and links them
-	static void AddUPolyNodes(TArray<UPolyNode>& Nodes, const FVector& A, const FVector& B, int& NodeCtr);
+	static void AddUPolyNodes(TScratchArray<UPolyNode>& Nodes, const FVector& A, const FVector& B, int& NodeCtr);
 
 	// makes n polygons given n closed loop graphs created by intersections + edges on a tri
 	static void Polygonize(
 		Tri& T,
-		TArray<UPolyNode>& PolygonNodes,
+		FVector& Normal,
+		TScratchArray<UPolyNode>& PolygonNodes,
 		TArray<Polygon>& Polygons,
 		int TriIndex
 	);
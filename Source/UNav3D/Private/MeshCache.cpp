@@ -0,0 +1,195 @@
+﻿#include "MeshCache.h"
+#include "Engine/StaticMeshActor.h"
+
+namespace {
+
+	constexpr int TFORM_FLOAT_CT = 10;
+
+	// translation, rotation and scale, in that order
+	void GetTransformFloats(const FTransform& TForm, float* Floats) {
+		const FVector Translation = TForm.GetTranslation();
+		const FQuat Rotation = TForm.GetRotation();
+		const FVector Scale = TForm.GetScale3D();
+		Floats[0] = Translation.X;
+		Floats[1] = Translation.Y;
+		Floats[2] = Translation.Z;
+		Floats[3] = Rotation.X;
+		Floats[4] = Rotation.Y;
+		Floats[5] = Rotation.Z;
+		Floats[6] = Rotation.W;
+		Floats[7] = Scale.X;
+		Floats[8] = Scale.Y;
+		Floats[9] = Scale.Z;
+	}
+
+	FString GetDerivedDataKey(const UStaticMesh* StaticMesh) {
+		if (StaticMesh == nullptr) {
+			return FString();
+		}
+		const FStaticMeshRenderData* RenderData = StaticMesh->GetRenderData();
+		return RenderData != nullptr ? RenderData->DerivedDataKey : FString();
+	}
+
+}
+
+MeshCacheKey::MeshCacheKey() :
+	StaticMesh(nullptr), LOD(0), WeldEpsilon(0.0f)
+{}
+
+MeshCacheKey::MeshCacheKey(const AStaticMeshActor* MeshActor, int _LOD, float _WeldEpsilon) :
+	StaticMesh(MeshActor->GetStaticMeshComponent()->GetStaticMesh()),
+	LOD(_LOD),
+	TForm(MeshActor->GetTransform()),
+	WeldEpsilon(_WeldEpsilon),
+	DerivedDataKey(GetDerivedDataKey(StaticMesh))
+{}
+
+bool MeshCacheKey::operator == (const MeshCacheKey& Other) const {
+	if (StaticMesh != Other.StaticMesh || LOD != Other.LOD || WeldEpsilon != Other.WeldEpsilon) {
+		return false;
+	}
+	float Floats[TFORM_FLOAT_CT];
+	float OtherFloats[TFORM_FLOAT_CT];
+	GetTransformFloats(TForm, Floats);
+	GetTransformFloats(Other.TForm, OtherFloats);
+	for (int i = 0; i < TFORM_FLOAT_CT; i++) {
+		if (Floats[i] != OtherFloats[i]) {
+			return false;
+		}
+	}
+	return DerivedDataKey == Other.DerivedDataKey;
+}
+
+uint32 GetTypeHash(const MeshCacheKey& Key) {
+	float Floats[TFORM_FLOAT_CT];
+	GetTransformFloats(Key.TForm, Floats);
+	uint32 Hash = HashCombine(GetTypeHash(Key.StaticMesh), GetTypeHash(Key.LOD));
+	Hash = HashCombine(Hash, FCrc::MemCrc32(Floats, sizeof(Floats)));
+	return HashCombine(Hash, GetTypeHash(Key.WeldEpsilon));
+}
+
+MeshCache::MeshCache() {}
+
+MeshCache::~MeshCache() {
+	Reset();
+}
+
+void MeshCache::BeginRebuild() {
+	for (auto& Pair : Assets) {
+		Pair.Value->IsUsed = false;
+	}
+	FScopeLock Lock(&MeshMutex);
+	for (auto& Pair : Meshes) {
+		Pair.Value->IsUsed = false;
+	}
+}
+
+void MeshCache::EndRebuild() {
+	for (auto It = Assets.CreateIterator(); It; ++It) {
+		if (!It.Value()->IsUsed) {
+			delete It.Value();
+			It.RemoveCurrent();
+		}
+	}
+	FScopeLock Lock(&MeshMutex);
+	for (auto It = Meshes.CreateIterator(); It; ++It) {
+		if (!It.Value()->IsUsed) {
+			delete It.Value();
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void MeshCache::Reset() {
+	for (auto& Pair : Assets) {
+		delete Pair.Value;
+	}
+	Assets.Empty();
+	FScopeLock Lock(&MeshMutex);
+	for (auto& Pair : Meshes) {
+		delete Pair.Value;
+	}
+	Meshes.Empty();
+}
+
+const MeshAssetEntry* MeshCache::FindAsset(const UStaticMesh* StaticMesh, int LOD) {
+	const TPair<const UStaticMesh*, int> AssetKey(StaticMesh, LOD);
+	MeshAssetEntry** Found = Assets.Find(AssetKey);
+	if (Found == nullptr) {
+		return nullptr;
+	}
+	MeshAssetEntry* Asset = *Found;
+	if (Asset->DerivedDataKey != GetDerivedDataKey(StaticMesh)) {
+		// stale; the asset has been rebuilt since it was read
+		delete Asset;
+		Assets.Remove(AssetKey);
+		return nullptr;
+	}
+	Asset->IsUsed = true;
+	return Asset;
+}
+
+const MeshAssetEntry* MeshCache::AddAsset(
+	const UStaticMesh* StaticMesh,
+	int LOD,
+	const FVector* Vertices,
+	uint32 VertexCt,
+	const void* Indices,
+	uint32 IndexCt,
+	bool Is32Bit
+) {
+	const TPair<const UStaticMesh*, int> AssetKey(StaticMesh, LOD);
+	MeshAssetEntry** Found = Assets.Find(AssetKey);
+	MeshAssetEntry* Asset = Found != nullptr ? *Found : Assets.Add(AssetKey, new MeshAssetEntry());
+	Asset->StaticMesh = StaticMesh;
+	Asset->LOD = LOD;
+	Asset->DerivedDataKey = GetDerivedDataKey(StaticMesh);
+	Asset->Vertices.SetNumUninitialized(VertexCt);
+	memcpy(Asset->Vertices.GetData(), Vertices, VertexCt * sizeof(FVector));
+	// kept at 32 bits regardless of the source width
+	Asset->Indices.SetNumUninitialized(IndexCt);
+	if (Is32Bit) {
+		memcpy(Asset->Indices.GetData(), Indices, IndexCt * sizeof(uint32));
+	}
+	else {
+		const uint16* Indices16 = (const uint16*)Indices;
+		for (uint32 i = 0; i < IndexCt; i++) {
+			Asset->Indices[i] = Indices16[i];
+		}
+	}
+	Asset->IsUsed = true;
+	return Asset;
+}
+
+const TriMesh* MeshCache::FindMesh(const MeshCacheKey& Key) {
+	FScopeLock Lock(&MeshMutex);
+	MeshEntry** Found = Meshes.Find(Key);
+	if (Found == nullptr) {
+		return nullptr;
+	}
+	(*Found)->IsUsed = true;
+	return &(*Found)->Mesh;
+}
+
+void MeshCache::AddMesh(const MeshCacheKey& Key, const TriMesh& TMesh) {
+	{
+		FScopeLock Lock(&MeshMutex);
+		if (Meshes.Contains(Key)) {
+			return;
+		}
+	}
+	// copying outside the lock, since it's the slow part
+	MeshEntry* Entry = new MeshEntry();
+	if (!Entry->Mesh.CopyFrom(TMesh)) {
+		delete Entry;
+		return;
+	}
+	Entry->IsUsed = true;
+
+	FScopeLock Lock(&MeshMutex);
+	if (Meshes.Contains(Key)) {
+		delete Entry;
+		return;
+	}
+	Meshes.Add(Key, Entry);
+}
@@ -0,0 +1,91 @@
+﻿#pragma once
+
+#include "TriMesh.h"
+
+class UStaticMesh;
+class AStaticMeshActor;
+
+// Everything a processed TriMesh depends on; actors with equal keys end up with identical meshes
+struct MeshCacheKey {
+
+	MeshCacheKey();
+
+	MeshCacheKey(const AStaticMeshActor* MeshActor, int _LOD, float _WeldEpsilon);
+
+	// transforms are compared exactly, since any change moves the world-space vertices
+	bool operator == (const MeshCacheKey& Other) const;
+
+	const UStaticMesh* StaticMesh;
+	int LOD;
+	FTransform TForm;
+	float WeldEpsilon;
+	// changes whenever the mesh's render data is rebuilt, e.g. on reimport
+	FString DerivedDataKey;
+};
+
+uint32 GetTypeHash(const MeshCacheKey& Key);
+
+// Local-space geometry of one static mesh LOD, shared by every actor instancing it
+struct MeshAssetEntry {
+	const UStaticMesh* StaticMesh;
+	int LOD;
+	FString DerivedDataKey;
+	TArray<FVector> Vertices;
+	TArray<uint32> Indices;
+	bool IsUsed;
+};
+
+// Keeps mesh data across rebuilds so unchanged meshes skip ingestion. Two levels: assets hold the local-space vertices
+// and indices of a static mesh LOD, so instances only need their transform applied; meshes hold fully processed
+// (transformed, welded, gridded and batched) TriMeshes under a MeshCacheKey, so an unchanged actor is just copied.
+// Entries not used during a rebuild are dropped at the end of it.
+class MeshCache {
+
+public:
+
+	MeshCache();
+
+	~MeshCache();
+
+	// marks every entry unused
+	void BeginRebuild();
+
+	// drops every entry that wasn't found or added since BeginRebuild(); no tasks can be using the cache
+	void EndRebuild();
+
+	void Reset();
+
+	// nullptr if the asset hasn't been read, or its render data has changed since. Game thread only
+	const MeshAssetEntry* FindAsset(const UStaticMesh* StaticMesh, int LOD);
+
+	// copies local-space vertices and indices (uint16 or uint32, by Is32Bit). Game thread only
+	const MeshAssetEntry* AddAsset(
+		const UStaticMesh* StaticMesh,
+		int LOD,
+		const FVector* Vertices,
+		uint32 VertexCt,
+		const void* Indices,
+		uint32 IndexCt,
+		bool Is32Bit
+	);
+
+	// nullptr if no mesh was processed under Key. The mesh stays put until EndRebuild()
+	const TriMesh* FindMesh(const MeshCacheKey& Key);
+
+	// deep copies TMesh, unless a mesh is already kept under Key. Safe from any thread
+	void AddMesh(const MeshCacheKey& Key, const TriMesh& TMesh);
+
+private:
+
+	// what's kept per mesh; heap allocated so pointers handed out stay valid while the map grows
+	struct MeshEntry {
+		TriMesh Mesh;
+		bool IsUsed;
+	};
+
+	TMap<TPair<const UStaticMesh*, int>, MeshAssetEntry*> Assets;
+	TMap<MeshCacheKey, MeshEntry*> Meshes;
+	// meshes are added from task graph threads while the game thread is still looking others up
+	FCriticalSection MeshMutex;
+
+};
@@ -0,0 +1,403 @@
+﻿#include "NavHierarchy.h"
+#include "UNavMesh.h"
+
+namespace {
+
+	constexpr uint32 NO_CLUSTER = MAX_uint32;
+	constexpr uint32 NO_PARENT = MAX_uint32;
+
+	// the tris and midpoints of all sides shared by two clusters, for picking the pair's portal
+	struct ClusterPair {
+		FVector Sum;
+		int SideCt;
+		float BestSqDist;
+		uint32 Tris[2];
+		FVector Position;
+	};
+
+	FVector GetSideMidpoint(const TriGrid& Grid, uint32 TriIndex, int Side) {
+		const FVector* Vertices = Grid.GetVertices();
+		const uint32* TriVIndices = Grid.GetVIndexBuffer() + 3 * TriIndex;
+		return (Vertices[TriVIndices[Side]] + Vertices[TriVIndices[(Side + 1) % 3]]) * 0.5f;
+	}
+
+	// orders the abstract search's open heap, lowest F on top
+	struct OpenEntryLess {
+		bool operator () (
+			const NavProcessor::SearchSpace::OpenEntry& A,
+			const NavProcessor::SearchSpace::OpenEntry& B
+		) const {
+			return A.F < B.F;
+		}
+	};
+
+}
+
+NavHierarchy::QuerySpace::QuerySpace() :
+	Generation(0)
+{}
+
+void NavHierarchy::QuerySpace::Reserve(const NavHierarchy& Hierarchy) {
+	// every portal, then the start and goal
+	if (Nodes.Num() < Hierarchy.PortalCt + 2) {
+		Nodes.SetNumZeroed(Hierarchy.PortalCt + 2);
+		Legs.Reserve(Hierarchy.PortalCt + 2);
+	}
+	// each node is pushed at most once per edge into it
+	const int MaxOpenCt = (Hierarchy.ClusterCt > 0 ? Hierarchy.ClusterCostStarts[Hierarchy.ClusterCt] : 0)
+		+ 2 * Hierarchy.MaxClusterPortalCt + 2;
+	Open.Reserve(MaxOpenCt);
+	StartCosts.Reserve(Hierarchy.MaxClusterPortalCt);
+	GoalCosts.Reserve(Hierarchy.MaxClusterPortalCt);
+}
+
+NavHierarchy::NavHierarchy() :
+	Container(nullptr),
+	TriClusters(nullptr),
+	Portals(nullptr),
+	ClusterPortalStarts(nullptr),
+	ClusterPortals(nullptr),
+	ClusterCostStarts(nullptr),
+	Costs(nullptr),
+	TriCt(0),
+	ClusterCt(0),
+	PortalCt(0),
+	MaxClusterPortalCt(0)
+{}
+
+bool NavHierarchy::Build(const UNavMesh& NMesh) {
+	Reset();
+	const TriGrid& Grid = NMesh.Grid;
+	const int GridTriCt = Grid.Num();
+	if (GridTriCt == 0) {
+		return true;
+	}
+
+	// growing clusters breadth first from the first unclustered tri, taking neighbors facing about the same way as
+	// the seed, as GetMeshBatch() does with groups; that can't be used here, since it works on a TriMesh and writes
+	// its results into the tris' processing flags
+	TArray<uint32> Clusters;
+	Clusters.Init(NO_CLUSTER, GridTriCt);
+	TArray<uint32> Queue;
+	Queue.Reserve(CLUSTER_SZ);
+	int NewClusterCt = 0;
+	for (int Seed = 0; Seed < GridTriCt; Seed++) {
+		if (Clusters[Seed] != NO_CLUSTER) {
+			continue;
+		}
+		const uint32 Cluster = NewClusterCt++;
+		const FVector& SeedNormal = Grid.GetNormal(Seed);
+		Queue.Reset();
+		Queue.Add(Seed);
+		Clusters[Seed] = Cluster;
+		for (int Head = 0; Head < Queue.Num() && Queue.Num() < CLUSTER_SZ; Head++) {
+			for (int Side = Tri::AB; Side <= Tri::CA && Queue.Num() < CLUSTER_SZ; Side++) {
+				const uint32 Neighbor = Grid.GetNeighbor(Queue[Head], Side);
+				if (
+					Neighbor == TriGrid::NO_NEIGHBOR
+					|| Clusters[Neighbor] != NO_CLUSTER
+					|| FVector::DotProduct(SeedNormal, Grid.GetNormal(Neighbor)) <= DEVIATION_CUTOFF
+				) {
+					continue;
+				}
+				Clusters[Neighbor] = Cluster;
+				Queue.Add(Neighbor);
+			}
+		}
+	}
+
+	// one portal per pair of touching clusters, at their shared side nearest the middle of all their shared sides.
+	// Pairs touching along several separate stretches only get the one, so paths found can be a little long
+	TMap<uint64, int> PairIndices;
+	TArray<ClusterPair> Pairs;
+	for (int Pass = 0; Pass < 2; Pass++) {
+		for (int i = 0; i < GridTriCt; i++) {
+			for (int Side = Tri::AB; Side <= Tri::CA; Side++) {
+				const uint32 Neighbor = Grid.GetNeighbor(i, Side);
+				// each shared side once, from its lower cluster's tri
+				if (Neighbor == TriGrid::NO_NEIGHBOR || Clusters[i] >= Clusters[Neighbor]) {
+					continue;
+				}
+				const uint64 Key = ((uint64)Clusters[i] << 32) | (uint64)Clusters[Neighbor];
+				const FVector Midpoint = GetSideMidpoint(Grid, i, Side);
+				if (Pass == 0) {
+					int* Found = PairIndices.Find(Key);
+					if (Found == nullptr) {
+						const int PairIndex = Pairs.AddZeroed();
+						Pairs[PairIndex].BestSqDist = MAX_flt;
+						Found = &PairIndices.Add(Key, PairIndex);
+					}
+					ClusterPair& Pair = Pairs[*Found];
+					Pair.Sum += Midpoint;
+					Pair.SideCt++;
+				}
+				else {
+					ClusterPair& Pair = Pairs[PairIndices[Key]];
+					const float SqDist = FVector::DistSquared(Midpoint, Pair.Sum / Pair.SideCt);
+					if (SqDist < Pair.BestSqDist) {
+						Pair.BestSqDist = SqDist;
+						Pair.Tris[0] = i;
+						Pair.Tris[1] = Neighbor;
+						Pair.Position = Midpoint;
+					}
+				}
+			}
+		}
+	}
+
+	TArray<uint32> PortalStarts;
+	PortalStarts.SetNumZeroed(NewClusterCt + 1);
+	for (const ClusterPair& Pair : Pairs) {
+		PortalStarts[Clusters[Pair.Tris[0]] + 1]++;
+		PortalStarts[Clusters[Pair.Tris[1]] + 1]++;
+	}
+	TArray<uint32> CostStarts;
+	CostStarts.SetNumZeroed(NewClusterCt + 1);
+	int NewMaxClusterPortalCt = 0;
+	for (int i = 0; i < NewClusterCt; i++) {
+		const uint32 ClusterPortalCt = PortalStarts[i + 1];
+		NewMaxClusterPortalCt = FMath::Max(NewMaxClusterPortalCt, (int)ClusterPortalCt);
+		CostStarts[i + 1] = CostStarts[i] + ClusterPortalCt * ClusterPortalCt;
+		PortalStarts[i + 1] += PortalStarts[i];
+	}
+
+	Container = malloc(
+		GridTriCt * sizeof(uint32)
+		+ Pairs.Num() * sizeof(HierarchyPortal)
+		+ 2 * (NewClusterCt + 1) * sizeof(uint32)
+		+ 2 * Pairs.Num() * sizeof(uint32)
+		+ CostStarts[NewClusterCt] * sizeof(float)
+	);
+	if (Container == nullptr) {
+		printf("TEMP ERROR NavHierarchy::Build() alloc fail\n");
+		return false;
+	}
+	TriCt = GridTriCt;
+	ClusterCt = NewClusterCt;
+	PortalCt = Pairs.Num();
+	MaxClusterPortalCt = NewMaxClusterPortalCt;
+	TriClusters = (uint32*)Container;
+	Portals = (HierarchyPortal*)(TriClusters + TriCt);
+	ClusterPortalStarts = (uint32*)(Portals + PortalCt);
+	ClusterPortals = ClusterPortalStarts + ClusterCt + 1;
+	ClusterCostStarts = ClusterPortals + 2 * PortalCt;
+	Costs = (float*)(ClusterCostStarts + ClusterCt + 1);
+	memcpy(TriClusters, Clusters.GetData(), TriCt * sizeof(uint32));
+	memcpy(ClusterPortalStarts, PortalStarts.GetData(), (ClusterCt + 1) * sizeof(uint32));
+	memcpy(ClusterCostStarts, CostStarts.GetData(), (ClusterCt + 1) * sizeof(uint32));
+
+	// filling cluster portal lists; PortalStarts is used up as each list's fill position
+	for (int i = 0; i < PortalCt; i++) {
+		HierarchyPortal& Portal = Portals[i];
+		Portal.Position = Pairs[i].Position;
+		for (int Side = 0; Side < 2; Side++) {
+			const uint32 Cluster = Clusters[Pairs[i].Tris[Side]];
+			Portal.Tris[Side] = Pairs[i].Tris[Side];
+			Portal.Clusters[Side] = Cluster;
+			Portal.Slots[Side] = PortalStarts[Cluster] - ClusterPortalStarts[Cluster];
+			ClusterPortals[PortalStarts[Cluster]++] = i;
+		}
+	}
+
+	// distances between every two portals of each cluster, staying inside it
+	NavProcessor::SearchSpace Space;
+	Space.Reserve(TriCt);
+	TArray<float> PortalCosts;
+	for (int Cluster = 0; Cluster < ClusterCt; Cluster++) {
+		const int ClusterPortalCt = GetClusterPortalCt(Cluster);
+		for (int i = 0; i < ClusterPortalCt; i++) {
+			const HierarchyPortal& Portal = Portals[ClusterPortals[ClusterPortalStarts[Cluster] + i]];
+			GetPortalCosts(NMesh, Portal.Tris[GetSide(Portal, Cluster)], Portal.Position, Space, PortalCosts);
+			memcpy(
+				Costs + ClusterCostStarts[Cluster] + i * ClusterPortalCt,
+				PortalCosts.GetData(),
+				ClusterPortalCt * sizeof(float)
+			);
+		}
+	}
+	return true;
+}
+
+void NavHierarchy::Reset() {
+	if (Container != nullptr) {
+		free(Container);
+	}
+	Container = nullptr;
+	TriClusters = nullptr;
+	Portals = nullptr;
+	ClusterPortalStarts = nullptr;
+	ClusterPortals = nullptr;
+	ClusterCostStarts = nullptr;
+	Costs = nullptr;
+	TriCt = 0;
+	ClusterCt = 0;
+	PortalCt = 0;
+	MaxClusterPortalCt = 0;
+}
+
+bool NavHierarchy::IsLongRange(uint32 StartTri, uint32 GoalTri) const {
+	return (
+		TriClusters != nullptr
+		&& StartTri < (uint32)TriCt
+		&& GoalTri < (uint32)TriCt
+		&& TriClusters[StartTri] != TriClusters[GoalTri]
+	);
+}
+
+void NavHierarchy::GetPortalCosts(
+	const UNavMesh& NMesh,
+	uint32 PointTri,
+	const FVector& Point,
+	NavProcessor::SearchSpace& Space,
+	TArray<float>& PortalCosts
+) const {
+	const uint32 Cluster = TriClusters[PointTri];
+	NavProcessor::SearchCluster(NMesh, PointTri, Point, TriClusters, Space);
+	const int ClusterPortalCt = GetClusterPortalCt(Cluster);
+	PortalCosts.SetNum(ClusterPortalCt, false);
+	for (int i = 0; i < ClusterPortalCt; i++) {
+		const HierarchyPortal& Portal = Portals[ClusterPortals[ClusterPortalStarts[Cluster] + i]];
+		PortalCosts[i] = NavProcessor::GetSearchedDist(Space, Portal.Tris[GetSide(Portal, Cluster)], Portal.Position);
+	}
+}
+
+bool NavHierarchy::FindPath(
+	const UNavMesh& NMesh,
+	uint32 StartTri,
+	const FVector& Start,
+	uint32 GoalTri,
+	const FVector& Goal,
+	NavProcessor::SearchSpace& Space,
+	QuerySpace& QSpace,
+	TArray<uint32>& Corridor,
+	TArray<FVector>& Points
+) const {
+	if (!IsLongRange(StartTri, GoalTri)) {
+		return NavProcessor::FindPath(NMesh, StartTri, Start, GoalTri, Goal, Space, Corridor, Points);
+	}
+	Corridor.Reset();
+	Points.Reset();
+	const uint32 StartCluster = TriClusters[StartTri];
+	const uint32 GoalCluster = TriClusters[GoalTri];
+	GetPortalCosts(NMesh, StartTri, Start, Space, QSpace.StartCosts);
+	GetPortalCosts(NMesh, GoalTri, Goal, Space, QSpace.GoalCosts);
+
+	QSpace.Reserve(*this);
+	QSpace.Generation++;
+	if (QSpace.Generation == 0) {
+		for (int i = 0; i < QSpace.Nodes.Num(); i++) {
+			QSpace.Nodes[i].Generation = 0;
+			QSpace.Nodes[i].ClosedGeneration = 0;
+		}
+		QSpace.Generation = 1;
+	}
+	const uint32 Generation = QSpace.Generation;
+	const uint32 StartNode = PortalCt;
+	const uint32 GoalNode = PortalCt + 1;
+	TArray<QuerySpace::Node>& Nodes = QSpace.Nodes;
+	TArray<NavProcessor::SearchSpace::OpenEntry>& Open = QSpace.Open;
+	Open.Reset();
+
+	auto GetPosition = [&](uint32 NodeIndex) -> const FVector& {
+		return NodeIndex == StartNode ? Start : NodeIndex == GoalNode ? Goal : Portals[NodeIndex].Position;
+	};
+	// A* over portals, with the start and goal joined to their clusters' portals
+	auto Relax = [&](const QuerySpace::Node& From, uint32 To, float Cost, uint32 Cluster, uint32 FromIndex) {
+		QuerySpace::Node& Next = Nodes[To];
+		if (Cost == MAX_flt || Next.ClosedGeneration == Generation) {
+			return;
+		}
+		const float G = From.G + Cost;
+		if (Next.Generation == Generation && G >= Next.G) {
+			return;
+		}
+		Next.G = G;
+		Next.Parent = FromIndex;
+		Next.ParentCluster = Cluster;
+		Next.Generation = Generation;
+		NavProcessor::SearchSpace::OpenEntry Entry;
+		Entry.F = G + FVector::Dist(GetPosition(To), Goal);
+		Entry.TriIndex = To;
+		Open.HeapPush(Entry, OpenEntryLess());
+	};
+
+	QuerySpace::Node& First = Nodes[StartNode];
+	First.G = 0.0f;
+	First.Parent = NO_PARENT;
+	First.Generation = Generation;
+	NavProcessor::SearchSpace::OpenEntry FirstEntry;
+	FirstEntry.F = FVector::Dist(Start, Goal);
+	FirstEntry.TriIndex = StartNode;
+	Open.HeapPush(FirstEntry, OpenEntryLess());
+
+	bool Found = false;
+	while (Open.Num() > 0) {
+		NavProcessor::SearchSpace::OpenEntry Entry;
+		Open.HeapPop(Entry, OpenEntryLess(), false);
+		const uint32 NodeIndex = Entry.TriIndex;
+		QuerySpace::Node& Current = Nodes[NodeIndex];
+		if (Current.ClosedGeneration == Generation) {
+			continue;
+		}
+		Current.ClosedGeneration = Generation;
+		if (NodeIndex == GoalNode) {
+			Found = true;
+			break;
+		}
+		if (NodeIndex == StartNode) {
+			const uint32* StartPortals = ClusterPortals + ClusterPortalStarts[StartCluster];
+			for (int i = 0; i < QSpace.StartCosts.Num(); i++) {
+				Relax(Current, StartPortals[i], QSpace.StartCosts[i], StartCluster, NodeIndex);
+			}
+			continue;
+		}
+		const HierarchyPortal& Portal = Portals[NodeIndex];
+		for (int Side = 0; Side < 2; Side++) {
+			const uint32 Cluster = Portal.Clusters[Side];
+			const uint32 Slot = Portal.Slots[Side];
+			const uint32* OtherPortals = ClusterPortals + ClusterPortalStarts[Cluster];
+			const int ClusterPortalCt = GetClusterPortalCt(Cluster);
+			for (int i = 0; i < ClusterPortalCt; i++) {
+				if (i != Slot) {
+					Relax(Current, OtherPortals[i], GetCost(Cluster, Slot, i), Cluster, NodeIndex);
+				}
+			}
+			if (Cluster == GoalCluster) {
+				Relax(Current, GoalNode, QSpace.GoalCosts[Slot], Cluster, NodeIndex);
+			}
+		}
+	}
+	if (!Found) {
+		return false;
+	}
+
+	// refining: A* from each portal to the next, which only ever searches around the one cluster
+	QSpace.Legs.Reset();
+	for (uint32 NodeIndex = GoalNode; NodeIndex != NO_PARENT; NodeIndex = Nodes[NodeIndex].Parent) {
+		QSpace.Legs.Add(NodeIndex);
+	}
+	uint32 FromTri = StartTri;
+	FVector From = Start;
+	Points.Add(Start);
+	for (int i = QSpace.Legs.Num() - 2; i >= 0; i--) {
+		const uint32 NodeIndex = QSpace.Legs[i];
+		const uint32 Cluster = Nodes[NodeIndex].ParentCluster;
+		const bool IsGoal = NodeIndex == GoalNode;
+		const int Side = IsGoal ? 0 : GetSide(Portals[NodeIndex], Cluster);
+		const uint32 ToTri = IsGoal ? GoalTri : Portals[NodeIndex].Tris[Side];
+		const FVector& To = GetPosition(NodeIndex);
+		if (!NavProcessor::FindPath(NMesh, FromTri, From, ToTri, To, Space, QSpace.LegCorridor, QSpace.LegPoints)) {
+			Corridor.Reset();
+			Points.Reset();
+			return false;
+		}
+		Corridor.Append(QSpace.LegCorridor);
+		Points.Add(To);
+		if (!IsGoal) {
+			// continuing from the portal's tri on the far side
+			FromTri = Portals[NodeIndex].Tris[1 - Side];
+			From = To;
+		}
+	}
+	return true;
+}
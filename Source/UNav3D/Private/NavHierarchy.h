@@ -0,0 +1,128 @@
+﻿#pragma once
+
+#include "NavProcessor.h"
+
+struct UNavMesh;
+class TriGrid;
+
+// a place where a path can pass from one cluster into another: a tri side, and the tri on either side of it
+struct HierarchyPortal {
+	FVector Position; // the side's midpoint
+	uint32 Tris[2];
+	uint32 Clusters[2];
+	uint32 Slots[2]; // this portal's place in each cluster's portal list
+};
+
+// Two-level abstraction of a navmesh for long paths. Tris are grown into clusters of similar facing, and each pair of
+// touching clusters gets one portal. Distances between every two portals of a cluster are found when building, so a
+// long query searches the small graph of portals, then runs A* only between consecutive portals. Like TriBVH, memory
+// is malloc'd and the owning mesh's memcpy copy shares it; Reset() frees it.
+class NavHierarchy {
+
+public:
+
+	// FindPath()'s search memory, over portals rather than tris. Not thread safe; one per searching thread
+	struct QuerySpace {
+
+		QuerySpace();
+
+		// grows every array to fit Hierarchy
+		void Reserve(const NavHierarchy& Hierarchy);
+
+		struct Node {
+			float G;
+			uint32 Parent; // portal the path came from; MAX_uint32 for the start
+			uint32 ParentCluster; // cluster the path crossed to get here from Parent
+			uint32 Generation;
+			uint32 ClosedGeneration;
+		};
+
+		TArray<Node> Nodes; // one per portal, then the start and goal
+		TArray<NavProcessor::SearchSpace::OpenEntry> Open;
+		uint32 Generation;
+		TArray<float> StartCosts; // from the start to each portal of its cluster, by slot
+		TArray<float> GoalCosts; // from each portal of the goal's cluster to the goal, by slot
+		TArray<uint32> Legs; // abstract path, goal to start
+		TArray<uint32> LegCorridor;
+		TArray<FVector> LegPoints;
+	};
+
+	NavHierarchy();
+
+	// clusters NMesh's tris and finds portals and the distances between them; the mesh's grid must be built
+	bool Build(const UNavMesh& NMesh);
+
+	void Reset();
+
+	// whether FindPath() is worth it over plain A*, i.e. the two tris are in different clusters
+	bool IsLongRange(uint32 StartTri, uint32 GoalTri) const;
+
+	// as NavProcessor::FindPath(), except that Points holds Start, the portals passed through, then Goal
+	bool FindPath(
+		const UNavMesh& NMesh,
+		uint32 StartTri,
+		const FVector& Start,
+		uint32 GoalTri,
+		const FVector& Goal,
+		NavProcessor::SearchSpace& Space,
+		QuerySpace& QSpace,
+		TArray<uint32>& Corridor,
+		TArray<FVector>& Points
+	) const;
+
+	int GetClusterCt() const {
+		return ClusterCt;
+	}
+
+	int GetPortalCt() const {
+		return PortalCt;
+	}
+
+	// most portals any one cluster has
+	int GetMaxClusterPortalCt() const {
+		return MaxClusterPortalCt;
+	}
+
+private:
+
+	static constexpr int CLUSTER_SZ = 256; // most tris in a cluster
+	static constexpr float DEVIATION_CUTOFF = 0.9f; // same facing test as GeometryProcessor::GetMeshBatch()
+
+	// portal indices of cluster c are ClusterPortals[ClusterPortalStarts[c]] through
+	// ClusterPortals[ClusterPortalStarts[c + 1] - 1]
+	int GetClusterPortalCt(uint32 Cluster) const {
+		return ClusterPortalStarts[Cluster + 1] - ClusterPortalStarts[Cluster];
+	}
+
+	// distance within Cluster between the portals in slots From and To
+	float GetCost(uint32 Cluster, uint32 From, uint32 To) const {
+		return Costs[ClusterCostStarts[Cluster] + From * GetClusterPortalCt(Cluster) + To];
+	}
+
+	// the side of Portal that's in Cluster
+	static int GetSide(const HierarchyPortal& Portal, uint32 Cluster) {
+		return Portal.Clusters[0] == Cluster ? 0 : 1;
+	}
+
+	// path lengths from Point on PointTri to each portal of PointTri's cluster, by slot
+	void GetPortalCosts(
+		const UNavMesh& NMesh,
+		uint32 PointTri,
+		const FVector& Point,
+		NavProcessor::SearchSpace& Space,
+		TArray<float>& PortalCosts
+	) const;
+
+	void* Container;
+	uint32* TriClusters;
+	HierarchyPortal* Portals;
+	uint32* ClusterPortalStarts; // ClusterCt + 1 long
+	uint32* ClusterPortals;
+	uint32* ClusterCostStarts; // ClusterCt + 1 long
+	float* Costs; // per cluster, a portal count by portal count matrix
+	int TriCt;
+	int ClusterCt;
+	int PortalCt;
+	int MaxClusterPortalCt;
+
+};
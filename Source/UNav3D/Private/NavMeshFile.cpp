@@ -0,0 +1,335 @@
+﻿#include "NavMeshFile.h"
+#include "UNavMesh.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+
+// the file is read in place, so its layout must not depend on the compiler
+static_assert(sizeof(FVector) == 3 * sizeof(float), "NavMeshFile expects packed FVectors");
+static_assert(sizeof(NavMeshFile::Header) % 8 == 0, "NavMeshFile::Header must keep records 8-byte aligned");
+static_assert(sizeof(NavMeshFile::MeshRecord) % 8 == 0, "NavMeshFile::MeshRecord must keep records 8-byte aligned");
+
+namespace {
+
+	uint64 AlignSection(uint64 Offset) {
+		return (Offset + NavMeshFile::SECTION_ALIGN - 1) & ~(NavMeshFile::SECTION_ALIGN - 1);
+	}
+
+	// whether Ct elements of ElemSz bytes starting at Offset lie inside a file of Sz bytes; written to not overflow
+	// on garbage offsets and counts
+	bool IsSectionInside(uint64 Offset, uint64 Ct, uint64 ElemSz, uint64 Sz) {
+		if (Offset > Sz || Offset % sizeof(uint32) != 0) {
+			return false;
+		}
+		return Ct <= (Sz - Offset) / ElemSz;
+	}
+
+}
+
+NavMeshFile::NavMeshView::NavMeshView(const uint8* _FileBytes, const MeshRecord* _Record) :
+	FileBytes(_FileBytes), Record(_Record)
+{}
+
+bool NavMeshFile::NavMeshView::GetCellTris(const FVector& Location, uint32& StartIndex, uint32& Num) const {
+	// same mapping and hashing as TriGrid::WorldToGrid() and TriGrid::FindBox()
+	if (Record->CellCapacity == 0) {
+		return false;
+	}
+	const FIntVector GridPos((Location - Record->GridMinimum) * Record->InvGridFactor);
+	const FIntVector& CellCounts = Record->CellCounts;
+	if (
+		GridPos.X < 0 || GridPos.X >= CellCounts.X
+		|| GridPos.Y < 0 || GridPos.Y >= CellCounts.Y
+		|| GridPos.Z < 0 || GridPos.Z >= CellCounts.Z
+	) {
+		return false;
+	}
+	const uint32 Key =
+		(uint32)GridPos.X + (uint32)CellCounts.X * ((uint32)GridPos.Y + (uint32)CellCounts.Y * (uint32)GridPos.Z);
+	const Cell* Cells = GetCells();
+	const uint32 CellMask = Record->CellCapacity - 1;
+	uint32 Slot = (Key * TriGrid::CELL_HASH) & CellMask;
+	// bounded, since nothing but Validate() stands between us and a full table
+	for (uint32 i = 0; i < Record->CellCapacity; i++) {
+		const Cell& C = Cells[Slot];
+		if (C.Key == Key) {
+			StartIndex = C.StartIndex;
+			Num = C.Num;
+			return true;
+		}
+		if (C.Key == TriGrid::EMPTY_KEY) {
+			return false;
+		}
+		Slot = (Slot + 1) & CellMask;
+	}
+	return false;
+}
+
+bool NavMeshFile::Write(const TArray<UNavMesh>& NMeshes, const FString& Path) {
+	// laying out every section first, so the whole file is one allocation
+	TArray<MeshRecord> Records;
+	Records.SetNumZeroed(NMeshes.Num());
+	uint64 Offset = AlignSection(sizeof(Header));
+	const uint64 MeshTableOffset = Offset;
+	Offset = AlignSection(Offset + NMeshes.Num() * sizeof(MeshRecord));
+	for (int i = 0; i < NMeshes.Num(); i++) {
+		const UNavMesh& NMesh = NMeshes[i];
+		const TriGrid& Grid = NMesh.Grid;
+		MeshRecord& Record = Records[i];
+		Record.Box = NMesh.Box;
+		Record.GridMinimum = Grid.GetMinimum();
+		Record.InvGridFactor = Grid.GetInvGridFactor();
+		Record.CellCounts = Grid.GetCellCounts();
+		Record.VertexCt = NMesh.VertexCt;
+		Record.TriCt = Grid.Num();
+		Record.CellCapacity = Grid.GetCellCapacity();
+		Record.OverflowStart = Grid.GetOverflowStart();
+		Record.VerticesOffset = Offset;
+		Offset = AlignSection(Offset + Record.VertexCt * sizeof(FVector));
+		Record.StoreOffset = Offset;
+		Offset = AlignSection(Offset + TriGrid::GetStoreSz(Record.TriCt));
+		Record.TriFlagsOffset = Offset;
+		Offset = AlignSection(Offset + Record.TriCt * sizeof(uint32));
+		Record.CellsOffset = Offset;
+		Offset = AlignSection(Offset + Record.CellCapacity * sizeof(Cell));
+	}
+
+	TArray<uint8> Bytes;
+	Bytes.SetNumZeroed(Offset);
+	uint8* Out = Bytes.GetData();
+	Header* FileHeader = (Header*)Out;
+	FileHeader->Magic = MAGIC;
+	FileHeader->Version = VERSION;
+	FileHeader->MeshCt = NMeshes.Num();
+	FileHeader->FileSz = Offset;
+	FileHeader->MeshTableOffset = MeshTableOffset;
+	memcpy(Out + MeshTableOffset, Records.GetData(), NMeshes.Num() * sizeof(MeshRecord));
+
+	for (int i = 0; i < NMeshes.Num(); i++) {
+		const UNavMesh& NMesh = NMeshes[i];
+		const TriGrid& Grid = NMesh.Grid;
+		const MeshRecord& Record = Records[i];
+		if (Record.VertexCt > 0) {
+			memcpy(Out + Record.VerticesOffset, NMesh.Vertices, Record.VertexCt * sizeof(FVector));
+		}
+		if (Record.TriCt > 0) {
+			memcpy(Out + Record.StoreOffset, Grid.GetStore(), TriGrid::GetStoreSz(Record.TriCt));
+		}
+		uint32* TriFlags = (uint32*)(Out + Record.TriFlagsOffset);
+		for (uint32 j = 0; j < Record.TriCt; j++) {
+			TriFlags[j] = Grid[(int)j].Flags;
+		}
+		const TriGridCell* GridCells = Grid.GetCells();
+		Cell* Cells = (Cell*)(Out + Record.CellsOffset);
+		for (uint32 j = 0; j < Record.CellCapacity; j++) {
+			Cells[j].Key = GridCells[j].Key;
+			if (GridCells[j].Key != TriGrid::EMPTY_KEY) {
+				Cells[j].StartIndex = GridCells[j].Box.GetStartIndex();
+				Cells[j].Num = GridCells[j].Box.Num();
+			}
+		}
+	}
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Path);
+}
+
+const char* NavMeshFile::Validate(const uint8* Bytes, uint64 Sz) {
+	if (Bytes == nullptr || Sz < sizeof(Header)) {
+		return "file is too small for a header";
+	}
+	const Header* FileHeader = (const Header*)Bytes;
+	if (FileHeader->Magic != MAGIC) {
+		return "not a navmesh file";
+	}
+	if (FileHeader->Version != VERSION) {
+		return "navmesh file version doesn't match; rebuild navmeshes";
+	}
+	if (FileHeader->FileSz != Sz) {
+		return "file size doesn't match header; file is truncated";
+	}
+	if (
+		FileHeader->MeshTableOffset % 8 != 0
+		|| !IsSectionInside(FileHeader->MeshTableOffset, FileHeader->MeshCt, sizeof(MeshRecord), Sz)
+	) {
+		return "mesh table lies outside file";
+	}
+
+	const MeshRecord* Records = (const MeshRecord*)(Bytes + FileHeader->MeshTableOffset);
+	for (uint32 i = 0; i < FileHeader->MeshCt; i++) {
+		const MeshRecord& Record = Records[i];
+		const FIntVector& CellCounts = Record.CellCounts;
+		if (
+			!IsSectionInside(Record.VerticesOffset, Record.VertexCt, sizeof(FVector), Sz)
+			|| !IsSectionInside(Record.StoreOffset, Record.TriCt, TriGrid::GetStoreSz(1), Sz)
+			|| !IsSectionInside(Record.TriFlagsOffset, Record.TriCt, sizeof(uint32), Sz)
+			|| !IsSectionInside(Record.CellsOffset, Record.CellCapacity, sizeof(Cell), Sz)
+		) {
+			return "mesh section lies outside file";
+		}
+		if (
+			(Record.CellCapacity & (Record.CellCapacity - 1)) != 0
+			|| (Record.TriCt > 0 && Record.CellCapacity == 0)
+		) {
+			return "cell table capacity isn't a power of 2";
+		}
+		if (
+			CellCounts.X <= 0 || CellCounts.Y <= 0 || CellCounts.Z <= 0
+			|| (uint64)CellCounts.X * (uint64)CellCounts.Y * (uint64)CellCounts.Z > MAX_uint32
+		) {
+			return "bad grid cell counts";
+		}
+		const uint64 CellCt = (uint64)CellCounts.X * (uint64)CellCounts.Y * (uint64)CellCounts.Z;
+		if (Record.OverflowStart > Record.TriCt) {
+			return "overflow tris start past the last tri";
+		}
+
+		const NavMeshView View(Bytes, &Record);
+		const uint32* VIndices = View.GetVIndexBuffer();
+		for (uint32 j = 0; j < 3 * Record.TriCt; j++) {
+			if (VIndices[j] >= Record.VertexCt) {
+				return "tri vertex index out of range";
+			}
+		}
+		for (uint32 j = 0; j < Record.TriCt; j++) {
+			for (int Side = 0; Side < 3; Side++) {
+				const uint32 Neighbor = View.GetNeighbor(j, Side);
+				if (Neighbor != TriGrid::NO_NEIGHBOR && Neighbor >= Record.TriCt) {
+					return "tri neighbor index out of range";
+				}
+			}
+		}
+		const Cell* Cells = View.GetCells();
+		for (uint32 j = 0; j < Record.CellCapacity; j++) {
+			const Cell& C = Cells[j];
+			if (C.Key == TriGrid::EMPTY_KEY) {
+				continue;
+			}
+			if (C.Key >= CellCt || (uint64)C.StartIndex + (uint64)C.Num > Record.OverflowStart) {
+				return "grid cell out of range";
+			}
+		}
+	}
+	return nullptr;
+}
+
+bool NavMeshFile::Matches(const NavMeshView& View, const UNavMesh& NMesh) {
+	const TriGrid& Grid = NMesh.Grid;
+	if (
+		View.NumVertices() != NMesh.VertexCt
+		|| View.NumTris() != Grid.Num()
+		|| View.GetOverflowStart() != Grid.GetOverflowStart()
+	) {
+		return false;
+	}
+	if (memcmp(&View.GetBox(), &NMesh.Box, sizeof(BoundingBox)) != 0) {
+		return false;
+	}
+	if (NMesh.VertexCt > 0 && memcmp(View.GetVertices(), NMesh.Vertices, NMesh.VertexCt * sizeof(FVector)) != 0) {
+		return false;
+	}
+	if (Grid.Num() > 0 && memcmp(View.GetVIndexBuffer(), Grid.GetStore(), TriGrid::GetStoreSz(Grid.Num())) != 0) {
+		return false;
+	}
+	for (int i = 0; i < Grid.Num(); i++) {
+		if (View.GetTriFlags(i) != Grid[i].Flags) {
+			return false;
+		}
+	}
+	// every tri must be found through the view's cells where the grid put it
+	const TriGridCell* GridCells = Grid.GetCells();
+	const Cell* Cells = View.GetCells();
+	for (uint32 i = 0; i < Grid.GetCellCapacity(); i++) {
+		if (Cells[i].Key != GridCells[i].Key) {
+			return false;
+		}
+		if (
+			GridCells[i].Key != TriGrid::EMPTY_KEY
+			&& (
+				Cells[i].StartIndex != (uint32)GridCells[i].Box.GetStartIndex()
+				|| Cells[i].Num != (uint32)GridCells[i].Box.Num()
+			)
+		) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool NavMeshFile::Load(const MappedFile& File, TArray<UNavMesh>& NMeshes) {
+	// constructed in place, since UNavMesh can't be copied
+	const int FirstNMeshIndex = NMeshes.AddDefaulted(File.Num());
+	bool Success = true;
+	for (int i = 0; i < File.Num() && Success; i++) {
+		const NavMeshView View = File.GetMesh(i);
+		UNavMesh& NMesh = NMeshes[FirstNMeshIndex + i];
+		NMesh.Box = View.GetBox();
+		if (View.NumVertices() > 0) {
+			NMesh.Vertices = new FVector[View.NumVertices()];
+			memcpy(NMesh.Vertices, View.GetVertices(), View.NumVertices() * sizeof(FVector));
+			NMesh.VertexCt = View.NumVertices();
+		}
+		Success = NMesh.Grid.CopyFrom(View, NMesh.Vertices)
+			&& NMesh.BVH.Build(NMesh.Grid)
+			&& NMesh.Hierarchy.Build(NMesh);
+	}
+	if (!Success) {
+		for (int i = FirstNMeshIndex; i < NMeshes.Num(); i++) {
+			NMeshes[i].ResetVertexData();
+		}
+		NMeshes.SetNum(FirstNMeshIndex);
+	}
+	return Success;
+}
+
+FString NavMeshFile::GetPath(const FString& MapName) {
+	// under Content so it can be staged with the game; it isn't an asset, so it goes in as a non-UFS directory
+	return FPaths::Combine(FPaths::ProjectContentDir(), TEXT("UNav3D"), MapName + TEXT(".unav3d"));
+}
+
+NavMeshFile::MappedFile::MappedFile() :
+	Handle(nullptr), Region(nullptr), Bytes(nullptr)
+{}
+
+NavMeshFile::MappedFile::~MappedFile() {
+	Close();
+}
+
+bool NavMeshFile::MappedFile::Open(const FString& Path) {
+	Close();
+	Handle = FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path);
+	if (Handle == nullptr) {
+		return false;
+	}
+	Region = Handle->MapRegion();
+	if (Region == nullptr) {
+		Close();
+		return false;
+	}
+	const char* Error = Validate(Region->GetMappedPtr(), Region->GetMappedSize());
+	if (Error != nullptr) {
+		printf("TEMP ERROR NavMeshFile::MappedFile::Open() %s\n", Error);
+		Close();
+		return false;
+	}
+	Bytes = Region->GetMappedPtr();
+	return true;
+}
+
+void NavMeshFile::MappedFile::Close() {
+	// regions have to go before the handle they came from
+	delete Region;
+	Region = nullptr;
+	delete Handle;
+	Handle = nullptr;
+	Bytes = nullptr;
+}
+
+int NavMeshFile::MappedFile::Num() const {
+	return Bytes != nullptr ? ((const Header*)Bytes)->MeshCt : 0;
+}
+
+NavMeshFile::NavMeshView NavMeshFile::MappedFile::GetMesh(int i) const {
+	const Header* FileHeader = (const Header*)Bytes;
+	return NavMeshView(Bytes, (const MeshRecord*)(Bytes + FileHeader->MeshTableOffset) + i);
+}
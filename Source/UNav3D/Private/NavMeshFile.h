@@ -0,0 +1,169 @@
+﻿#pragma once
+
+#include "BoundingBox.h"
+
+struct UNavMesh;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// On-disk form of Data::NMeshes. Everything is addressed by byte offsets from the start of the file, so a file can be
+// memory mapped and read in place, with no parsing or pointer fixing. Load() copies a mapped file into navmeshes when
+// the editor opens its map. Layout:
+//   Header | MeshRecord * MeshCt | per mesh: vertices, grid store, tri flags, cell table
+// Sections start on SECTION_ALIGN boundaries. The grid store is TriGrid's structure-of-arrays block as is, up to the
+// tri flags, which get their own section: vertex indices (3 per tri), neighbors (3 per tri), neighbor flags, normals.
+// Bump VERSION whenever any of it changes.
+namespace NavMeshFile {
+
+	static constexpr uint32 MAGIC = 'U' | ('N' << 8) | ('3' << 16) | ('D' << 24);
+	static constexpr uint32 VERSION = 2;
+	static constexpr uint64 SECTION_ALIGN = 16;
+
+	struct Header {
+		uint32 Magic;
+		uint32 Version;
+		uint32 MeshCt;
+		uint32 Pad;
+		uint64 FileSz;
+		uint64 MeshTableOffset;
+	};
+
+	struct MeshRecord {
+		BoundingBox Box;
+		FVector GridMinimum;
+		FVector InvGridFactor;
+		FIntVector CellCounts;
+		uint32 VertexCt;
+		uint32 TriCt;
+		uint32 CellCapacity; // power of 2, or 0 if the mesh has no tris
+		uint32 OverflowStart; // tris from here on aren't in any cell; see TriGrid::GetOverflowStart()
+		uint32 Pad;
+		uint64 VerticesOffset;
+		uint64 StoreOffset;
+		uint64 TriFlagsOffset;
+		uint64 CellsOffset;
+	};
+
+	// mirrors TriGridCell; StartIndex and Num index into the grid's tris, which are sorted by cell
+	struct Cell {
+		uint32 Key;
+		uint32 StartIndex;
+		uint32 Num;
+	};
+
+	// Read-only view of one navmesh in a mapped file, with the same accessors as TriGrid. Only valid while the file
+	// stays mapped
+	class NavMeshView {
+
+	public:
+
+		NavMeshView(const uint8* _FileBytes, const MeshRecord* _Record);
+
+		int NumVertices() const {
+			return Record->VertexCt;
+		}
+
+		int NumTris() const {
+			return Record->TriCt;
+		}
+
+		int GetOverflowStart() const {
+			return Record->OverflowStart;
+		}
+
+		const BoundingBox& GetBox() const {
+			return Record->Box;
+		}
+
+		const MeshRecord& GetRecord() const {
+			return *Record;
+		}
+
+		const FVector* GetVertices() const {
+			return (const FVector*)(FileBytes + Record->VerticesOffset);
+		}
+
+		// vertex indices of every tri, 3 per tri (A, B, C)
+		const uint32* GetVIndexBuffer() const {
+			return (const uint32*)(FileBytes + Record->StoreOffset);
+		}
+
+		// index of the tri on the given side (Tri::AB, Tri::BC, Tri::CA) of tri i; TriGrid::NO_NEIGHBOR if open
+		uint32 GetNeighbor(int i, int Side) const {
+			return (GetVIndexBuffer() + 3 * Record->TriCt)[3 * i + Side];
+		}
+
+		uint32 GetNeighborFlags(int i) const {
+			return (GetVIndexBuffer() + 6 * Record->TriCt)[i];
+		}
+
+		const FVector& GetNormal(int i) const {
+			return ((const FVector*)(GetVIndexBuffer() + 7 * Record->TriCt))[i];
+		}
+
+		// Tri::Flags of tri i
+		uint32 GetTriFlags(int i) const {
+			return ((const uint32*)(FileBytes + Record->TriFlagsOffset))[i];
+		}
+
+		const Cell* GetCells() const {
+			return (const Cell*)(FileBytes + Record->CellsOffset);
+		}
+
+		// the tris in the cell holding Location are StartIndex through StartIndex + Num - 1; false if Location is
+		// outside the grid or its cell is empty. Overflow tris, from GetOverflowStart() on, aren't in any cell
+		bool GetCellTris(const FVector& Location, uint32& StartIndex, uint32& Num) const;
+
+	private:
+
+		const uint8* FileBytes;
+		const MeshRecord* Record;
+
+	};
+
+	// writes every mesh in NMeshes to Path, replacing whatever is there
+	bool Write(const TArray<UNavMesh>& NMeshes, const FString& Path);
+
+	// nullptr if Bytes holds a well-formed file of this version: every section lies inside the file and every vertex,
+	// neighbor and cell index is in range. Otherwise, what's wrong with it
+	const char* Validate(const uint8* Bytes, uint64 Sz);
+
+	// checks that View holds exactly what NMesh does; for checking that a written file reads back the same
+	bool Matches(const NavMeshView& View, const UNavMesh& NMesh);
+
+	class MappedFile;
+
+	// appends a navmesh to NMeshes for every mesh in File, copied out of the mapping so File can be closed after. The
+	// BVH and hierarchy aren't saved, so they're rebuilt here. False, with nothing appended, if an allocation fails
+	bool Load(const MappedFile& File, TArray<UNavMesh>& NMeshes);
+
+	// where the navmeshes of the given map are saved
+	FString GetPath(const FString& MapName);
+
+	// A navmesh file mapped into memory and validated. Meshes are read straight from the mapping
+	class MappedFile {
+
+	public:
+
+		MappedFile();
+
+		~MappedFile();
+
+		// unmaps any file already open; false if Path can't be mapped or fails Validate()
+		bool Open(const FString& Path);
+
+		void Close();
+
+		int Num() const;
+
+		NavMeshView GetMesh(int i) const;
+
+	private:
+
+		IMappedFileHandle* Handle;
+		IMappedFileRegion* Region;
+		const uint8* Bytes;
+
+	};
+
+}
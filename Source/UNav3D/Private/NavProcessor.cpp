@@ -1,5 +1,507 @@
 ﻿#include "NavProcessor.h"
+#include "UNavMesh.h"
+#include "Algo/Reverse.h"
 
-void NavProcessor::DoSomething(TArray<UNavMesh>& NMeshes) {
-	
+namespace {
+
+	// portals between tris whose normals are further apart than this (about 2.5 degrees) are folds
+	constexpr float FOLD_COS = 0.999f;
+
+	void PushOpen(NavProcessor::SearchSpace& Space, uint32 TriIndex, float F) {
+		int i = Space.OpenCt++;
+		while (i > 0) {
+			const int ParentIndex = (i - 1) / 2;
+			if (Space.Open[ParentIndex].F <= F) {
+				break;
+			}
+			Space.Open[i] = Space.Open[ParentIndex];
+			i = ParentIndex;
+		}
+		Space.Open[i].F = F;
+		Space.Open[i].TriIndex = TriIndex;
+	}
+
+	NavProcessor::SearchSpace::OpenEntry PopOpen(NavProcessor::SearchSpace& Space) {
+		const NavProcessor::SearchSpace::OpenEntry Top = Space.Open[0];
+		const NavProcessor::SearchSpace::OpenEntry Last = Space.Open[--Space.OpenCt];
+		int i = 0;
+		while (true) {
+			int Child = 2 * i + 1;
+			if (Child >= Space.OpenCt) {
+				break;
+			}
+			if (Child + 1 < Space.OpenCt && Space.Open[Child + 1].F < Space.Open[Child].F) {
+				Child++;
+			}
+			if (Last.F <= Space.Open[Child].F) {
+				break;
+			}
+			Space.Open[i] = Space.Open[Child];
+			i = Child;
+		}
+		if (Space.OpenCt > 0) {
+			Space.Open[i] = Last;
+		}
+		return Top;
+	}
+
+	// pushes every unclosed neighbor of tri TriIndex reached more cheaply through it. F is G plus the straight-line
+	// distance to HeuristicTarget, or just G if there's none. If TriClusters is given, only neighbors in the same
+	// cluster are pushed
+	void ExpandTri(
+		const TriGrid& Grid,
+		uint32 TriIndex,
+		NavProcessor::SearchSpace& Space,
+		const FVector* HeuristicTarget,
+		const uint32* TriClusters = nullptr
+	) {
+		const FVector* Vertices = Grid.GetVertices();
+		const uint32* TriVIndices = Grid.GetVIndexBuffer() + 3 * TriIndex;
+		const NavProcessor::SearchSpace::Node& Current = Space.Nodes[TriIndex];
+		for (int Side = 0; Side < 3; Side++) {
+			const uint32 Neighbor = Grid.GetNeighbor(TriIndex, Side);
+			if (
+				Neighbor == TriGrid::NO_NEIGHBOR
+				|| (TriClusters != nullptr && TriClusters[Neighbor] != TriClusters[TriIndex])
+			) {
+				continue;
+			}
+			NavProcessor::SearchSpace::Node& Next = Space.Nodes[Neighbor];
+			if (Next.ClosedGeneration == Space.Generation) {
+				continue;
+			}
+			// side AB is vertices 0-1, BC 1-2 and CA 2-0
+			const FVector Portal = (Vertices[TriVIndices[Side]] + Vertices[TriVIndices[(Side + 1) % 3]]) * 0.5f;
+			const float G = Current.G + FVector::Dist(Current.Position, Portal);
+			if (Next.Generation == Space.Generation && G >= Next.G) {
+				continue;
+			}
+			Next.Position = Portal;
+			Next.G = G;
+			Next.Parent = TriIndex;
+			Next.Generation = Space.Generation;
+			PushOpen(Space, Neighbor, HeuristicTarget != nullptr ? G + FVector::Dist(Portal, *HeuristicTarget) : G);
+		}
+	}
+
+	// starts a new generation in Space with only StartTri, at Start, open
+	void StartSearch(
+		NavProcessor::SearchSpace& Space,
+		const TriGrid& Grid,
+		uint32 StartTri,
+		const FVector& Start,
+		float F
+	) {
+		Space.Reserve(Grid.Num());
+		Space.NextGeneration();
+		NavProcessor::SearchSpace::Node& StartNode = Space.Nodes[StartTri];
+		StartNode.Position = Start;
+		StartNode.G = 0.0f;
+		StartNode.Parent = TriGrid::NO_NEIGHBOR;
+		StartNode.Generation = Space.Generation;
+		PushOpen(Space, StartTri, F);
+	}
+
+	// where R lands when its tri is unfolded about side P-Q, which is already at p-q; on the left of p->q if Side is
+	// positive, on the right if negative. Distances to P and Q are kept, so the unfolding is isometric
+	FVector2D UnfoldVertex(
+		const FVector& P,
+		const FVector& Q,
+		const FVector& R,
+		const FVector2D& p,
+		const FVector2D& q,
+		float Side
+	) {
+		const FVector Edge = Q - P;
+		const float EdgeSqLen = Edge.SizeSquared();
+		const FVector2D Edge2D = q - p;
+		const float EdgeLen2D = Edge2D.Size();
+		if (EdgeSqLen == 0.0f || EdgeLen2D == 0.0f) {
+			return p;
+		}
+		const float T = FVector::DotProduct(R - P, Edge) / EdgeSqLen;
+		const float Height = FVector::Dist(R, P + Edge * T);
+		const FVector2D LeftNormal(-Edge2D.Y / EdgeLen2D, Edge2D.X / EdgeLen2D);
+		return p + Edge2D * T + LeftNormal * (Side * Height);
+	}
+
+	// Point, projected onto the tri with 3D vertices V and unfolded vertices V2D, in the unfolded plane
+	FVector2D UnfoldPoint(const FVector& Point, const FVector* V, const FVector2D* V2D) {
+		const FVector Bary = FMath::ComputeBaryCentric2D(Point, V[0], V[1], V[2]);
+		return V2D[0] * Bary.X + V2D[1] * Bary.Y + V2D[2] * Bary.Z;
+	}
+
+	// adds the funnel's next waypoint, To at portal ToIndex, along with the points where the straight (unfolded) line
+	// to it from portal FromIndex crosses folds
+	void AddWaypoint(
+		const TArray<NavProcessor::SearchSpace::Portal>& Portals,
+		int FromIndex,
+		const FVector2D& From2D,
+		int ToIndex,
+		const FVector2D& To2D,
+		const FVector& To,
+		TArray<FVector>& Points
+	) {
+		const FVector2D Dir = To2D - From2D;
+		for (int i = FromIndex + 1; i < ToIndex; i++) {
+			const NavProcessor::SearchSpace::Portal& Portal = Portals[i];
+			if (!Portal.IsFold) {
+				continue;
+			}
+			const float Denom = FVector2D::CrossProduct(Dir, Portal.Right2D - Portal.Left2D);
+			if (Denom == 0.0f) {
+				continue;
+			}
+			const float U = FMath::Clamp(FVector2D::CrossProduct(Dir, From2D - Portal.Left2D) / Denom, 0.0f, 1.0f);
+			Points.Add(FMath::Lerp(Portal.Left, Portal.Right, U));
+		}
+		if (Points.Num() == 0 || Points.Last() != To) {
+			Points.Add(To);
+		}
+	}
+
+}
+
+NavProcessor::SearchSpace::SearchSpace() :
+	OpenCt(0), Generation(0), FlowGoalTri(TriGrid::NO_NEIGHBOR)
+{}
+
+void NavProcessor::SearchSpace::Reserve(int TriCt) {
+	if (Nodes.Num() < TriCt) {
+		// zeroed, so no entry carries a live generation
+		Nodes.SetNumZeroed(TriCt);
+		Open.SetNumUninitialized(3 * TriCt + 1);
+		// a corridor crosses at most every tri
+		Portals.Reserve(TriCt + 1);
+	}
+}
+
+void NavProcessor::SearchSpace::NextGeneration() {
+	OpenCt = 0;
+	Generation++;
+	if (Generation == 0) {
+		// wrapped; stamps this old could be mistaken for current ones
+		for (int i = 0; i < Nodes.Num(); i++) {
+			Nodes[i].Generation = 0;
+			Nodes[i].ClosedGeneration = 0;
+			Nodes[i].TargetGeneration = 0;
+		}
+		Generation = 1;
+	}
+}
+
+bool NavProcessor::FindClosestTri(
+	const UNavMesh& NMesh,
+	const FVector& Point,
+	float MaxDist,
+	uint32& TriIndex,
+	FVector& ClosestPoint
+) {
+	return NMesh.BVH.FindClosestTri(NMesh.Grid, Point, MaxDist, TriIndex, ClosestPoint);
+}
+
+int NavProcessor::FindClosestSurfacePoint(
+	const TArray<UNavMesh>& NMeshes,
+	const FVector& Point,
+	float MaxDist,
+	uint32& TriIndex,
+	FVector& ClosestPoint
+) {
+	int MeshIndex = -1;
+	// each mesh's search is cut off at the best distance so far
+	float BestDist = MaxDist;
+	for (int i = 0; i < NMeshes.Num(); i++) {
+		uint32 MeshTriIndex;
+		FVector MeshClosestPoint;
+		if (FindClosestTri(NMeshes[i], Point, BestDist, MeshTriIndex, MeshClosestPoint)) {
+			BestDist = FVector::Dist(Point, MeshClosestPoint);
+			MeshIndex = i;
+			TriIndex = MeshTriIndex;
+			ClosestPoint = MeshClosestPoint;
+		}
+	}
+	return MeshIndex;
+}
+
+bool NavProcessor::FindPath(
+	const UNavMesh& NMesh,
+	uint32 StartTri,
+	const FVector& Start,
+	uint32 GoalTri,
+	const FVector& Goal,
+	SearchSpace& Space,
+	TArray<uint32>& Corridor,
+	TArray<FVector>& Points
+) {
+	const TriGrid& Grid = NMesh.Grid;
+	Corridor.Reset();
+	Points.Reset();
+	if (StartTri >= (uint32)Grid.Num() || GoalTri >= (uint32)Grid.Num()) {
+		return false;
+	}
+	StartSearch(Space, Grid, StartTri, Start, FVector::Dist(Start, Goal));
+	Space.FlowGoalTri = TriGrid::NO_NEIGHBOR;
+	const uint32 Generation = Space.Generation;
+
+	bool Found = false;
+	while (Space.OpenCt > 0) {
+		const uint32 TriIndex = PopOpen(Space).TriIndex;
+		SearchSpace::Node& Current = Space.Nodes[TriIndex];
+		if (Current.ClosedGeneration == Generation) {
+			// reached more cheaply since this entry was pushed
+			continue;
+		}
+		Current.ClosedGeneration = Generation;
+		if (TriIndex == GoalTri) {
+			Found = true;
+			break;
+		}
+		ExpandTri(Grid, TriIndex, Space, &Goal);
+	}
+	if (!Found) {
+		return false;
+	}
+
+	for (uint32 TriIndex = GoalTri; TriIndex != TriGrid::NO_NEIGHBOR; TriIndex = Space.Nodes[TriIndex].Parent) {
+		Corridor.Add(TriIndex);
+	}
+	Algo::Reverse(Corridor);
+	Points.Reserve(Corridor.Num() + 1);
+	for (int i = 0; i < Corridor.Num(); i++) {
+		Points.Add(Space.Nodes[Corridor[i]].Position);
+	}
+	Points.Add(Goal);
+	return true;
+}
+
+void NavProcessor::BuildFlowField(
+	const UNavMesh& NMesh,
+	uint32 GoalTri,
+	const FVector& Goal,
+	const TArray<uint32>& StartTris,
+	SearchSpace& Space
+) {
+	const TriGrid& Grid = NMesh.Grid;
+	Space.FlowGoalTri = TriGrid::NO_NEIGHBOR;
+	if (GoalTri >= (uint32)Grid.Num()) {
+		return;
+	}
+	StartSearch(Space, Grid, GoalTri, Goal, 0.0f);
+	Space.FlowGoalTri = GoalTri;
+	const uint32 Generation = Space.Generation;
+
+	int RemainingCt = 0;
+	for (int i = 0; i < StartTris.Num(); i++) {
+		SearchSpace::Node& Target = Space.Nodes[StartTris[i]];
+		if (Target.TargetGeneration != Generation) {
+			Target.TargetGeneration = Generation;
+			RemainingCt++;
+		}
+	}
+
+	while (Space.OpenCt > 0 && RemainingCt > 0) {
+		const uint32 TriIndex = PopOpen(Space).TriIndex;
+		SearchSpace::Node& Current = Space.Nodes[TriIndex];
+		if (Current.ClosedGeneration == Generation) {
+			continue;
+		}
+		Current.ClosedGeneration = Generation;
+		if (Current.TargetGeneration == Generation) {
+			RemainingCt--;
+		}
+		ExpandTri(Grid, TriIndex, Space, nullptr);
+	}
+}
+
+void NavProcessor::SearchCluster(
+	const UNavMesh& NMesh,
+	uint32 FromTri,
+	const FVector& From,
+	const uint32* TriClusters,
+	SearchSpace& Space
+) {
+	const TriGrid& Grid = NMesh.Grid;
+	Space.FlowGoalTri = TriGrid::NO_NEIGHBOR;
+	if (FromTri >= (uint32)Grid.Num()) {
+		return;
+	}
+	StartSearch(Space, Grid, FromTri, From, 0.0f);
+	const uint32 Generation = Space.Generation;
+	while (Space.OpenCt > 0) {
+		const uint32 TriIndex = PopOpen(Space).TriIndex;
+		SearchSpace::Node& Current = Space.Nodes[TriIndex];
+		if (Current.ClosedGeneration == Generation) {
+			continue;
+		}
+		Current.ClosedGeneration = Generation;
+		ExpandTri(Grid, TriIndex, Space, nullptr, TriClusters);
+	}
+}
+
+float NavProcessor::GetSearchedDist(const SearchSpace& Space, uint32 TriIndex, const FVector& Point) {
+	if (TriIndex >= (uint32)Space.Nodes.Num() || Space.Nodes[TriIndex].Generation != Space.Generation) {
+		return MAX_flt;
+	}
+	const SearchSpace::Node& Node = Space.Nodes[TriIndex];
+	return Node.G + FVector::Dist(Node.Position, Point);
+}
+
+bool NavProcessor::GetFlowPath(
+	uint32 StartTri,
+	const FVector& Start,
+	const FVector& Goal,
+	const SearchSpace& Space,
+	TArray<uint32>& Corridor,
+	TArray<FVector>& Points
+) {
+	Corridor.Reset();
+	Points.Reset();
+	if (
+		Space.FlowGoalTri == TriGrid::NO_NEIGHBOR
+		|| StartTri >= (uint32)Space.Nodes.Num()
+		|| Space.Nodes[StartTri].ClosedGeneration != Space.Generation
+	) {
+		return false;
+	}
+	// each tri's Position is the midpoint of the side it shares with its Parent, the next tri toward the goal
+	Points.Add(Start);
+	for (uint32 TriIndex = StartTri; TriIndex != TriGrid::NO_NEIGHBOR; TriIndex = Space.Nodes[TriIndex].Parent) {
+		Corridor.Add(TriIndex);
+		if (TriIndex != Space.FlowGoalTri) {
+			Points.Add(Space.Nodes[TriIndex].Position);
+		}
+	}
+	Points.Add(Goal);
+	return true;
+}
+
+bool NavProcessor::StraightenPath(
+	const UNavMesh& NMesh,
+	const TArray<uint32>& Corridor,
+	const FVector& Start,
+	const FVector& Goal,
+	SearchSpace& Space,
+	TArray<FVector>& Points
+) {
+	if (Corridor.Num() == 0) {
+		return false;
+	}
+	const TriGrid& Grid = NMesh.Grid;
+	const FVector* Vertices = Grid.GetVertices();
+	const uint32* VIndices = Grid.GetVIndexBuffer();
+	TArray<SearchSpace::Portal>& Portals = Space.Portals;
+	Portals.SetNum(Corridor.Num() + 1, false);
+
+	// unfolding the first tri in its own plane, A at the origin and B along X
+	const uint32* TriVIndices = VIndices + 3 * Corridor[0];
+	FVector TriV[3] = {Vertices[TriVIndices[0]], Vertices[TriVIndices[1]], Vertices[TriVIndices[2]]};
+	FVector2D TriV2D[3];
+	TriV2D[0] = FVector2D(0.0f, 0.0f);
+	TriV2D[1] = FVector2D(FVector::Dist(TriV[0], TriV[1]), 0.0f);
+	TriV2D[2] = UnfoldVertex(TriV[0], TriV[1], TriV[2], TriV2D[0], TriV2D[1], 1.0f);
+	SearchSpace::Portal& First = Portals[0];
+	First.Left = First.Right = Start;
+	First.Left2D = First.Right2D = UnfoldPoint(Start, TriV, TriV2D);
+	First.IsFold = false;
+
+	// then each next tri about the side it shares with the last, onto the far side of it
+	for (int i = 0; i < Corridor.Num() - 1; i++) {
+		const uint32 TriIndex = Corridor[i];
+		const uint32 NextIndex = Corridor[i + 1];
+		int Side = 0;
+		while (Side < 3 && Grid.GetNeighbor(TriIndex, Side) != NextIndex) {
+			Side++;
+		}
+		if (Side == 3) {
+			return false;
+		}
+		const int C0 = Side;
+		const int C1 = (Side + 1) % 3;
+		const int Opposite = (Side + 2) % 3;
+		const FVector2D Edge2D = TriV2D[C1] - TriV2D[C0];
+		const bool IsOppositeLeft = FVector2D::CrossProduct(Edge2D, TriV2D[Opposite] - TriV2D[C0]) > 0.0f;
+
+		// travelling away from the opposite vertex, the side's far end is on the left if that vertex is
+		SearchSpace::Portal& Portal = Portals[i + 1];
+		const int LeftCorner = IsOppositeLeft ? C1 : C0;
+		const int RightCorner = IsOppositeLeft ? C0 : C1;
+		Portal.Left = TriV[LeftCorner];
+		Portal.Right = TriV[RightCorner];
+		Portal.Left2D = TriV2D[LeftCorner];
+		Portal.Right2D = TriV2D[RightCorner];
+		Portal.IsFold = FVector::DotProduct(Grid.GetNormal(TriIndex), Grid.GetNormal(NextIndex)) < FOLD_COS;
+
+		// the shared vertices keep their unfolded positions exactly, so the funnel sees them as the same points
+		const uint32 Shared0 = TriVIndices[C0];
+		const uint32 Shared1 = TriVIndices[C1];
+		const FVector2D Shared02D = TriV2D[C0];
+		const FVector2D Shared12D = TriV2D[C1];
+		const FVector SharedV0 = TriV[C0];
+		const FVector SharedV1 = TriV[C1];
+		TriVIndices = VIndices + 3 * NextIndex;
+		for (int j = 0; j < 3; j++) {
+			TriV[j] = Vertices[TriVIndices[j]];
+			if (TriVIndices[j] == Shared0) {
+				TriV2D[j] = Shared02D;
+			}
+			else if (TriVIndices[j] == Shared1) {
+				TriV2D[j] = Shared12D;
+			}
+			else {
+				TriV2D[j] = UnfoldVertex(
+					SharedV0, SharedV1, TriV[j], Shared02D, Shared12D, IsOppositeLeft ? -1.0f : 1.0f
+				);
+			}
+		}
+	}
+	SearchSpace::Portal& Last = Portals.Last();
+	Last.Left = Last.Right = Goal;
+	Last.Left2D = Last.Right2D = UnfoldPoint(Goal, TriV, TriV2D);
+	Last.IsFold = false;
+
+	// simple stupid funnel: the funnel narrows portal by portal, and when one side crosses the other, the side it
+	// crossed becomes the new apex and the walk restarts from there
+	Points.Reset();
+	Points.Add(Start);
+	FVector2D Apex2D = Portals[0].Left2D;
+	FVector2D Left2D = Apex2D;
+	FVector2D Right2D = Apex2D;
+	int ApexIndex = 0;
+	int LeftIndex = 0;
+	int RightIndex = 0;
+	for (int i = 1; i < Portals.Num(); i++) {
+		const SearchSpace::Portal& Portal = Portals[i];
+
+		// narrowing the right side, unless it would cross the left
+		if (FVector2D::CrossProduct(Right2D - Apex2D, Portal.Right2D - Apex2D) >= 0.0f) {
+			if (Apex2D == Right2D || FVector2D::CrossProduct(Left2D - Apex2D, Portal.Right2D - Apex2D) < 0.0f) {
+				Right2D = Portal.Right2D;
+				RightIndex = i;
+			}
+			else {
+				AddWaypoint(Portals, ApexIndex, Apex2D, LeftIndex, Left2D, Portals[LeftIndex].Left, Points);
+				Apex2D = Right2D = Left2D;
+				ApexIndex = RightIndex = LeftIndex;
+				i = ApexIndex;
+				continue;
+			}
+		}
+
+		// narrowing the left side, unless it would cross the right
+		if (FVector2D::CrossProduct(Left2D - Apex2D, Portal.Left2D - Apex2D) <= 0.0f) {
+			if (Apex2D == Left2D || FVector2D::CrossProduct(Right2D - Apex2D, Portal.Left2D - Apex2D) > 0.0f) {
+				Left2D = Portal.Left2D;
+				LeftIndex = i;
+			}
+			else {
+				AddWaypoint(Portals, ApexIndex, Apex2D, RightIndex, Right2D, Portals[RightIndex].Right, Points);
+				Apex2D = Left2D = Right2D;
+				ApexIndex = LeftIndex = RightIndex;
+				i = ApexIndex;
+				continue;
+			}
+		}
+	}
+	AddWaypoint(Portals, ApexIndex, Apex2D, Portals.Num() - 1, Portals.Last().Left2D, Goal, Points);
+	return true;
 }
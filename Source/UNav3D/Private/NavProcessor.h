@@ -2,8 +2,140 @@
 
 struct UNavMesh;
 
+// Path queries over a UNavMesh's tri surface. Tris are the graph's nodes and shared sides its edges; a path crosses
+// each side at its midpoint
 namespace NavProcessor {
 
-	void DoSomething(TArray<UNavMesh>& NMeshes);
-	
-}
\ No newline at end of file
+	// Search memory for FindPath(), sized once for the largest mesh searched so that searches don't allocate. Per-tri
+	// entries are only valid if stamped with the current search's generation, so nothing is cleared between searches.
+	// Not thread safe; one per searching thread
+	struct SearchSpace {
+
+		SearchSpace();
+
+		// grows every array to fit a mesh of TriCt tris
+		void Reserve(int TriCt);
+
+		// starts a new search; entries stamped by earlier searches become stale
+		void NextGeneration();
+
+		struct Node {
+			FVector Position; // where the path enters the tri: its start point or a side's midpoint
+			float G; // path length from the start to Position
+			uint32 Parent; // tri the path came from; TriGrid::NO_NEIGHBOR for the start tri
+			uint32 Generation; // G, Parent and Position belong to the search of this generation
+			uint32 ClosedGeneration; // tri was expanded in the search of this generation
+			uint32 TargetGeneration; // tri is one BuildFlowField() of this generation has to reach
+		};
+
+		struct OpenEntry {
+			float F;
+			uint32 TriIndex;
+		};
+
+		TArray<Node> Nodes;
+		// binary min heap on F, OpenCt long. Entries whose tri has since been reached more cheaply are left in and
+		// skipped when popped, so it holds at most one entry per tri side plus the start
+		TArray<OpenEntry> Open;
+		int OpenCt;
+		uint32 Generation;
+		// set by BuildFlowField(); Parent then points one tri toward this goal rather than back toward a start
+		uint32 FlowGoalTri;
+
+		// a side StraightenPath() crosses, as seen travelling along the corridor
+		struct Portal {
+			FVector Left;
+			FVector Right;
+			FVector2D Left2D; // unfolded into the plane of the corridor's first tri
+			FVector2D Right2D;
+			bool IsFold; // the tris on either side face different ways, so the path bends here in 3D
+		};
+
+		// StraightenPath()'s portals: the start, each side crossed, then the goal
+		TArray<Portal> Portals;
+	};
+
+	// the tri of NMesh closest to Point and the closest point on it, if any are within MaxDist of it. Exact, and only
+	// reads the mesh, so it's safe from any thread
+	bool FindClosestTri(
+		const UNavMesh& NMesh,
+		const FVector& Point,
+		float MaxDist,
+		uint32& TriIndex,
+		FVector& ClosestPoint
+	);
+
+	// FindClosestTri() over every mesh; the index of the mesh closest to Point, or -1 if none are within MaxDist
+	int FindClosestSurfacePoint(
+		const TArray<UNavMesh>& NMeshes,
+		const FVector& Point,
+		float MaxDist,
+		uint32& TriIndex,
+		FVector& ClosestPoint
+	);
+
+	// A* from Start on tri StartTri to Goal on tri GoalTri, with straight-line distance as the heuristic. Fills
+	// Corridor with the tris crossed, start to goal, and Points with Start, the midpoints of the sides crossed, then
+	// Goal. False if the tris aren't connected
+	bool FindPath(
+		const UNavMesh& NMesh,
+		uint32 StartTri,
+		const FVector& Start,
+		uint32 GoalTri,
+		const FVector& Goal,
+		SearchSpace& Space,
+		TArray<uint32>& Corridor,
+		TArray<FVector>& Points
+	);
+
+	// Dijkstra outward from Goal on tri GoalTri, stopping once every tri in StartTris is reached. Every reached tri's
+	// Parent is left pointing one step toward the goal, so paths from all of StartTris come from one search; read
+	// them with GetFlowPath(). Legs from each start point to its first side aren't counted, so paths are slightly
+	// less tight than FindPath()'s
+	void BuildFlowField(
+		const UNavMesh& NMesh,
+		uint32 GoalTri,
+		const FVector& Goal,
+		const TArray<uint32>& StartTris,
+		SearchSpace& Space
+	);
+
+	// Dijkstra from From on tri FromTri through every tri with the same entry in TriClusters, and no others. Read the
+	// distances found with GetSearchedDist()
+	void SearchCluster(
+		const UNavMesh& NMesh,
+		uint32 FromTri,
+		const FVector& From,
+		const uint32* TriClusters,
+		SearchSpace& Space
+	);
+
+	// path length to Point on tri TriIndex in the search last run in Space; MAX_flt if it wasn't reached
+	float GetSearchedDist(const SearchSpace& Space, uint32 TriIndex, const FVector& Point);
+
+	// the path from Start on tri StartTri to Goal along the field last built in Space, filled as FindPath() does.
+	// False if the field didn't reach StartTri
+	bool GetFlowPath(
+		uint32 StartTri,
+		const FVector& Start,
+		const FVector& Goal,
+		const SearchSpace& Space,
+		TArray<uint32>& Corridor,
+		TArray<FVector>& Points
+	);
+
+	// Straightens a path along Corridor, as FindPath() or GetFlowPath() leave it, into Start, the corridor vertices it
+	// bends around, the points where it crosses a fold between tris facing different ways, and Goal. Corridor tris are
+	// unfolded one by one about their shared sides into a single plane and funneled there, so paths wrap over edges
+	// between floors, walls and ceilings. Linear in the corridor's length. False, with Points untouched, if
+	// consecutive corridor tris aren't neighbors
+	bool StraightenPath(
+		const UNavMesh& NMesh,
+		const TArray<uint32>& Corridor,
+		const FVector& Start,
+		const FVector& Goal,
+		SearchSpace& Space,
+		TArray<FVector>& Points
+	);
+
+}
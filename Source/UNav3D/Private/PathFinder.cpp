@@ -1,19 +1,67 @@
 ﻿#include "PathFinder.h"
+#include "UNavMesh.h"
 
-FPathFinder::FPathFinder() :
+PathResultRing::PathResultRing() {
+	Slots.SetNum(CAPACITY);
+}
+
+PathResult* PathResultRing::GetWriteSlot() {
+	const uint32 Written = (uint32)WriteCt.GetValue();
+	if (Written - (uint32)ReadCt.GetValue() >= (uint32)CAPACITY) {
+		return nullptr;
+	}
+	return &Slots[Written & (CAPACITY - 1)];
+}
+
+void PathResultRing::Publish() {
+	WriteCt.Increment();
+}
+
+const PathResult* PathResultRing::Peek() const {
+	const uint32 Read = (uint32)ReadCt.GetValue();
+	if (Read == (uint32)WriteCt.GetValue()) {
+		return nullptr;
+	}
+	return &Slots[Read & (CAPACITY - 1)];
+}
+
+void PathResultRing::Release() {
+	ReadCt.Increment();
+}
+
+FPathFinder::FPathFinder(const TArray<UNavMesh>& _NMeshes) :
+	NMeshes(_NMeshes),
+	RequestEvent(FPlatformProcess::GetSynchEventFromPool(false)),
 	IsThreadRun(false)
-{}
+{
+	// sizing search memory for the largest mesh up front, so searches never allocate
+	int MaxTriCt = 0;
+	for (int i = 0; i < NMeshes.Num(); i++) {
+		MaxTriCt = FMath::Max(MaxTriCt, NMeshes[i].Grid.Num());
+	}
+	Space.Reserve(MaxTriCt);
+	for (int i = 0; i < NMeshes.Num(); i++) {
+		HierarchySpace.Reserve(NMeshes[i].Hierarchy);
+	}
+	Pending.Reserve(MAX_BATCH_SZ);
+	Snapped.Reserve(MAX_BATCH_SZ);
+	GroupStartTris.Reserve(MAX_BATCH_SZ);
+}
 
 FPathFinder::~FPathFinder() {
 	StopThread();
+	FPlatformProcess::ReturnSynchEventToPool(RequestEvent);
+	RequestEvent = nullptr;
 }
 
 bool FPathFinder::StartThread() {
 	if (!Thread.IsValid()) {
-		Thread = TUniquePtr<FRunnableThread>(FRunnableThread::Create(this, TEXT("Grid Generator")));
+		IsThreadRun = true;
+		Thread = TUniquePtr<FRunnableThread>(FRunnableThread::Create(this, TEXT("UNav3D Path Finder")));
 		if (Thread.IsValid()) {
 			return true;
 		}
+		IsThreadRun = false;
 	}
 	return false;
 }
@@ -24,7 +72,7 @@ void FPathFinder::StopThread() {
 		RawThread->Kill();
 		RawThread->WaitForCompletion();
 		Thread.Reset();
-	}	
+	}
 }
 
 #pragma endregion
@@ -34,11 +82,167 @@ bool FPathFinder::Init() {
 }
 
 uint32 FPathFinder::Run() {
-	
+	while (IsThreadRun) {
+		Pending.Reset();
+		PathRequest Request;
+		while (Pending.Num() < MAX_BATCH_SZ && Requests.Dequeue(Request)) {
+			Pending.Add(Request);
+		}
+		if (Pending.Num() == 0) {
+			RequestEvent->Wait();
+			continue;
+		}
+		AnswerPending();
+	}
 	return 0;
 }
 
 void FPathFinder::Stop() {
-	// code goes here
+	IsThreadRun = false;
+	RequestEvent->Trigger();
 	FRunnable::Stop();
-}
\ No newline at end of file
+}
+
+uint32 FPathFinder::RequestPath(const FVector& Start, const FVector& Goal) {
+	PathRequest Request;
+	Request.RequestId = (uint32)NextRequestId.Increment();
+	Request.Start = Start;
+	Request.Goal = Goal;
+	Requests.Enqueue(Request);
+	RequestEvent->Trigger();
+	return Request.RequestId;
+}
+
+uint32 FPathFinder::RequestPaths(const TArray<PathQuery>& Queries) {
+	const uint32 FirstId = (uint32)NextRequestId.Add(Queries.Num()) + 1;
+	for (int i = 0; i < Queries.Num(); i++) {
+		PathRequest Request;
+		Request.RequestId = FirstId + i;
+		Request.Start = Queries[i].Start;
+		Request.Goal = Queries[i].Goal;
+		Requests.Enqueue(Request);
+	}
+	RequestEvent->Trigger();
+	return FirstId;
+}
+
+const PathResult* FPathFinder::PeekResult() const {
+	return Results.Peek();
+}
+
+void FPathFinder::PopResult() {
+	Results.Release();
+}
+
+void FPathFinder::SnapRequest(const PathRequest& Request, SnappedRequest& Snap) {
+	Snap.MeshIndex = -1;
+	// so requests that can't be answered sort together
+	Snap.StartTri = 0;
+	Snap.GoalTri = 0;
+
+	// searching the mesh both ends are closest to; meshes aren't connected to each other
+	float BestDist = MAX_flt;
+	for (int i = 0; i < NMeshes.Num(); i++) {
+		uint32 MeshStartTri, MeshGoalTri;
+		FVector StartPoint, GoalPoint;
+		if (
+			!NavProcessor::FindClosestTri(NMeshes[i], Request.Start, SNAP_DIST, MeshStartTri, StartPoint)
+			|| !NavProcessor::FindClosestTri(NMeshes[i], Request.Goal, SNAP_DIST, MeshGoalTri, GoalPoint)
+		) {
+			continue;
+		}
+		const float Dist = FVector::Dist(Request.Start, StartPoint) + FVector::Dist(Request.Goal, GoalPoint);
+		if (Dist < BestDist) {
+			BestDist = Dist;
+			Snap.MeshIndex = i;
+			Snap.StartTri = MeshStartTri;
+			Snap.GoalTri = MeshGoalTri;
+		}
+	}
+}
+
+void FPathFinder::AnswerPending() {
+	Snapped.SetNum(Pending.Num(), false);
+	for (int i = 0; i < Pending.Num(); i++) {
+		Snapped[i].RequestIndex = i;
+		SnapRequest(Pending[i], Snapped[i]);
+	}
+	Snapped.Sort([](const SnappedRequest& A, const SnappedRequest& B) {
+		return A.MeshIndex != B.MeshIndex ? A.MeshIndex < B.MeshIndex : A.GoalTri < B.GoalTri;
+	});
+
+	for (int GroupStart = 0; GroupStart < Snapped.Num(); ) {
+		const SnappedRequest& First = Snapped[GroupStart];
+		int GroupEnd = GroupStart + 1;
+		while (
+			GroupEnd < Snapped.Num()
+			&& Snapped[GroupEnd].MeshIndex == First.MeshIndex
+			&& Snapped[GroupEnd].GoalTri == First.GoalTri
+		) {
+			GroupEnd++;
+		}
+		// one search from the shared goal covers every start; alone, A* toward the goal is cheaper
+		const bool UseFlowField = First.MeshIndex >= 0 && GroupEnd - GroupStart > 1;
+		if (UseFlowField) {
+			GroupStartTris.Reset();
+			for (int i = GroupStart; i < GroupEnd; i++) {
+				GroupStartTris.Add(Snapped[i].StartTri);
+			}
+			NavProcessor::BuildFlowField(
+				NMeshes[First.MeshIndex], First.GoalTri, Pending[First.RequestIndex].Goal, GroupStartTris, Space
+			);
+		}
+
+		for (int i = GroupStart; i < GroupEnd; i++) {
+			const SnappedRequest& Request = Snapped[i];
+			const PathRequest& Pended = Pending[Request.RequestIndex];
+			PathResult* Result = GetResultSlot();
+			if (Result == nullptr) {
+				return;
+			}
+			Result->RequestId = Pended.RequestId;
+			Result->MeshIndex = Request.MeshIndex;
+			Result->Corridor.Reset();
+			Result->Points.Reset();
+			if (Request.MeshIndex < 0) {
+				Result->Success = false;
+			}
+			else if (UseFlowField) {
+				Result->Success = NavProcessor::GetFlowPath(
+					Request.StartTri, Pended.Start, Pended.Goal, Space, Result->Corridor, Result->Points
+				);
+			}
+			else {
+				// long paths go through the mesh's cluster hierarchy, which falls back to plain A* for short ones
+				Result->Success = NMeshes[Request.MeshIndex].Hierarchy.FindPath(
+					NMeshes[Request.MeshIndex],
+					Request.StartTri,
+					Pended.Start,
+					Request.GoalTri,
+					Pended.Goal,
+					Space,
+					HierarchySpace,
+					Result->Corridor,
+					Result->Points
+				);
+			}
+			if (Result->Success) {
+				NavProcessor::StraightenPath(
+					NMeshes[Request.MeshIndex], Result->Corridor, Pended.Start, Pended.Goal, Space, Result->Points
+				);
+			}
+			Results.Publish();
+		}
+		GroupStart = GroupEnd;
+	}
+}
+
+PathResult* FPathFinder::GetResultSlot() {
+	// the reader is behind; waiting rather than dropping results agents are counting on
+	PathResult* Slot = Results.GetWriteSlot();
+	while (Slot == nullptr && IsThreadRun) {
+		FPlatformProcess::Sleep(0.001f);
+		Slot = Results.GetWriteSlot();
+	}
+	return Slot;
+}
@@ -1,24 +1,129 @@
 ﻿#pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Containers/Queue.h"
+#include "NavProcessor.h"
+#include "NavHierarchy.h"
 
+struct UNavMesh;
+
+struct PathQuery {
+	FVector Start;
+	FVector Goal;
+};
+
+struct PathRequest {
+	uint32 RequestId;
+	FVector Start;
+	FVector Goal;
+};
+
+struct PathResult {
+	uint32 RequestId;
+	bool Success;
+	int MeshIndex; // in the navmeshes searched; -1 if no mesh had both ends on it
+	TArray<uint32> Corridor; // tris crossed, start to goal
+	TArray<FVector> Points; // start, the corners and folds the straightened path bends at, goal
+};
+
+// Fixed-size single producer, single consumer queue of results, read in place without locks. Slots are reused, so
+// once their arrays have grown to fit, passing results through doesn't allocate
+class PathResultRing {
+
+public:
+
+	PathResultRing();
+
+	// producer: the slot to fill next, or nullptr if the ring is full. Filling it isn't seen until Publish()
+	PathResult* GetWriteSlot();
+
+	void Publish();
+
+	// consumer: the oldest unread result, or nullptr if there are none. Stays valid until Release()
+	const PathResult* Peek() const;
+
+	void Release();
+
+private:
+
+	static constexpr int CAPACITY = 1024; // power of 2
+
+	TArray<PathResult> Slots;
+	// totals ever published and released; each side only writes its own
+	FThreadSafeCounter WriteCt;
+	FThreadSafeCounter ReadCt;
+
+};
+
+// Answers path requests on its own thread. Any number of agents queue requests from any thread; results come back in
+// the order finished, carrying the id RequestPath() handed out. Everything queued by the time the thread wakes is
+// answered together, and requests headed for the same goal tri share one flow field search instead of running A*
+// each; lone requests crossing clusters go through the mesh's NavHierarchy. The navmeshes are read, never copied, so
+// they must outlive the thread and stay unchanged while it runs
 class UNAV3D_API FPathFinder : public FRunnable {
 
 public:
 
-	FPathFinder();
+	FPathFinder(const TArray<UNavMesh>& _NMeshes);
 	virtual ~FPathFinder() override;
-	
+
 	bool StartThread();
 	void StopThread();
-	
+
 	virtual bool Init() override;
 	virtual uint32 Run() override;
 	virtual void Stop() override;
 
+	// queues a path from Start to Goal; returns the id its result will carry. Safe from any thread
+	uint32 RequestPath(const FVector& Start, const FVector& Goal);
+
+	// queues a path per query; returns the id of the first, and the rest follow in order. Safe from any thread
+	uint32 RequestPaths(const TArray<PathQuery>& Queries);
+
+	// the next finished result, if any, read in place until PopResult(). Only one thread should take results
+	const PathResult* PeekResult() const;
+
+	void PopResult();
+
 private:
 
+	// how far off a navmesh's surface the ends of a path can be
+	static constexpr float SNAP_DIST = 100.0f;
+	// most requests answered per wake; the rest wait for the next
+	static constexpr int MAX_BATCH_SZ = 1024;
+
+	// a pending request, resolved to the tris its ends snap to
+	struct SnappedRequest {
+		int RequestIndex; // in Pending
+		int MeshIndex; // -1 if no mesh had both ends on it
+		uint32 StartTri;
+		uint32 GoalTri;
+	};
+
+	void SnapRequest(const PathRequest& Request, SnappedRequest& Snap);
+
+	// answers everything in Pending, grouping requests by goal tri
+	void AnswerPending();
+
+	// waits for a free result slot; nullptr if the thread is stopped meanwhile
+	PathResult* GetResultSlot();
+
+	const TArray<UNavMesh>& NMeshes;
+	TQueue<PathRequest, EQueueMode::Mpsc> Requests;
+	PathResultRing Results;
+	FEvent* RequestEvent; // triggered on every request, so the thread only wakes when there's work
+	FThreadSafeCounter NextRequestId;
+	// only touched on the thread, and kept between batches so they don't allocate
+	NavProcessor::SearchSpace Space;
+	NavHierarchy::QuerySpace HierarchySpace;
+	TArray<PathRequest> Pending;
+	TArray<SnappedRequest> Snapped;
+	TArray<uint32> GroupStartTris;
 	TUniquePtr<FRunnableThread> Thread;
-	bool IsThreadRun;
+	FThreadSafeBool IsThreadRun;
 
 };
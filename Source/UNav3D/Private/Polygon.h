@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include "Tri.h"
+#include "ScratchArena.h"
 
 struct PolyNode {
 	PolyNode(const FVector& _Location) :
@@ -35,7 +36,7 @@ struct Polygon {
 		Normal(_Normal)
 	{}
 
-	TArray<PolyNode> Vertices;
+	TScratchArray<PolyNode> Vertices;
 	int TriIndex;
 	enum POLYGON_MODE {SUBTRACT, ADD} Mode;
 	FVector& Normal;
@@ -128,7 +129,7 @@ struct PolyEdge {
 	const FVector A;
 	const FVector B;
 	uint32 Flags; // only using 2 of the 4 bytes
-	TArray<FVector> ObscuredLocations; // locations from A (toward B) marking where this edge passes in and out of other meshes
+	TScratchArray<FVector> ObscuredLocations; // locations from A (toward B) marking where this edge passes in and out of other meshes
 };
 
 struct VBufferPolyEdge {
@@ -151,12 +152,12 @@ struct UPolyNode {
 		Location(_Location)
 	{}
 	const FVector Location;
-	TArray<int> Edges;
+	TScratchArray<int> Edges;
 };
 
 // a collection of tri-on-tri intersections, per tri
 struct UnstructuredPolygon {
-	TArray<PolyEdge> Edges;
+	TScratchArray<PolyEdge> Edges;
 	int TriIndex;
 };
 
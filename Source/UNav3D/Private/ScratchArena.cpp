@@ -0,0 +1,133 @@
+﻿#include "ScratchArena.h"
+
+thread_local ScratchArena* ScratchArena::Current = nullptr;
+
+ScratchArena::ScratchArena() :
+	First(nullptr),
+	Cur(nullptr)
+{}
+
+ScratchArena::~ScratchArena() {
+	Block* B = First;
+	while (B != nullptr) {
+		Block* Next = B->Next;
+		free(B);
+		B = Next;
+	}
+}
+
+void* ScratchArena::Alloc(SIZE_T Sz, uint32 Alignment) {
+	AllocCt.Increment();
+	while (true) {
+		Block* B = Cur;
+		if (B != nullptr) {
+			// claiming [Start, Start + Sz) by bumping Used, unless another thread got there first
+			int64 Used = B->Used;
+			while (true) {
+				const int64 Start = Align((int64)(GetData(B) + Used), (int64)Alignment) - (int64)GetData(B);
+				if (Start + (int64)Sz > B->Sz) {
+					break;
+				}
+				const int64 Prev = FPlatformAtomics::InterlockedCompareExchange(&B->Used, Start + (int64)Sz, Used);
+				if (Prev == Used) {
+					return GetData(B) + Start;
+				}
+				Used = Prev;
+			}
+		}
+		if (!NextBlock(B, Sz, Alignment)) {
+			FailedAllocCt.Increment();
+			return nullptr;
+		}
+	}
+}
+
+bool ScratchArena::TryGrow(void* Ptr, SIZE_T OldSz, SIZE_T NewSz) {
+	Block* B = Cur;
+	if (B == nullptr) {
+		return false;
+	}
+	const int64 End = (uint8*)Ptr + OldSz - GetData(B);
+	const int64 NewEnd = End + (int64)(NewSz - OldSz);
+	if (End <= 0 || End > B->Sz || NewEnd > B->Sz) {
+		return false;
+	}
+	// only if nothing has been allocated after it
+	return FPlatformAtomics::InterlockedCompareExchange(&B->Used, NewEnd, End) == End;
+}
+
+bool ScratchArena::NextBlock(Block* Full, SIZE_T Sz, uint32 Alignment) {
+	FScopeLock Lock(&Mutex);
+	if (Cur != Full) {
+		// another thread moved on already
+		return true;
+	}
+	const int64 NeededSz = (int64)(Sz + Alignment);
+	Block* Next = Full != nullptr ? Full->Next : First;
+	if (Next == nullptr || Next->Sz < NeededSz) {
+		// anything too big for a whole block gets a block to itself, put in ahead of the spares
+		const int64 NewSz = FMath::Max(BLOCK_SZ, NeededSz);
+		Block* New = (Block*)malloc(BLOCK_HEADER_SZ + NewSz);
+		if (New == nullptr) {
+			return false;
+		}
+		New->Sz = NewSz;
+		New->Next = Next;
+		if (Full != nullptr) {
+			Full->Next = New;
+		}
+		else {
+			First = New;
+		}
+		Next = New;
+	}
+	Next->Used = 0;
+	// the block has to be ready before other threads can see it
+	FPlatformMisc::MemoryBarrier();
+	Cur = Next;
+	return true;
+}
+
+void ScratchArena::Reset() {
+	// keeping blocks in order until they'd add up past MAX_KEPT_BYTES; the rest are freed
+	int64 KeptSz = 0;
+	Block** Link = &First;
+	while (*Link != nullptr) {
+		Block* B = *Link;
+		if (KeptSz + B->Sz <= MAX_KEPT_BYTES) {
+			KeptSz += B->Sz;
+			Link = &B->Next;
+			continue;
+		}
+		*Link = B->Next;
+		free(B);
+	}
+	if (First != nullptr) {
+		First->Used = 0;
+	}
+	Cur = First;
+	AllocCt.Reset();
+	FailedAllocCt.Reset();
+}
+
+SIZE_T ScratchArena::GetUsedBytes() const {
+	SIZE_T Sz = 0;
+	if (Cur == nullptr) {
+		return Sz;
+	}
+	for (Block* B = First; ; B = B->Next) {
+		Sz += B->Used;
+		if (B == Cur) {
+			break;
+		}
+	}
+	return Sz;
+}
+
+SIZE_T ScratchArena::GetBlockBytes() const {
+	SIZE_T Sz = 0;
+	for (Block* B = First; B != nullptr; B = B->Next) {
+		Sz += B->Sz;
+	}
+	return Sz;
+}
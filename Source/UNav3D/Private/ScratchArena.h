@@ -0,0 +1,231 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+
+// Linear allocator for scratch data that's all thrown away at once. Allocating bumps an offset into a malloc'd block,
+// freeing does nothing, and Reset() takes everything back while keeping up to MAX_KEPT_BYTES of blocks for next time. Allocating is
+// thread safe, so tasks spread over the task graph can share one arena. Arrays of TScratchArray type allocate from
+// whichever arena is current on the thread that creates them (see Scope), or from the heap if there is none
+class ScratchArena {
+
+public:
+
+	ScratchArena();
+	~ScratchArena();
+
+	// Alignment must be a power of 2; nullptr if a new block couldn't be malloc'd, which is counted in
+	// GetFailedAllocCt()
+	void* Alloc(SIZE_T Sz, uint32 Alignment);
+
+	// grows the allocation at Ptr from OldSz to NewSz bytes where it is, if it's the last one made and there's room
+	bool TryGrow(void* Ptr, SIZE_T OldSz, SIZE_T NewSz);
+
+	// everything allocated is gone; nothing may be allocating meanwhile. Blocks past the first MAX_KEPT_BYTES are freed,
+	// so one unusually large use doesn't hold on to its peak for as long as the arena lives
+	void Reset();
+
+	// allocations made since the last reset
+	int GetAllocCt() const {
+		return AllocCt.GetValue();
+	}
+
+	// allocations since the last reset that failed for want of a block; TScratchArrays move to the heap on these
+	int GetFailedAllocCt() const {
+		return FailedAllocCt.GetValue();
+	}
+
+	// bytes handed out since the last reset, alignment padding included. Nothing is freed before a reset, so this is
+	// also the most the arena has held
+	SIZE_T GetUsedBytes() const;
+
+	// bytes of blocks malloc'd, which are kept through resets up to MAX_KEPT_BYTES
+	SIZE_T GetBlockBytes() const;
+
+	static constexpr int64 MAX_KEPT_BYTES = 8 << 20;
+
+	static ScratchArena* GetCurrent() {
+		return Current;
+	}
+
+	// makes an arena (or the heap, if nullptr) current on this thread for as long as it's in scope
+	class Scope {
+
+	public:
+
+		explicit Scope(ScratchArena* Arena) :
+			Prev(Current)
+		{
+			Current = Arena;
+		}
+
+		~Scope() {
+			Current = Prev;
+		}
+
+	private:
+
+		ScratchArena* Prev;
+
+	};
+
+private:
+
+	struct Block {
+		Block* Next;
+		int64 Sz;
+		volatile int64 Used;
+		// data follows, 16 byte aligned
+	};
+
+	static constexpr int64 BLOCK_SZ = 1 << 20;
+	static constexpr int64 BLOCK_HEADER_SZ = (sizeof(Block) + 15) & ~(int64)15;
+
+	static uint8* GetData(Block* B) {
+		return (uint8*)B + BLOCK_HEADER_SZ;
+	}
+
+	// moves on from Full to a block with room for Sz bytes at Alignment, reusing ones kept from before a reset if
+	// possible; false if a new block was needed and couldn't be malloc'd
+	bool NextBlock(Block* Full, SIZE_T Sz, uint32 Alignment);
+
+	Block* First;
+	Block* volatile Cur; // blocks before it are full; blocks after it are spares
+	FCriticalSection Mutex; // held while changing blocks
+	FThreadSafeCounter AllocCt;
+	FThreadSafeCounter FailedAllocCt;
+
+	static thread_local ScratchArena* Current;
+
+};
+
+// TArray allocation policy taking memory from the arena current when the array was made. Arrays made with no arena
+// current use the heap, so these types are safe anywhere; only ones made inside a Scope must not outlive its arena's
+// next reset
+class FScratchAllocator {
+
+public:
+
+	using SizeType = int32;
+
+	enum { NeedsElementType = true };
+	enum { RequireRangeCheck = true };
+
+	template <typename ElementType>
+	class ForElementType {
+
+	public:
+
+		ForElementType() :
+			Data(nullptr),
+			Arena(ScratchArena::GetCurrent()),
+			Allocated(0)
+		{}
+
+		~ForElementType() {
+			if (Arena == nullptr && Data != nullptr) {
+				FMemory::Free(Data);
+			}
+		}
+
+		void MoveToEmpty(ForElementType& Other) {
+			if (Arena == nullptr && Data != nullptr) {
+				FMemory::Free(Data);
+			}
+			Data = Other.Data;
+			Arena = Other.Arena;
+			Allocated = Other.Allocated;
+			Other.Data = nullptr;
+			Other.Allocated = 0;
+		}
+
+		ElementType* GetAllocation() const {
+			return Data;
+		}
+
+		void ResizeAllocation(SizeType PreviousNumElements, SizeType NumElements, SIZE_T NumBytesPerElement) {
+			if (Arena == nullptr) {
+				if (Data != nullptr || NumElements > 0) {
+					Data = (ElementType*)FMemory::Realloc(
+						Data, NumElements * NumBytesPerElement, alignof(ElementType)
+					);
+				}
+				return;
+			}
+			// arena memory only ever grows; shrinking keeps what's there
+			if (NumElements <= Allocated) {
+				return;
+			}
+			const SIZE_T OldSz = Allocated * NumBytesPerElement;
+			const SIZE_T NewSz = NumElements * NumBytesPerElement;
+			if (Data == nullptr || !Arena->TryGrow(Data, OldSz, NewSz)) {
+				ElementType* OldData = Data;
+				Data = (ElementType*)Arena->Alloc(NewSz, alignof(ElementType));
+				if (Data == nullptr) {
+					// the arena couldn't get a block (counted in its stats); the array lives on the heap from here on,
+					// and the old data stays in the arena until its reset
+					Data = (ElementType*)FMemory::Malloc(NewSz, alignof(ElementType));
+					check(Data != nullptr);
+					Arena = nullptr;
+				}
+				if (OldData != nullptr && PreviousNumElements > 0) {
+					FMemory::Memcpy(Data, OldData, FMath::Min(PreviousNumElements, NumElements) * NumBytesPerElement);
+				}
+			}
+			Allocated = NumElements;
+		}
+
+		SizeType CalculateSlackReserve(SizeType NumElements, SIZE_T NumBytesPerElement) const {
+			return DefaultCalculateSlackReserve(NumElements, NumBytesPerElement, false, alignof(ElementType));
+		}
+
+		SizeType CalculateSlackShrink(
+			SizeType NumElements, SizeType NumAllocatedElements, SIZE_T NumBytesPerElement
+		) const {
+			return DefaultCalculateSlackShrink(
+				NumElements, NumAllocatedElements, NumBytesPerElement, false, alignof(ElementType)
+			);
+		}
+
+		SizeType CalculateSlackGrow(
+			SizeType NumElements, SizeType NumAllocatedElements, SIZE_T NumBytesPerElement
+		) const {
+			return DefaultCalculateSlackGrow(
+				NumElements, NumAllocatedElements, NumBytesPerElement, false, alignof(ElementType)
+			);
+		}
+
+		SIZE_T GetAllocatedSize(SizeType NumAllocatedElements, SIZE_T NumBytesPerElement) const {
+			return NumAllocatedElements * NumBytesPerElement;
+		}
+
+		bool HasAllocation() const {
+			return Data != nullptr;
+		}
+
+		SizeType GetInitialCapacity() const {
+			return 0;
+		}
+
+	private:
+
+		ForElementType(const ForElementType&);
+		ForElementType& operator = (const ForElementType&);
+
+		ElementType* Data;
+		ScratchArena* Arena;
+		SizeType Allocated; // elements Data has room for; only tracked for arena memory
+
+	};
+
+	typedef void ForAnyElementType;
+
+};
+
+template <>
+struct TAllocatorTraits<FScratchAllocator> : TAllocatorTraitsBase<FScratchAllocator> {
+	enum { SupportsMove = true };
+};
+
+template <typename T>
+using TScratchArray = TArray<T, FScratchAllocator>;
@@ -6,7 +6,6 @@ namespace {
 	constexpr int NEIGHBOR_1_SHIFT = 13;
 	constexpr int NEIGHBOR_2_SHIFT = 16;
 	constexpr float ONE_THIRD = 1.0f / 3.0f;
-	FVector ZeroVec (0.0f, 0.0f, 0.0f);
 	
 	enum TRI_FLAGS {
 		// whether the vertices are inside other meshes
@@ -26,7 +25,7 @@ namespace {
 		TRI_INSIDE_BV =		TRI_A_INSIDE_BV | TRI_B_INSIDE_BV | TRI_C_INSIDE_BV,
 		// cleared before flags above used
 		TRI_SEARCHED =		0x00000001,
-		// neighbors, which side? only valid directly after the batching phase; otherwise, neighbors are always AB,BC,CA
+		// neighbors, which side? kept in TriGrid's neighbor flags rather than Tri::Flags, since neighbors outlive batching
 		TRI_AB =			0x00000001,
 		TRI_BC =			0x00000002,
 		TRI_CA =			0x00000004,
@@ -49,53 +48,13 @@ FVector TempTri::GetCenter() const {
 }
 
 Tri::Tri() :
-	A(ZeroVec), B(ZeroVec), C(ZeroVec),
-	Normal(FVector::OneVector),
-	Flags(0x0),
-	Area(0.0f),
-	LongestSidelenSq(0.0f)
-{
-	Neighbors.Reserve(3);	
-}
-
-Tri::Tri(FVector& _A, FVector& _B, FVector& _C) :
-	A(_A), B(_B), C(_C),
-	Normal(FVector::CrossProduct(_A - _C, _A - _B).GetUnsafeNormal()),
-	Flags(0x0),
-	Area(GetArea(_A, _B, _C)),
-	LongestSidelenSq(GetLongestTriSidelenSq(_A, _B, _C))
-{
-	Neighbors.Reserve(3);	
-}
-
-float Tri::GetLongestTriSidelenSq(const FVector& A, const FVector& B, const FVector& C) {
-	const float AB = (A - B).SizeSquared();
-	const float BC = (B - C).SizeSquared();
-	const float CA = (C - A).SizeSquared();
-	if (AB > BC) {
-		if (AB > CA) {
-			return AB;
-		}
-		return CA;
-	}
-	if (BC > CA) {
-		return BC;
-	}
-	return CA;
-}
+	Flags(0x0)
+{}
 
 float Tri::GetArea(const FVector& A, const FVector& B, const FVector& C) {
 	return FVector::CrossProduct(A - B, A - C).Size() * 0.5f;
 }
 
-float Tri::GetArea(const Tri& T) {
-	return FVector::CrossProduct(T.A - T.B, T.A - T.C).Size() * 0.5f;
-}
-
-FVector Tri::GetCenter() const {
-	return (A + B + C) * ONE_THIRD;
-}
-
 void Tri::AddNeighborFlag(uint32& ExtFlags, int V0, int V1, int SideNo) {
 	uint32 SideFlag;
 	switch(V0) {
@@ -145,58 +104,6 @@ void Tri::AddNeighborFlag(uint32& ExtFlags, int V0, int V1, int SideNo) {
 	ExtFlags |= SideFlag << (10 + 3 * SideNo);
 }
 
-void Tri::AddFlags(uint32 _Flags) {
-	Flags |= _Flags;
-}
-
-void Tri::OrganizeNeighbors() {
-	while (Neighbors.Num() < 3) {
-		Neighbors.Add(nullptr);	
-	}
-	Tri* ABTri = nullptr;
-	Tri* BCTri = nullptr;
-	Tri* CATri = nullptr;
-	const uint32 Neighbor0 = Flags & TRI_NEIGHBOR_0;
-	const uint32 Neighbor1 = Flags & TRI_NEIGHBOR_1;
-	const uint32 Neighbor2 = Flags & TRI_NEIGHBOR_2;
-	if (Neighbor0) {
-		if (Neighbor0 == TRI_AB << NEIGHBOR_0_SHIFT) {
-			ABTri = Neighbors[0];
-		}
-		else if (Neighbor0 == TRI_BC << NEIGHBOR_0_SHIFT) {
-			BCTri = Neighbors[0];
-		}
-		else {
-			CATri = Neighbors[0];
-		}
-		if (Neighbor1) {
-			if (Neighbor1 == TRI_AB << NEIGHBOR_1_SHIFT) {
-				ABTri = Neighbors[1];
-			}
-			else if (Neighbor1 == TRI_BC << NEIGHBOR_1_SHIFT) {
-				BCTri = Neighbors[1];
-			}
-			else {
-				CATri = Neighbors[1];
-			}
-			if (Neighbor2) {
-				if (Neighbor2 == TRI_AB << NEIGHBOR_2_SHIFT) {
-					ABTri = Neighbors[2];
-				}
-				else if (Neighbor2 == TRI_BC << NEIGHBOR_2_SHIFT) {
-					BCTri = Neighbors[2];
-				}
-				else {
-					CATri = Neighbors[2];
-				}
-			}
-		}
-	}
-	Neighbors[0] = ABTri;
-	Neighbors[1] = BCTri;
-	Neighbors[2] = CATri;
-}
-
 void Tri::ClearFlags() {
 	Flags = 0x0;
 }
@@ -341,10 +248,6 @@ bool Tri::IsSearched() const {
 	return Flags & TRI_SEARCHED;	
 }
 
-void Tri::CalculateNormal(FVector& _Normal) const {
-	_Normal = FVector::CrossProduct(A - C, A - B).GetUnsafeNormal();
-}
-
 FVector Tri::CalculateNormal(const FVector& _A, const FVector& _B, const FVector& _C) {
 	return FVector::CrossProduct(_A - _C, _A - _B).GetUnsafeNormal();
 }
@@ -15,38 +15,19 @@ struct TempTri {
 	FVector* Normal;
 };
 
-// Triangle; saves space by storing references to vertices on the TriMesh.
-// Edges must be re-pointed if Tri's container reallocates
+// Processing flags of one tri in a TriGrid. Everything else about the tri (vertex indices, normal, neighbors) is kept
+// in structure-of-arrays form by the grid, found by the tri's index there; see TriGrid::GetIndex() and TriGrid::GetA()
 struct Tri {
 
 	Tri();
 	
-	Tri(FVector& _A, FVector& _B, FVector& _C);
-	
-	// meant for use in constructor
-	static float GetLongestTriSidelenSq(const FVector& A, const FVector& B, const FVector& C);
-
 	// get the area of a triangle with vertices A, B, C
 	static float GetArea(const FVector& A, const FVector& B, const FVector& C);
 
-	// get the area of tri T
-	static float GetArea(const Tri& T);
-
-	FVector GetCenter() const;
-
-	// because side-to-side connection between tris is disconnected from neighbor adding, it's helpful to have
-	// a builder that populates connection flags before assigning to the tri. V0,V1 are in 0,1,2, translating to A,B,C
-	// and SideNo is in 0,1,2 for order of adding
+	// builds the flag marking which side of a tri a neighbor is on. V0,V1 are in 0,1,2, translating to A,B,C
+	// and SideNo is in 0,1,2 for the neighbor slot
 	static inline void AddNeighborFlag(uint32& Flags, int V0, int V1, int SideNo);
 
-	// As of 11/11/2022, only used for adding built neighbor flags
-	inline void AddFlags(uint32 Flags);
-
-	// neighbors may not be added in order AB, BC, CA; this organizes them so they are, and so every tri always
-	// has 3 neighbors, where nonexistent neighbor <- nullptr; neighbors should only be nonexistent when a mesh
-	// is not continuous along the surface, which may be true during some stages of reformation
-	inline void OrganizeNeighbors();
-
 	inline void ClearFlags();
 
 	static inline void ShiftBatchFlags();
@@ -133,8 +114,6 @@ struct Tri {
 
 	bool IsSearched() const;
 	
-	void CalculateNormal(FVector& Normal) const;
-
 	static FVector CalculateNormal(const FVector &A, const FVector& B, const FVector& C);
 
 	static constexpr int MAX_BATCH_CT = 4095; // per mesh
@@ -142,14 +121,6 @@ struct Tri {
 	
 	enum {AB=0, BC=1, CA=2};
 	
-	FVector& A;
-	FVector& B;
-	FVector& C;
-	FVector Normal;
 	uint32 Flags;
-	TArray<Tri*> Neighbors;
-	// -- for faster intersection checking --
-	float Area; 
-	float LongestSidelenSq;
 	
 };
\ No newline at end of file
@@ -0,0 +1,350 @@
+﻿#include "TriBVH.h"
+#include "TriGrid.h"
+#include "Geometry.h"
+
+namespace {
+
+	struct BuildTask {
+		uint32 NodeIndex;
+		uint32 First;
+		uint32 Count;
+		uint32 Depth;
+	};
+
+	struct BuildBin {
+		FVector Min;
+		FVector Max;
+		uint32 Count;
+	};
+
+	inline void GrowBounds(FVector& Min, FVector& Max, const FVector& OtherMin, const FVector& OtherMax) {
+		Min = Min.ComponentMin(OtherMin);
+		Max = Max.ComponentMax(OtherMax);
+	}
+
+	inline float HalfSurfaceArea(const FVector& Min, const FVector& Max) {
+		const FVector D = Max - Min;
+		return D.X * D.Y + D.Y * D.Z + D.Z * D.X;
+	}
+
+	inline bool DoBoxesOverlap(const FVector& MinA, const FVector& MaxA, const FVector& MinB, const FVector& MaxB) {
+		return (
+			MinA.X <= MaxB.X && MaxA.X >= MinB.X
+			&& MinA.Y <= MaxB.Y && MaxA.Y >= MinB.Y
+			&& MinA.Z <= MaxB.Z && MaxA.Z >= MinB.Z
+		);
+	}
+
+	// squared distance from Point to the nearest point of box Min-Max; 0 if it's inside
+	inline float GetBoxSqDist(const FVector& Point, const FVector& Min, const FVector& Max) {
+		const FVector Out = (Min - Point).ComponentMax(Point - Max).ComponentMax(FVector::ZeroVector);
+		return Out.SizeSquared();
+	}
+
+	// slab test against the segment Origin + t * Dir, t in [0, 1]
+	inline bool DoesSegmentHitBox(
+		const FVector& Origin, const FVector& InvDir, const FVector& Min, const FVector& Max
+	) {
+		float TMin = 0.0f;
+		float TMax = 1.0f;
+		for (int Axis = 0; Axis < 3; Axis++) {
+			float T0 = (Min[Axis] - Origin[Axis]) * InvDir[Axis];
+			float T1 = (Max[Axis] - Origin[Axis]) * InvDir[Axis];
+			if (T0 > T1) {
+				Swap(T0, T1);
+			}
+			// written so a NaN from 0 * inf leaves the interval unchanged
+			TMin = T0 > TMin ? T0 : TMin;
+			TMax = T1 < TMax ? T1 : TMax;
+			if (TMin > TMax) {
+				return false;
+			}
+		}
+		return true;
+	}
+	
+}
+
+TriBVH::TriBVH() :
+	Container(nullptr), Nodes(nullptr), TriIndices(nullptr), NodeCt(0), TriCt(0)
+{}
+
+bool TriBVH::Build(const TriGrid& Grid) {
+	Reset();
+	TriCt = Grid.Num();
+	if (TriCt == 0) {
+		return true;
+	}
+
+	// a binary tree with at least one tri per leaf has fewer than 2 * TriCt nodes
+	const int MaxNodeCt = 2 * TriCt - 1;
+	Container = malloc(MaxNodeCt * sizeof(TriBVHNode) + TriCt * sizeof(uint32));
+	if (Container == nullptr) {
+		printf("TEMP ERROR TriBVH::Build() alloc fail\n");
+		TriCt = 0;
+		return false;
+	}
+	Nodes = (TriBVHNode*)Container;
+	TriIndices = (uint32*)(Nodes + MaxNodeCt);
+
+	TArray<FVector> TriMins;
+	TArray<FVector> TriMaxes;
+	TArray<FVector> Centroids;
+	TriMins.SetNumUninitialized(TriCt);
+	TriMaxes.SetNumUninitialized(TriCt);
+	Centroids.SetNumUninitialized(TriCt);
+	for (int i = 0; i < TriCt; i++) {
+		Grid.GetBounds(i, TriMins[i], TriMaxes[i]);
+		Centroids[i] = (TriMins[i] + TriMaxes[i]) * 0.5f;
+		TriIndices[i] = i;
+	}
+
+	NodeCt = 1;
+	TArray<BuildTask> Tasks;
+	Tasks.Add({0, 0, (uint32)TriCt, 0});
+	while (Tasks.Num() > 0) {
+		const BuildTask Task = Tasks.Pop(false);
+		TriBVHNode& Node = Nodes[Task.NodeIndex];
+		
+		Node.Min = TriMins[TriIndices[Task.First]];
+		Node.Max = TriMaxes[TriIndices[Task.First]];
+		FVector CentroidMin = Centroids[TriIndices[Task.First]];
+		FVector CentroidMax = CentroidMin;
+		for (uint32 i = Task.First + 1; i < Task.First + Task.Count; i++) {
+			const uint32 TIndex = TriIndices[i];
+			GrowBounds(Node.Min, Node.Max, TriMins[TIndex], TriMaxes[TIndex]);
+			GrowBounds(CentroidMin, CentroidMax, Centroids[TIndex], Centroids[TIndex]);
+		}
+		Node.LeftOrFirst = Task.First;
+		Node.Count = Task.Count;
+		if (Task.Count <= MAX_LEAF_TRI_CT || Task.Depth >= MAX_DEPTH - 1) {
+			continue;
+		}
+
+		// binning centroids along each axis and taking the split with the lowest surface area heuristic cost
+		const float LeafCost = (float)Task.Count;
+		float BestCost = LeafCost * HalfSurfaceArea(Node.Min, Node.Max);
+		int BestAxis = -1;
+		int BestSplit = 0;
+		for (int Axis = 0; Axis < 3; Axis++) {
+			const float AxisMin = CentroidMin[Axis];
+			const float AxisExtent = CentroidMax[Axis] - AxisMin;
+			if (AxisExtent <= KINDA_SMALL_NUMBER) {
+				continue;
+			}
+			const float BinFactor = BIN_CT / AxisExtent;
+			BuildBin Bins[BIN_CT];
+			for (int b = 0; b < BIN_CT; b++) {
+				Bins[b].Min = FVector(MAX_flt);
+				Bins[b].Max = FVector(-MAX_flt);
+				Bins[b].Count = 0;
+			}
+			for (uint32 i = Task.First; i < Task.First + Task.Count; i++) {
+				const uint32 TIndex = TriIndices[i];
+				const int b = FMath::Min(BIN_CT - 1, (int)((Centroids[TIndex][Axis] - AxisMin) * BinFactor));
+				GrowBounds(Bins[b].Min, Bins[b].Max, TriMins[TIndex], TriMaxes[TIndex]);
+				Bins[b].Count++;
+			}
+			// sweeping from the right to get the cost of every right-hand side, then from the left to finish
+			float RightAreas[BIN_CT - 1];
+			uint32 RightCounts[BIN_CT - 1];
+			FVector SweepMin(MAX_flt);
+			FVector SweepMax(-MAX_flt);
+			uint32 SweepCt = 0;
+			for (int b = BIN_CT - 1; b > 0; b--) {
+				GrowBounds(SweepMin, SweepMax, Bins[b].Min, Bins[b].Max);
+				SweepCt += Bins[b].Count;
+				RightAreas[b - 1] = SweepCt > 0 ? HalfSurfaceArea(SweepMin, SweepMax) : 0.0f;
+				RightCounts[b - 1] = SweepCt;
+			}
+			SweepMin = FVector(MAX_flt);
+			SweepMax = FVector(-MAX_flt);
+			SweepCt = 0;
+			for (int b = 0; b < BIN_CT - 1; b++) {
+				GrowBounds(SweepMin, SweepMax, Bins[b].Min, Bins[b].Max);
+				SweepCt += Bins[b].Count;
+				if (SweepCt == 0 || RightCounts[b] == 0) {
+					continue;
+				}
+				const float Cost = SweepCt * HalfSurfaceArea(SweepMin, SweepMax) + RightCounts[b] * RightAreas[b];
+				if (Cost < BestCost) {
+					BestCost = Cost;
+					BestAxis = Axis;
+					BestSplit = b;
+				}
+			}
+		}
+		if (BestAxis == -1) {
+			continue;
+		}
+
+		// partitioning the node's tri indices around the chosen split
+		const float AxisMin = CentroidMin[BestAxis];
+		const float BinFactor = BIN_CT / (CentroidMax[BestAxis] - AxisMin);
+		int32 Left = Task.First;
+		int32 Right = Task.First + Task.Count - 1;
+		while (Left <= Right) {
+			const int b = FMath::Min(
+				BIN_CT - 1, (int)((Centroids[TriIndices[Left]][BestAxis] - AxisMin) * BinFactor)
+			);
+			if (b <= BestSplit) {
+				Left++;
+			}
+			else {
+				Swap(TriIndices[Left], TriIndices[Right]);
+				Right--;
+			}
+		}
+		const uint32 LeftCt = Left - Task.First;
+		if (LeftCt == 0 || LeftCt == Task.Count) {
+			continue;
+		}
+		const uint32 ChildIndex = NodeCt;
+		NodeCt += 2;
+		Node.LeftOrFirst = ChildIndex;
+		Node.Count = 0;
+		Tasks.Add({ChildIndex + 1, Left, Task.Count - LeftCt, Task.Depth + 1});
+		Tasks.Add({ChildIndex, Task.First, LeftCt, Task.Depth + 1});
+	}
+	return true;
+}
+
+void TriBVH::Reset() {
+	free(Container);
+	Container = nullptr;
+	Nodes = nullptr;
+	TriIndices = nullptr;
+	NodeCt = 0;
+	TriCt = 0;
+}
+
+bool TriBVH::CopyFrom(const TriBVH& Other) {
+	Reset();
+	if (Other.TriCt == 0) {
+		return true;
+	}
+	// same layout as Build(): the node array is sized for the worst case, then the tri indices
+	const int MaxNodeCt = 2 * Other.TriCt - 1;
+	const size_t ContainerSz = MaxNodeCt * sizeof(TriBVHNode) + Other.TriCt * sizeof(uint32);
+	Container = malloc(ContainerSz);
+	if (Container == nullptr) {
+		printf("TEMP ERROR TriBVH::CopyFrom() alloc fail\n");
+		return false;
+	}
+	memcpy(Container, Other.Container, ContainerSz);
+	Nodes = (TriBVHNode*)Container;
+	TriIndices = (uint32*)(Nodes + MaxNodeCt);
+	NodeCt = Other.NodeCt;
+	TriCt = Other.TriCt;
+	return true;
+}
+
+void TriBVH::QuerySegment(const FVector& A, const FVector& B, TArray<int>& OutTriIndices) const {
+	if (NodeCt == 0) {
+		return;
+	}
+	const FVector Dir = B - A;
+	const FVector InvDir(1.0f / Dir.X, 1.0f / Dir.Y, 1.0f / Dir.Z);
+	uint32 Stack[MAX_DEPTH];
+	int StackCt = 0;
+	Stack[StackCt++] = 0;
+	while (StackCt > 0) {
+		const TriBVHNode& Node = Nodes[Stack[--StackCt]];
+		if (!DoesSegmentHitBox(A, InvDir, Node.Min, Node.Max)) {
+			continue;
+		}
+		if (Node.Count > 0) {
+			for (uint32 i = Node.LeftOrFirst; i < Node.LeftOrFirst + Node.Count; i++) {
+				OutTriIndices.Add(TriIndices[i]);
+			}
+		}
+		else {
+			Stack[StackCt++] = Node.LeftOrFirst + 1;
+			Stack[StackCt++] = Node.LeftOrFirst;
+		}
+	}
+}
+
+void TriBVH::QueryBox(const FVector& Min, const FVector& Max, TArray<int>& OutTriIndices) const {
+	if (NodeCt == 0) {
+		return;
+	}
+	uint32 Stack[MAX_DEPTH];
+	int StackCt = 0;
+	Stack[StackCt++] = 0;
+	while (StackCt > 0) {
+		const TriBVHNode& Node = Nodes[Stack[--StackCt]];
+		if (!DoBoxesOverlap(Min, Max, Node.Min, Node.Max)) {
+			continue;
+		}
+		if (Node.Count > 0) {
+			for (uint32 i = Node.LeftOrFirst; i < Node.LeftOrFirst + Node.Count; i++) {
+				OutTriIndices.Add(TriIndices[i]);
+			}
+		}
+		else {
+			Stack[StackCt++] = Node.LeftOrFirst + 1;
+			Stack[StackCt++] = Node.LeftOrFirst;
+		}
+	}
+}
+
+bool TriBVH::FindClosestTri(
+	const TriGrid& Grid,
+	const FVector& Point,
+	float MaxDist,
+	uint32& OutTriIndex,
+	FVector& ClosestPoint
+) const {
+	if (NodeCt == 0) {
+		return false;
+	}
+	float BestSqDist = MaxDist * MaxDist;
+	bool Found = false;
+	FVector LeafPoints[MAX_LEAF_TRI_CT];
+	uint32 Stack[MAX_DEPTH];
+	int StackCt = 0;
+	Stack[StackCt++] = 0;
+	while (StackCt > 0) {
+		const TriBVHNode& Node = Nodes[Stack[--StackCt]];
+		// checked again on the way out, since a closer tri may have been found since it was pushed
+		if (GetBoxSqDist(Point, Node.Min, Node.Max) > BestSqDist) {
+			continue;
+		}
+		if (Node.Count > 0) {
+			Geometry::GetClosestPointsOnTris(Grid, Point, TriIndices + Node.LeftOrFirst, Node.Count, LeafPoints);
+			for (uint32 i = 0; i < Node.Count; i++) {
+				const float SqDist = FVector::DistSquared(Point, LeafPoints[i]);
+				if (SqDist <= BestSqDist) {
+					BestSqDist = SqDist;
+					OutTriIndex = TriIndices[Node.LeftOrFirst + i];
+					ClosestPoint = LeafPoints[i];
+					Found = true;
+				}
+			}
+		}
+		else {
+			// nearer child on top, so it's searched first and the farther one is more likely to be pruned
+			const uint32 Left = Node.LeftOrFirst;
+			const float LeftSqDist = GetBoxSqDist(Point, Nodes[Left].Min, Nodes[Left].Max);
+			const float RightSqDist = GetBoxSqDist(Point, Nodes[Left + 1].Min, Nodes[Left + 1].Max);
+			const uint32 Near = LeftSqDist <= RightSqDist ? Left : Left + 1;
+			const float FarSqDist = LeftSqDist <= RightSqDist ? RightSqDist : LeftSqDist;
+			if (FarSqDist <= BestSqDist) {
+				Stack[StackCt++] = Near == Left ? Left + 1 : Left;
+			}
+			if (FMath::Min(LeftSqDist, RightSqDist) <= BestSqDist) {
+				Stack[StackCt++] = Near;
+			}
+		}
+	}
+	return Found;
+}
+
+const TriBVHNode& TriBVH::GetRoot() const {
+	return Nodes[0];
+}
+
+int TriBVH::Num() const {
+	return NodeCt;
+}
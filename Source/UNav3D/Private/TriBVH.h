@@ -0,0 +1,64 @@
+﻿#pragma once
+
+class TriGrid;
+
+// Node of a TriBVH. Interior nodes have Count == 0 and their children at LeftOrFirst and LeftOrFirst + 1; leaves
+// hold Count tris, whose grid indices are TriIndices[LeftOrFirst] through TriIndices[LeftOrFirst + Count - 1]
+struct TriBVHNode {
+	FVector Min;
+	uint32 LeftOrFirst;
+	FVector Max;
+	uint32 Count;
+};
+
+// Bounding volume hierarchy over the tris of a TriGrid, built with the surface area heuristic. Nodes are kept in one
+// flat array in depth-first order, so queries walk memory mostly forward. Like TriGrid, memory is malloc'd and the
+// owning mesh's memcpy copy shares it; Reset() frees it.
+class TriBVH {
+
+public:
+
+	TriBVH();
+
+	// builds the hierarchy over every tri in the grid; the grid must already be initialized
+	bool Build(const TriGrid& Grid);
+
+	void Reset();
+
+	// deep copies Other; indices are into the grid, so the copy works for any copy of Other's grid
+	bool CopyFrom(const TriBVH& Other);
+
+	// adds the grid indices of tris whose bounds are crossed by the line segment A-B
+	void QuerySegment(const FVector& A, const FVector& B, TArray<int>& TriIndices) const;
+
+	// adds the grid indices of tris whose bounds overlap the axis-aligned box Min-Max
+	void QueryBox(const FVector& Min, const FVector& Max, TArray<int>& TriIndices) const;
+
+	// the tri closest to Point and the closest point on it, if any tri is within MaxDist. Subtrees are visited nearest
+	// first and skipped once their bounds are farther than the best tri so far, so only a few leaves are looked at
+	bool FindClosestTri(
+		const TriGrid& Grid,
+		const FVector& Point,
+		float MaxDist,
+		uint32& TriIndex,
+		FVector& ClosestPoint
+	) const;
+
+	// bounds of the whole hierarchy; only valid if Num() > 0
+	const TriBVHNode& GetRoot() const;
+
+	int Num() const;
+
+private:
+
+	static constexpr int BIN_CT = 12;
+	static constexpr int MAX_LEAF_TRI_CT = 4;
+	static constexpr int MAX_DEPTH = 64;
+
+	void* Container;
+	TriBVHNode* Nodes;
+	uint32* TriIndices;
+	int NodeCt;
+	int TriCt;
+
+};
@@ -2,9 +2,31 @@
 #include "Tri.h"
 #include "Geometry.h"
 #include "UNavMesh.h"
+#include "NavMeshFile.h"
+
+namespace {
+
+	constexpr float ONE_THIRD = 1.0f / 3.0f;
+
+	// how far a tri's bounds reach past its center, per axis
+	FVector GetTriReach(const FVector& A, const FVector& B, const FVector& C) {
+		const FVector TriCenter = (A + B + C) * ONE_THIRD;
+		return (A.ComponentMax(B).ComponentMax(C) - TriCenter).ComponentMax(
+			TriCenter - A.ComponentMin(B).ComponentMin(C)
+		);
+	}
+
+	// sorts after every cell key, so overflow tris end up after all the celled ones
+	constexpr uint32 OVERFLOW_KEY = MAX_uint32;
+
+	// tri flags are stored as plain uint32s after the rest of the store, and written to file that way
+	static_assert(sizeof(Tri) == sizeof(uint32), "Tri should hold nothing but its flags");
+
+}
 
 TriGrid::TriGrid() :
-	Container(nullptr), _Num(0), InitSuccess(false)
+	Store(nullptr), Vertices(nullptr), _Num(0), OverflowStart(0), Cells(nullptr), CellMask(0),
+	OccupiedCellCt(0), CellCounts(1, 1, 1), InitSuccess(false)
 {}
 
 void TriGrid::Init(const TriMesh& TMesh, const TArray<TempTri>& Tris) {
@@ -20,169 +42,385 @@ void TriGrid::Init(const BoundingBox& BBox, const TArray<TempTri>& Tris) {
 	Geometry::GetAxisAlignedExtrema(BBox, Minimum, Maximum);
 	FVector Dimensions = Maximum - Minimum;
 
-	// nudging the container containing the tris outward by .05% of its size
+	// nudging the container containing the tris outward by .05% of its size; the nudge is applied to each axis
+	// separately so flat meshes still get a grid with some thickness along their flat axis
 	const float DiagLen = Dimensions.Size();
-	const FVector DiagDir = Dimensions * (1.0f / DiagLen);
-	const float NudgeAmt = 0.005f * DiagLen;
-	Minimum -= DiagDir * NudgeAmt;
-	Dimensions += (2.0f * NudgeAmt) * DiagDir;
-	HalfDiagLen = 0.5f * DiagLen;
-	HalfDimensions = Dimensions * 0.5f;
-	QuarterBoxDimensions = Dimensions * (1.0f / (CONTAINER_SIDELEN * 4));
-
-	Center = Minimum + DiagDir * (0.5f * DiagLen);
-	
+	const float NudgeAmt = DiagLen > KINDA_SMALL_NUMBER ? 0.005f * DiagLen : 1.0f;
+	Minimum -= FVector(NudgeAmt);
+	Dimensions += FVector(2.0f * NudgeAmt);
+
+	const int TriCt = Tris.Num();
+	SetCellCounts(Dimensions, TriCt);
 	InvGridFactor = FVector(
-		CONTAINER_SIDELEN / Dimensions.X,
-		CONTAINER_SIDELEN / Dimensions.Y,
-		CONTAINER_SIDELEN / Dimensions.Z
+		CellCounts.X / Dimensions.X,
+		CellCounts.Y / Dimensions.Y,
+		CellCounts.Z / Dimensions.Z
 	);
 
-	TArray<TArray<TArray<TArray<const TempTri*>>>> ReorganizedTris;
-	ReorganizedTris.Init(TArray<TArray<TArray<const TempTri*>>>(), CONTAINER_SIDELEN);
-	for (int i = 0; i < CONTAINER_SIDELEN; i++) {
-		auto& TriCols = ReorganizedTris[i];
-		TriCols.Init(TArray<TArray<const TempTri*>>(), CONTAINER_SIDELEN);
-		for (int j = 0; j < CONTAINER_SIDELEN; j++) {
-			TriCols[j].Init(TArray<const TempTri*>(), CONTAINER_SIDELEN);
-		}
-	}
-
-	const int TriCt = Tris.Num();
+	// sorting tris by the key of the cell they belong to, so each cell's tris are contiguous in the container. Tris
+	// reaching more than a cell past their centers go in the overflow range at the end instead, so one large floor or
+	// wall tri doesn't grow every query by its size
+	const FVector CellSz(1.0f / InvGridFactor.X, 1.0f / InvGridFactor.Y, 1.0f / InvGridFactor.Z);
+	TArray<uint64> KeyedTris;
+	KeyedTris.SetNumUninitialized(TriCt);
+	MaxTriReach = FVector::ZeroVector;
 	for (int i = 0; i < TriCt; i++) {
-		const TempTri* T = &Tris[i];
+		const TempTri& Temp = Tris[i];
 		FIntVector GridPos;
-		const bool Success = WorldToGrid(T->GetCenter(), GridPos);
+		const bool Success = WorldToGrid(Temp.GetCenter(), GridPos);
 		if(!Success) {
 			printf("TEMP ERROR TriGrid::Init() WorldToGrid fail\n");
 			InitSuccess = false;
 			return;
 		}
-		ReorganizedTris[GridPos.X][GridPos.Y][GridPos.Z].Add(T);	
+		const FVector Reach = GetTriReach(*Temp.A, *Temp.B, *Temp.C);
+		if (Reach.X > CellSz.X || Reach.Y > CellSz.Y || Reach.Z > CellSz.Z) {
+			KeyedTris[i] = ((uint64)OVERFLOW_KEY << 32) | (uint64)i;
+			continue;
+		}
+		MaxTriReach = MaxTriReach.ComponentMax(Reach);
+		KeyedTris[i] = ((uint64)GridToKey(GridPos) << 32) | (uint64)i;
+	}
+	KeyedTris.Sort();
+
+	OccupiedCellCt = 0;
+	OverflowStart = TriCt;
+	for (int i = 0; i < TriCt; i++) {
+		if ((KeyedTris[i] >> 32) == OVERFLOW_KEY) {
+			OverflowStart = i;
+			break;
+		}
+		if (i == 0 || (KeyedTris[i] >> 32) != (KeyedTris[i - 1] >> 32)) {
+			OccupiedCellCt++;
+		}
 	}
+	// keeping the table at most half full so probe sequences stay short
+	const uint32 CellCapacity = FMath::RoundUpToPowerOfTwo(FMath::Max(OccupiedCellCt * 2, 2));
+	CellMask = CellCapacity - 1;
 	
-	Container = malloc(TriCt * sizeof(Tri));
-	if (Container == nullptr) {
-		printf("TEMP ERROR TriGrid::Init() alloc fail\n");
+	if (Vertices == nullptr) {
+		printf("TEMP ERROR TriGrid::Init() vertices not set\n");
 		InitSuccess = false;
 		return;
 	}
+	
+	Store = malloc(GetStoreSz(TriCt) + TriCt * sizeof(Tri));
+	Cells = (TriGridCell*)malloc(CellCapacity * sizeof(TriGridCell));
+	if (Store == nullptr || Cells == nullptr) {
+		printf("TEMP ERROR TriGrid::Init() alloc fail\n");
+		Reset();
+		return;
+	}
 	_Num = TriCt;
+	for (uint32 i = 0; i < CellCapacity; i++) {
+		Cells[i].Key = EMPTY_KEY;
+	}
 
-	Tri* ContainerStart = (Tri*) Container;
-	Tri* ContainerCur = ContainerStart;
-	for (int i = 0; i < CONTAINER_SIDELEN; i++) {
-		for (int j = 0; j < CONTAINER_SIDELEN; j++) {
-			for (int k = 0; k < CONTAINER_SIDELEN; k++) {
-				TArray<const TempTri*>& BoxTris = ReorganizedTris[i][j][k];
-				const int BoxTriCt = BoxTris.Num();
-				if (BoxTriCt > 0) {
-					TriBox& TBox = Boxes[i][j][k];
-					TBox.SetContainer((Tri*)Container);
-					TBox.SetNum(BoxTriCt);
-					TBox.SetStartIndex(ContainerCur - ContainerStart);
-					for (int m = 0; m < BoxTriCt; m++) {
-						auto& Temp = *BoxTris[m];
-						Tri* T = new (ContainerCur) Tri(*Temp.A, *Temp.B, *Temp.C);
-						const FVector* Normal = Temp.Normal;
-						if (Normal != nullptr) {
-							T->Normal = *Normal;
-						}
-						ContainerCur++;
-					}
-				}
+	Tri* GridTris = GetTris();
+	uint32* VIndices = (uint32*)Store;
+	FVector* Normals = (FVector*)GetNormals();
+	TriBox* TBox = nullptr;
+	for (int i = 0; i < TriCt; i++) {
+		const uint32 Key = KeyedTris[i] >> 32;
+		if (i < OverflowStart && (i == 0 || Key != (KeyedTris[i - 1] >> 32))) {
+			uint32 Slot = (Key * CELL_HASH) & CellMask;
+			while (Cells[Slot].Key != EMPTY_KEY) {
+				Slot = (Slot + 1) & CellMask;
+			}
+			TriGridCell& Cell = Cells[Slot];
+			Cell.Key = Key;
+			TBox = new (&Cell.Box) TriBox();
+			TBox->SetStartIndex(i);
+		}
+		if (i < OverflowStart) {
+			TBox->SetNum(TBox->Num() + 1);
+		}
+		const TempTri& Temp = Tris[KeyedTris[i] & MAX_uint32];
+		new (GridTris + i) Tri();
+		VIndices[3 * i] = Temp.A - Vertices;
+		VIndices[3 * i + 1] = Temp.B - Vertices;
+		VIndices[3 * i + 2] = Temp.C - Vertices;
+		Normals[i] = Temp.Normal != nullptr ? *Temp.Normal : Tri::CalculateNormal(*Temp.A, *Temp.B, *Temp.C);
+	}
+	BuildAdjacency();
+	InitSuccess = true;
+}
+
+void TriGrid::BuildAdjacency() {
+	constexpr uint64 EMPTY_EDGE = MAX_uint64;
+	constexpr uint32 LINKED_EDGE = MAX_uint32;
+	
+	const uint32* VIndices = GetVIndexBuffer();
+	uint32* Neighbors = (uint32*)Store + 3 * _Num;
+	uint32* NeighborFlags = (uint32*)Store + 6 * _Num;
+	memset(Neighbors, 0xff, 3 * _Num * sizeof(uint32)); // NO_NEIGHBOR
+	memset(NeighborFlags, 0, _Num * sizeof(uint32));
+
+	// open-addressing table of sides; key is the side's vertex indices (low, high), value is tri index * 3 + side
+	const uint32 EdgeCapacity = FMath::RoundUpToPowerOfTwo(FMath::Max(_Num * 6, 2));
+	const uint32 EdgeMask = EdgeCapacity - 1;
+	TArray<uint64> EdgeKeys;
+	TArray<uint32> EdgeValues;
+	EdgeKeys.Init(EMPTY_EDGE, EdgeCapacity);
+	EdgeValues.SetNumUninitialized(EdgeCapacity);
+	
+	for (int i = 0; i < _Num; i++) {
+		const uint32* TriVIndices = VIndices + 3 * i;
+		for (int Side = Tri::AB; Side <= Tri::CA; Side++) {
+			const int V0 = Side;
+			const int V1 = (Side + 1) % 3;
+			const uint32 VIndex0 = TriVIndices[V0];
+			const uint32 VIndex1 = TriVIndices[V1];
+			if (VIndex0 == VIndex1) {
+				continue;
+			}
+			const uint64 Key = VIndex0 < VIndex1
+				? ((uint64)VIndex0 << 32) | VIndex1
+				: ((uint64)VIndex1 << 32) | VIndex0;
+			uint32 Slot = (uint32)((Key * 0x9E3779B97F4A7C15ull) >> 32) & EdgeMask;
+			while (EdgeKeys[Slot] != EMPTY_EDGE && EdgeKeys[Slot] != Key) {
+				Slot = (Slot + 1) & EdgeMask;
+			}
+			if (EdgeKeys[Slot] == EMPTY_EDGE) {
+				EdgeKeys[Slot] = Key;
+				EdgeValues[Slot] = i * 3 + Side;
+				continue;
+			}
+			const uint32 OtherValue = EdgeValues[Slot];
+			if (OtherValue == LINKED_EDGE) {
+				continue;
+			}
+			const uint32 OtherIndex = OtherValue / 3;
+			const int OtherSide = OtherValue % 3;
+			Neighbors[3 * i + Side] = OtherIndex;
+			Tri::AddNeighborFlag(NeighborFlags[i], V0, V1, Side);
+			Neighbors[OtherValue] = i;
+			Tri::AddNeighborFlag(NeighborFlags[OtherIndex], OtherSide, (OtherSide + 1) % 3, OtherSide);
+			EdgeValues[Slot] = LINKED_EDGE;
+		}
+	}
+}
+
+void TriGrid::SetCellCounts(const FVector& Dimensions, int TriCt) {
+	const int TargetCellCt = FMath::Clamp(TriCt / TRIS_PER_CELL, 1, MAX_CELL_CT);
+
+	// choosing a cubic cell side length that gives about TargetCellCt cells over the grid's volume. Axes thinner
+	// than one cell are given a single cell and taken out of the calculation, which is then redone over the
+	// remaining axes, so flat and long meshes don't end up with far fewer cells than they should
+	bool AxisFixed[3] {false, false, false};
+	float CellSidelen = 0.0f;
+	for (int Pass = 0; Pass < 3; Pass++) {
+		float Extent = 1.0f;
+		int FreeAxisCt = 0;
+		for (int Axis = 0; Axis < 3; Axis++) {
+			if (!AxisFixed[Axis]) {
+				Extent *= Dimensions[Axis];
+				FreeAxisCt++;
+			}
+		}
+		CellSidelen = FMath::Pow(Extent / TargetCellCt, 1.0f / FreeAxisCt);
+		bool NewlyFixed = false;
+		for (int Axis = 0; Axis < 3; Axis++) {
+			if (!AxisFixed[Axis] && Dimensions[Axis] < CellSidelen && FreeAxisCt > 1) {
+				AxisFixed[Axis] = true;
+				FreeAxisCt--;
+				NewlyFixed = true;
 			}
 		}
+		if (!NewlyFixed) {
+			break;
+		}
+	}
+	for (int Axis = 0; Axis < 3; Axis++) {
+		const int AxisCellCt = AxisFixed[Axis] ? 1 : FMath::CeilToInt(Dimensions[Axis] / CellSidelen);
+		CellCounts[Axis] = FMath::Clamp(AxisCellCt, 1, MAX_AXIS_CELL_CT);
 	}
 }
 
+uint32 TriGrid::GridToKey(const FIntVector& GridPos) const {
+	return (uint32)GridPos.X + (uint32)CellCounts.X * ((uint32)GridPos.Y + (uint32)CellCounts.Y * (uint32)GridPos.Z);
+}
+
+const TriBox* TriGrid::FindBox(uint32 Key) const {
+	if (Cells == nullptr) {
+		return nullptr;
+	}
+	uint32 Slot = (Key * CELL_HASH) & CellMask;
+	while (true) {
+		const TriGridCell& Cell = Cells[Slot];
+		if (Cell.Key == Key) {
+			return &Cell.Box;
+		}
+		if (Cell.Key == EMPTY_KEY) {
+			return nullptr;
+		}
+		Slot = (Slot + 1) & CellMask;
+	}
+}
+
+const FIntVector& TriGrid::GetCellCounts() const {
+	return CellCounts;
+}
+
+int TriGrid::GetOccupiedCellCt() const {
+	return OccupiedCellCt;
+}
+
 void TriGrid::Reset() {
-	free(Container);
-	Container = nullptr;
+	free(Store);
+	Store = nullptr;
+	free(Cells);
+	Cells = nullptr;
+	CellMask = 0;
+	OccupiedCellCt = 0;
 	_Num = 0;
+	OverflowStart = 0;
 	InitSuccess = false;
 }
 
-TriContainer& TriGrid::GetNearbyTris(const Tri& T) {
-	Outgoing.Clear();
-	const FVector ToCenter = Center - T.A;
-	const float Distance = Center.Size();
-	// if (Distance > T.LongestSidelen + HalfDiagLen) {
-	// 	return Outgoing;
-	// }
-	// FIntVector GridPos;
-	// if (WorldToGrid(T.A, GridPos)) {
-	// 	SetOutgoing(GridPos);
-	// 	return Outgoing;
-	// }
-	// FVector ClosePosition = T.A;
-	// const FVector Manhattan (FMath::Abs(ToCenter.X), FMath::Abs(ToCenter.Y), FMath::Abs(ToCenter.Z));
-	// if (Manhattan.X > HalfDimensions.X) {
-	// 	const float XDist = Manhattan.X - HalfDimensions.X;
-	// 	if (XDist < T.LongestSidelen) {
-	// 		ClosePosition.X += FMath::Sign(ToCenter.X) * (XDist + QuarterBoxDimensions.X);
-	// 	}
-	// 	else {
-	// 		return Outgoing;
-	// 	}
-	// }
-	// if (Manhattan.Y > HalfDimensions.Y) {
-	// 	const float YDist = Manhattan.Y - HalfDimensions.Y;
-	// 	if (YDist < T.LongestSidelen) {
-	// 		ClosePosition.Y += FMath::Sign(ToCenter.Y) * (YDist + QuarterBoxDimensions.Y);
-	// 	}
-	// 	else {
-	// 		return Outgoing;
-	// 	}
-	// }
-	// if (Manhattan.Z > HalfDimensions.Z) {
-	// 	const float ZDist = Manhattan.Z - HalfDimensions.Z;
-	// 	if (ZDist < T.LongestSidelen) {
-	// 		ClosePosition.Z += FMath::Sign(ToCenter.Z) * (ZDist + QuarterBoxDimensions.Z);
-	// 	}
-	// 	else {
-	// 		return Outgoing;
-	// 	}
-	// }
-	// if (WorldToGrid(ClosePosition, GridPos)) {
-	// 	SetOutgoing(GridPos);
-	// }
-	return Outgoing;
-}
-
-TriContainer& TriGrid::GetNearbyTris(const FVector& Location, float Tolerance) {
-	Outgoing.Clear();
-	FIntVector GridPos;
-	if (WorldToGrid(Location, GridPos)) {
-		SetOutgoing(GridPos);	
-	}
-	return Outgoing;
+bool TriGrid::CopyFrom(const TriGrid& Other, FVector* _Vertices) {
+	Reset();
+	// everything but the malloc'd blocks carries over as is
+	memcpy(this, &Other, sizeof(TriGrid));
+	Store = nullptr;
+	Cells = nullptr;
+	Vertices = _Vertices;
+	if (!Other.InitSuccess) {
+		_Num = 0;
+		return true;
+	}
+	
+	const uint32 CellCapacity = CellMask + 1;
+	const size_t StoreSz = GetStoreSz(_Num) + _Num * sizeof(Tri);
+	Store = malloc(StoreSz);
+	Cells = (TriGridCell*)malloc(CellCapacity * sizeof(TriGridCell));
+	if (Store == nullptr || Cells == nullptr) {
+		printf("TEMP ERROR TriGrid::CopyFrom() alloc fail\n");
+		Reset();
+		return false;
+	}
+	// both are addressed by offsets, so they copy straight over
+	memcpy(Store, Other.Store, StoreSz);
+	memcpy(Cells, Other.Cells, CellCapacity * sizeof(TriGridCell));
+	return true;
+}
+
+bool TriGrid::CopyFrom(const NavMeshFile::NavMeshView& View, FVector* _Vertices) {
+	Reset();
+	const NavMeshFile::MeshRecord& Record = View.GetRecord();
+	Vertices = _Vertices;
+	Minimum = Record.GridMinimum;
+	InvGridFactor = Record.InvGridFactor;
+	CellCounts = Record.CellCounts;
+	MaxTriReach = FVector::ZeroVector;
+	OverflowStart = Record.OverflowStart;
+	if (Record.TriCt == 0) {
+		return true;
+	}
+
+	const uint32 CellCapacity = Record.CellCapacity;
+	Store = malloc(GetStoreSz(Record.TriCt) + Record.TriCt * sizeof(Tri));
+	Cells = (TriGridCell*)malloc(CellCapacity * sizeof(TriGridCell));
+	if (Store == nullptr || Cells == nullptr) {
+		printf("TEMP ERROR TriGrid::CopyFrom() alloc fail\n");
+		Reset();
+		return false;
+	}
+	_Num = Record.TriCt;
+	CellMask = CellCapacity - 1;
+	// the file's store is TriGrid's as is; the cell table only differs in how a cell's tris are given
+	memcpy(Store, View.GetVIndexBuffer(), GetStoreSz(_Num));
+	const NavMeshFile::Cell* FileCells = View.GetCells();
+	OccupiedCellCt = 0;
+	for (uint32 i = 0; i < CellCapacity; i++) {
+		Cells[i].Key = FileCells[i].Key;
+		if (FileCells[i].Key == EMPTY_KEY) {
+			continue;
+		}
+		TriBox* TBox = new (&Cells[i].Box) TriBox();
+		TBox->SetStartIndex(FileCells[i].StartIndex);
+		TBox->SetNum(FileCells[i].Num);
+		OccupiedCellCt++;
+	}
+	// reach isn't saved, since it comes straight from the celled tris
+	Tri* GridTris = GetTris();
+	for (int i = 0; i < _Num; i++) {
+		GridTris[i].Flags = View.GetTriFlags(i);
+		if (i < OverflowStart) {
+			MaxTriReach = MaxTriReach.ComponentMax(GetTriReach(GetA(i), GetB(i), GetC(i)));
+		}
+	}
+	InitSuccess = true;
+	return true;
+}
+
+TriGridNeighborhood TriGrid::GetNearbyTris(const FVector& Min, const FVector& Max) const {
+	// clamped to the grid; a box entirely off one side leaves MinCell past MaxCell on that axis
+	const FVector MinGrid = (Min - MaxTriReach - Minimum) * InvGridFactor;
+	const FVector MaxGrid = (Max + MaxTriReach - Minimum) * InvGridFactor;
+	FIntVector MinCell, MaxCell;
+	for (int Axis = 0; Axis < 3; Axis++) {
+		MinCell[Axis] = FMath::Max(FMath::FloorToInt(MinGrid[Axis]), 0);
+		MaxCell[Axis] = FMath::Min(FMath::FloorToInt(MaxGrid[Axis]), CellCounts[Axis] - 1);
+	}
+	if (Cells == nullptr) {
+		MaxCell = FIntVector(-1, -1, -1);
+	}
+	return TriGridNeighborhood(this, MinCell, MaxCell, Min, Max);
+}
+
+TriGridNeighborhood TriGrid::GetNearbyTris(const FVector& Location, float Tolerance) const {
+	return GetNearbyTris(Location - FVector(Tolerance), Location + FVector(Tolerance));
 }
 
 int TriGrid::Num() const {
 	return _Num;
 }
 
+FVector TriGrid::GetCenter(int i) const {
+	return (GetA(i) + GetB(i) + GetC(i)) * ONE_THIRD;
+}
+
+void TriGrid::GetBounds(int i, FVector& Min, FVector& Max) const {
+	const FVector& A = GetA(i);
+	const FVector& B = GetB(i);
+	const FVector& C = GetC(i);
+	Min = A.ComponentMin(B).ComponentMin(C);
+	Max = A.ComponentMax(B).ComponentMax(C);
+}
+
 void TriGrid::SetVertices(FVector* _Vertices) {
 	Vertices = _Vertices;	
 }
 
+void TriGrid::FlipNormals() {
+	FVector* Normals = (FVector*)GetNormals();
+	for (int i = 0; i < _Num; i++) {
+		Normals[i] = -Normals[i];
+	}
+}
+
 void TriGrid::SetTriAt(int i, FVector* A, FVector* B, FVector* C) {
-	Tri* T = new ((Tri*)Container + i) Tri(*A, *B, *C);
+	new (GetTris() + i) Tri();
+	uint32* VIndices = (uint32*)Store + 3 * i;
+	VIndices[0] = A - Vertices;
+	VIndices[1] = B - Vertices;
+	VIndices[2] = C - Vertices;
+	((FVector*)GetNormals())[i] = Tri::CalculateNormal(*A, *B, *C);
 }
 
 void TriGrid::GetVIndices(int i, TArray<int32>& Indices) const {
-	const Tri& T = ((Tri*)Container)[i];
-	Indices.Add(&T.A - Vertices);
-	Indices.Add(&T.B - Vertices);
-	Indices.Add(&T.C - Vertices);
+	const uint32* VIndices = GetVIndexBuffer() + 3 * i;
+	Indices.Add(VIndices[0]);
+	Indices.Add(VIndices[1]);
+	Indices.Add(VIndices[2]);
 }
 
 void TriGrid::GetVIndices(int i, uint32* Indices) const {
-	const Tri& T = ((Tri*)Container)[i];
-	Indices[0] = &T.A - Vertices;
-	Indices[1] = &T.B - Vertices;
-	Indices[2] = &T.C - Vertices;
+	const uint32* VIndices = GetVIndexBuffer() + 3 * i;
+	Indices[0] = VIndices[0];
+	Indices[1] = VIndices[1];
+	Indices[2] = VIndices[2];
 }
 
 int TriGrid::GetVIndex(const FVector* V) const {
@@ -190,45 +428,86 @@ int TriGrid::GetVIndex(const FVector* V) const {
 }
 
 int TriGrid::GetIndex(const Tri* T) const {
-	return T - ((Tri*)Container);
-}
-
-void TriGrid::SetOutgoing(const FIntVector& GridPos) {
-	constexpr int CONTAINER_SIDELEN_M1 = CONTAINER_SIDELEN - 1;
-	const int XMin = GridPos.X == 0 ? 0 : GridPos.X - 1;
-	const int XMax = GridPos.X == CONTAINER_SIDELEN_M1 ? CONTAINER_SIDELEN_M1 : GridPos.X + 1;
-	const int YMin = GridPos.Y == 0 ? 0 : GridPos.Y - 1;
-	const int YMax = GridPos.Y == CONTAINER_SIDELEN_M1 ? CONTAINER_SIDELEN_M1 : GridPos.Y + 1;
-	const int ZMin = GridPos.Z == 0 ? 0 : GridPos.Z - 1;
-	const int ZMax = GridPos.Z == CONTAINER_SIDELEN_M1 ? CONTAINER_SIDELEN_M1 : GridPos.Z + 1;
-	TArray<TriBox*> NearbyBoxes;
-	NearbyBoxes.Add(&Boxes[GridPos.X][GridPos.Y][GridPos.Z]);
-	for (int x = XMin; x <= XMax; x++) {
-		for (int y = YMin; y < YMax; y++) {
-			for (int z = ZMin; z < ZMax; z++) {
-				auto& Box = Boxes[x][y][z];
-				if (
-					(x != GridPos.X || y != GridPos.Y || z != GridPos.Z)
-					&& Box.Num() > 0
-				) {
-					NearbyBoxes.Add(&Box);
-				}	
-			}
-		}
-	}
-	Outgoing.SetBoxes(NearbyBoxes);
+	return T - GetTris();
 }
 
 bool TriGrid::WorldToGrid(const FVector& WorldPosition, FIntVector& GridPosition) const {
 	GridPosition = FIntVector((WorldPosition - Minimum) * InvGridFactor);
 	if (
-		GridPosition.X < 0 || GridPosition.X >= CONTAINER_SIDELEN
-		|| GridPosition.Y < 0 || GridPosition.Y >= CONTAINER_SIDELEN
-		|| GridPosition.Z < 0 || GridPosition.Z >= CONTAINER_SIDELEN
+		GridPosition.X < 0 || GridPosition.X >= CellCounts.X
+		|| GridPosition.Y < 0 || GridPosition.Y >= CellCounts.Y
+		|| GridPosition.Z < 0 || GridPosition.Z >= CellCounts.Z
 	) {
 		return false;
 	}
 	return true;
 }
 
+TriGridNeighborhood::Iterator TriGridNeighborhood::begin() const {
+	Iterator It;
+	It.Neighborhood = this;
+	It.CellPos = MinCell;
+	It.TriIndex = Iterator::END;
+	It.BoxEnd = Iterator::END;
+	// an empty cell range means the box is off the grid, and every tri, overflow or not, is inside the grid
+	if (MinCell.X > MaxCell.X || MinCell.Y > MaxCell.Y || MinCell.Z > MaxCell.Z) {
+		return It;
+	}
+	// stepping back one cell so NextBox() starts on MinCell
+	It.CellPos.X--;
+	It.NextBox();
+	return It;
+}
 
+TriGridNeighborhood::Iterator TriGridNeighborhood::end() const {
+	Iterator It;
+	It.Neighborhood = this;
+	It.CellPos = MaxCell;
+	It.TriIndex = Iterator::END;
+	It.BoxEnd = Iterator::END;
+	return It;
+}
+
+void TriGridNeighborhood::Iterator::NextBox() {
+	const FIntVector& MinCell = Neighborhood->MinCell;
+	const FIntVector& MaxCell = Neighborhood->MaxCell;
+	while (true) {
+		if (++CellPos.X > MaxCell.X) {
+			CellPos.X = MinCell.X;
+			if (++CellPos.Y > MaxCell.Y) {
+				CellPos.Y = MinCell.Y;
+				if (++CellPos.Z > MaxCell.Z) {
+					// cells are done; on to the overflow tris
+					TriIndex = Neighborhood->Grid->GetOverflowStart() - 1;
+					BoxEnd = IN_OVERFLOW_TRIS;
+					NextOverflow();
+					return;
+				}
+			}
+		}
+		const TriBox* Box = Neighborhood->Grid->FindBox(Neighborhood->Grid->GridToKey(CellPos));
+		if (Box != nullptr) {
+			TriIndex = Box->GetStartIndex();
+			BoxEnd = TriIndex + Box->Num();
+			return;
+		}
+	}
+}
+
+void TriGridNeighborhood::Iterator::NextOverflow() {
+	// overflow tris are few and aren't filed by cell, so each is checked against the box directly
+	const TriGrid* Grid = Neighborhood->Grid;
+	FVector TriMin, TriMax;
+	for (TriIndex++; TriIndex < (uint32)Grid->Num(); TriIndex++) {
+		Grid->GetBounds(TriIndex, TriMin, TriMax);
+		if (
+			TriMin.X <= Neighborhood->Max.X && TriMax.X >= Neighborhood->Min.X
+			&& TriMin.Y <= Neighborhood->Max.Y && TriMax.Y >= Neighborhood->Min.Y
+			&& TriMin.Z <= Neighborhood->Max.Z && TriMax.Z >= Neighborhood->Min.Z
+		) {
+			return;
+		}
+	}
+	TriIndex = END;
+	BoxEnd = END;
+}
@@ -5,30 +5,28 @@ struct TriMesh;
 struct TempTri;
 struct UNavMesh;
 struct BoundingBox;
+namespace NavMeshFile { class NavMeshView; }
 
+// a cell's tris, which are contiguous in the grid since tris are sorted by cell
 struct TriBox {
 	
 	TriBox() :
-		Container(nullptr), StartIndex(0), _Num(0)
+		StartIndex(0), _Num(0)
 	{}
 
 	int Num() const {
 		return _Num;
 	}
 
-	Tri& operator [] (int i) const {
-		return Container[StartIndex + i];
-	}
-
-	// for use in TriGrid.cpp only
-	void SetContainer(Tri* _Container) {
-		Container = _Container;	
-	}	
-
 	// for use in TriGrid.cpp only
 	void SetStartIndex(int i) {
 		StartIndex = i;
 	}
+
+	// index in the grid of the box's first tri
+	int GetStartIndex() const {
+		return StartIndex;
+	}
 	
 	// for use in TriGrid.cpp only
 	void SetNum(int Number) {
@@ -37,89 +35,219 @@ struct TriBox {
 	
 private:
 
-	Tri* Container;
 	int StartIndex;
 	int _Num;
 	
 };
 
-// can be filled with a single TriBox or it can also include data from surrounding TriBoxes
-struct TriContainer {
+// one occupied cell of the grid's sparse cell table
+struct TriGridCell {
+	uint32 Key; // linear index of the cell in the grid; EMPTY_KEY if the slot is unused
+	TriBox Box;
+};
+
+class TriGrid;
 
-	TriContainer() :
-		_Num(0), CurBox(0), CurIndex(0)
-	{}
+// The tris of a box of grid cells, walked cell by cell. Holds only the cell range, and its iterator only a position in
+// it, so nothing is allocated and any number can be walked on one grid at once. Use with range-based for; each tri
+// comes out as its index in the grid:
+//     for (const uint32 TriIndex : Grid.GetNearbyTris(Location, Tolerance)) { ... }
+class TriGridNeighborhood {
 
-	void Reset() {
-		CurBox = 0;
-		CurIndex = 0;
-	}
+public:
 
-	Tri& Next() {
-		const TriBox& Box = Boxes[CurBox];
-		if (CurIndex >= Box.Num()) {
-			CurIndex = 1;
-			return Boxes[++CurBox][0];
+	class Iterator {
+
+	public:
+
+		uint32 operator * () const {
+			return TriIndex;
 		}
-		return Box[CurIndex++];		
-	}
 
-	int Num() const {
-		return _Num;
-	}
+		Iterator& operator ++ () {
+			if (BoxEnd == IN_OVERFLOW_TRIS) {
+				NextOverflow();
+			}
+			else if (++TriIndex == BoxEnd) {
+				NextBox();
+			}
+			return *this;
+		}
 
-	// does not reset Boxes
-	void Clear() {
-		memset(&_Num, 0, sizeof(int) * 3);
-	}
+		// tris are in at most one cell, and overflow tris in none, so the index alone tells where an iterator is
+		bool operator != (const Iterator& Other) const {
+			return TriIndex != Other.TriIndex;
+		}
+
+	private:
+
+		friend class TriGridNeighborhood;
+
+		static constexpr uint32 END = MAX_uint32;
+		// BoxEnd once the cells are walked and the iterator is in the grid's overflow tris
+		static constexpr uint32 IN_OVERFLOW_TRIS = MAX_uint32 - 1;
+
+		// moves to the first tri of the next occupied cell, or to the overflow tris once there are no more cells
+		void NextBox();
+
+		// moves to the next overflow tri whose bounds overlap the neighborhood's box, or to the end
+		void NextOverflow();
+
+		const TriGridNeighborhood* Neighborhood;
+		FIntVector CellPos;
+		uint32 TriIndex;
+		uint32 BoxEnd;
+
+	};
 
-	// only supply boxes with Num() > 0
-	void SetBoxes(const TArray<TriBox*>& _Boxes) {
-		for (int i = 0; i < _Boxes.Num(); i++) {
-			const auto& Box = _Boxes[i];
-			Boxes[i] = *Box;
-			_Num += Box->Num();
-		}	
+	Iterator begin() const;
+
+	Iterator end() const;
+
+	bool IsEmpty() const {
+		return !(begin() != end());
 	}
-	
+
 private:
-	
-	int _Num;
-	int CurBox;
-	int CurIndex;
-	// TODO: this needs to be a TArray to account for the fact that a triangle may span more than 27 boxes
-	TriBox Boxes[27]; 
-	
+
+	friend class TriGrid;
+
+	TriGridNeighborhood(
+		const TriGrid* _Grid, const FIntVector& _MinCell, const FIntVector& _MaxCell, const FVector& _Min,
+		const FVector& _Max
+	) :
+		Grid(_Grid), MinCell(_MinCell), MaxCell(_MaxCell), Min(_Min), Max(_Max)
+	{}
+
+	const TriGrid* Grid;
+	// inclusive; no cells if any component of MinCell is greater than MaxCell's
+	FIntVector MinCell;
+	FIntVector MaxCell;
+	// the box asked for, which overflow tris are checked against
+	FVector Min;
+	FVector Max;
+
 };
 
+// Tris of a mesh in a sparse grid of cells. A tri is only its index; its vertex indices, neighbors, normal and flags are
+// all kept in one structure-of-arrays block, and its vertices are read through the indices. Once built, nothing
+// that reads it writes to it, and queries hand back cursors the caller owns, so any number of threads can read one grid
+// at once without locking. Only the non-const accessors, used while the mesh is processed, change it.
 class TriGrid {
 
 public:
 	
 	TriGrid();
 	
+	// SetVertices() must be called first, since tri adjacency is found by comparing vertex indices
 	void Init(const TriMesh& TMesh, const TArray<TempTri>& Tris);
 	
+	// SetVertices() must be called first, since tri adjacency is found by comparing vertex indices
 	void Init(const UNavMesh& NMesh, const TArray<TempTri>& Tris);
 
 	void Reset();
+
+	// deep copies Other, reading the copy's vertices from _Vertices, which must be a copy of Other's vertices
+	bool CopyFrom(const TriGrid& Other, FVector* _Vertices);
 	
-	TriContainer& GetNearbyTris(const Tri& T);
-	
-	TriContainer& GetNearbyTris(const FVector& Location, float Tolerance=0.0f);
+	// every tri whose bounds overlap the box Min-Max, along with others in the cells around it. Tris are filed by
+	// their centers, so the cells walked are those of the box grown by how far any celled tri reaches past its center,
+	// which is at most a cell. Tris reaching further are kept out of the cells, and are checked against the box alone
+	TriGridNeighborhood GetNearbyTris(const FVector& Min, const FVector& Max) const;
+
+	// fills the grid from a navmesh read off disk, reading its vertices from _Vertices, which must be a copy of View's
+	// vertices. Same as CopyFrom() otherwise
+	bool CopyFrom(const NavMeshFile::NavMeshView& View, FVector* _Vertices);
+
+	// every tri within Tolerance of Location on each axis
+	TriGridNeighborhood GetNearbyTris(const FVector& Location, float Tolerance=0.0f) const;
 
 	inline int Num() const;
 	
-	Tri& operator [] (int i) const {
-		return ((Tri*)Container)[i];
+	const Tri& operator [] (int i) const {
+		return GetTris()[i];
+	}
+
+	const Tri& operator [] (uint32 i) const {
+		return GetTris()[i];
+	}
+
+	// tri flags are only written while the grid's mesh is being processed, never once it's built
+	Tri& operator [] (int i) {
+		return GetTris()[i];
 	}
 
-	Tri& operator [] (uint32 i) const {
-		return ((Tri*)Container)[i];
+	Tri& operator [] (uint32 i) {
+		return GetTris()[i];
 	}
 
 	void SetVertices(FVector* Vertices);
 
+	const FVector* GetVertices() const {
+		return Vertices;
+	}
+
+	// vertex indices of every tri, 3 per tri (A, B, C)
+	const uint32* GetVIndexBuffer() const {
+		return (const uint32*)Store;
+	}
+
+	// vertices of tri i
+	const FVector& GetA(int i) const {
+		return Vertices[GetVIndexBuffer()[3 * i]];
+	}
+
+	const FVector& GetB(int i) const {
+		return Vertices[GetVIndexBuffer()[3 * i + 1]];
+	}
+
+	const FVector& GetC(int i) const {
+		return Vertices[GetVIndexBuffer()[3 * i + 2]];
+	}
+
+	// vertices belong to the mesh, not the grid, so they can be handed out for writing or by pointer
+	FVector& GetA(int i) {
+		return Vertices[GetVIndexBuffer()[3 * i]];
+	}
+
+	FVector& GetB(int i) {
+		return Vertices[GetVIndexBuffer()[3 * i + 1]];
+	}
+
+	FVector& GetC(int i) {
+		return Vertices[GetVIndexBuffer()[3 * i + 2]];
+	}
+
+	FVector GetCenter(int i) const;
+
+	// axis-aligned bounds of tri i
+	void GetBounds(int i, FVector& Min, FVector& Max) const;
+
+	const FVector* GetNormals() const {
+		return (const FVector*)((const uint32*)Store + 7 * _Num);
+	}
+
+	const FVector& GetNormal(int i) const {
+		return GetNormals()[i];
+	}
+
+	FVector& GetNormal(int i) {
+		return ((FVector*)((uint32*)Store + 7 * _Num))[i];
+	}
+
+	// reverses the facing of every tri
+	void FlipNormals();
+
+	// index of the tri on the given side (Tri::AB, Tri::BC, Tri::CA) of tri i; NO_NEIGHBOR if that side is open
+	uint32 GetNeighbor(int i, int Side) const {
+		return ((const uint32*)Store + 3 * _Num)[3 * i + Side];
+	}
+
+	// Tri::AddNeighborFlag() flags of tri i, one per neighbor slot
+	uint32 GetNeighborFlags(int i) const {
+		return ((const uint32*)Store + 6 * _Num)[i];
+	}
+
 	void SetTriAt(int i, FVector* A, FVector* B, FVector* C);
 
 	// returns the index of the vertex; for drawing mesh
@@ -130,28 +258,98 @@ public:
 	inline int GetVIndex(const FVector* V) const;
 
 	inline int GetIndex(const Tri* T) const;
+
+	// number of cells along each axis
+	const FIntVector& GetCellCounts() const;
+
+	// number of cells holding at least one tri; only these take up memory
+	int GetOccupiedCellCt() const;
+
+	// tris from here to Num() - 1 reach more than a cell past their centers, and so aren't in any cell
+	int GetOverflowStart() const {
+		return OverflowStart;
+	}
+
+	// the structure-of-arrays block as is, less the tri flags that follow it; GetStoreSz(Num()) bytes long. For writing
+	// the grid out
+	const void* GetStore() const {
+		return Store;
+	}
+
+	static size_t GetStoreSz(int TriCt) {
+		return TriCt * (7 * sizeof(uint32) + sizeof(FVector));
+	}
+
+	// the open-addressing cell table, GetCellCapacity() slots long; unused slots have EMPTY_KEY. A cell's slot is
+	// found by probing forward from (Key * CELL_HASH) & (GetCellCapacity() - 1)
+	const TriGridCell* GetCells() const {
+		return Cells;
+	}
+
+	uint32 GetCellCapacity() const {
+		return Cells != nullptr ? CellMask + 1 : 0;
+	}
+
+	// world position of the grid's minimum corner, and cells per unit along each axis
+	const FVector& GetMinimum() const {
+		return Minimum;
+	}
+
+	const FVector& GetInvGridFactor() const {
+		return InvGridFactor;
+	}
 	
 private:
 
-	inline void SetOutgoing(const FIntVector& GridPos);
-	
+	friend class TriGridNeighborhood;
+
+	// tri flags, right after the GetStoreSz() bytes of the store
+	Tri* GetTris() const {
+		return (Tri*)((uint8*)Store + GetStoreSz(_Num));
+	}
+
 	bool WorldToGrid(const FVector& WorldPosition, FIntVector& GridPosition) const;
 
 	void Init(const BoundingBox& BBox, const TArray<TempTri>& Tris);
+
+	// fills every tri's neighbors (AB, BC, CA) and neighbor flags in one pass, by hashing each side on its sorted
+	// vertex index pair; a side shared by more than two tris links only the first two found
+	void BuildAdjacency();
+
+	// picks the number of cells along each axis from the tri count and the proportions of the grid
+	void SetCellCounts(const FVector& Dimensions, int TriCt);
+
+	inline uint32 GridToKey(const FIntVector& GridPos) const;
+
+	// nullptr if no tris are in the cell
+	const TriBox* FindBox(uint32 Key) const;
+
+	static constexpr int TRIS_PER_CELL = 8; // average number of tris per cell the grid is sized for
+	static constexpr int MAX_AXIS_CELL_CT = 256;
+	static constexpr int MAX_CELL_CT = 1 << 21;
+
+public:
 	
-	static constexpr int CONTAINER_SIDELEN = 8;
+	static constexpr uint32 NO_NEIGHBOR = MAX_uint32;
+	static constexpr uint32 EMPTY_KEY = MAX_uint32;
+	static constexpr uint32 CELL_HASH = 2654435761u;
+
+private:
 
-	void* Container;
+	// structure-of-arrays tri data in one block, addressed by offsets from the start so it can be moved or copied
+	// without re-pointing anything: vertex indices (3 per tri), neighbor indices (3 per tri), neighbor flags, normals,
+	// then tri flags
+	void* Store;
 	FVector* Vertices;
 	int _Num;
-	TriBox Boxes[CONTAINER_SIDELEN][CONTAINER_SIDELEN][CONTAINER_SIDELEN];
+	int OverflowStart;
+	TriGridCell* Cells; // open-addressing table; only occupied cells are stored
+	uint32 CellMask; // cell table capacity - 1
+	int OccupiedCellCt;
+	FIntVector CellCounts;
 	bool InitSuccess;
 	FVector InvGridFactor;
 	FVector Minimum;
-	FVector Center;
-	FVector HalfDimensions;
-	FVector QuarterBoxDimensions;
-	float HalfDiagLen;
-	TriContainer Outgoing;
+	FVector MaxTriReach; // furthest any celled tri's bounds reach past its center, per axis; at most a cell
 		
 };
@@ -3,6 +3,7 @@
 TriMesh::TriMesh() :
 	Box(),
 	VertexCt(0),
+	WeldedVertexCt(0),
 	Vertices(nullptr),
 	MeshActor(nullptr)
 {}
@@ -22,9 +23,31 @@ bool TriMesh::operator == (const TriMesh& OtherMesh) const {
 
 void TriMesh::ResetVertexData() {
 	VertexCt = 0;
+	WeldedVertexCt = 0;
 	if (Vertices != nullptr) {
-		delete Vertices;
+		delete[] Vertices;
 		Vertices = nullptr;
 	}
+	BVH.Reset();
 	Grid.Reset();
+}
+
+bool TriMesh::CopyFrom(const TriMesh& OtherMesh) {
+	ResetVertexData();
+	Box = OtherMesh.Box;
+	if (OtherMesh.Vertices == nullptr) {
+		return true;
+	}
+	Vertices = new FVector[OtherMesh.VertexCt];
+	if (Vertices == nullptr) {
+		return false;
+	}
+	memcpy(Vertices, OtherMesh.Vertices, OtherMesh.VertexCt * sizeof(FVector));
+	VertexCt = OtherMesh.VertexCt;
+	WeldedVertexCt = OtherMesh.WeldedVertexCt;
+	if (!Grid.CopyFrom(OtherMesh.Grid, Vertices) || !BVH.CopyFrom(OtherMesh.BVH)) {
+		ResetVertexData();
+		return false;
+	}
+	return true;
 }
\ No newline at end of file
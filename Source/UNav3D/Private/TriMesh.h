@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "TriGrid.h"
+#include "TriBVH.h"
 #include "BoundingBox.h"
 
 struct Tri;
@@ -18,9 +19,15 @@ struct TriMesh {
 	// Clears Vertices and Tris, since they are inextricably linked
 	void ResetVertexData();
 
+	// Deep copies OtherMesh's box, vertices, grid and bvh, unlike the copy constructor, which shares them. MeshActor is
+	// left as is. Returns false (with vertex data reset) if an allocation fails
+	bool CopyFrom(const TriMesh& OtherMesh);
+
 	BoundingBox Box;
 	int VertexCt;
+	int WeldedVertexCt; // vertices that were welded to another vertex, and so are no longer referenced by any tri
 	FVector* Vertices;
 	TriGrid Grid;
+	TriBVH BVH; // built over Grid for ray and overlap queries
 	AStaticMeshActor* MeshActor;
 };
@@ -7,6 +7,7 @@
 #include "Debug.h"
 #include "Misc/FeedbackContext.h"
 #include "DataProcessing.h"
+#include "Editor.h"
 
 // using the default windows package define; would be better to determine this
 #define _WIN32_WINNT_WIN10_TH2 0
@@ -35,6 +36,7 @@ void FUNav3DModule::StartupModule() {
 	UToolMenus::RegisterStartupCallback(
 		FSimpleMulticastDelegate::FDelegate::CreateRaw(this, &FUNav3DModule::RegisterMenus)
 	);
+	FEditorDelegates::OnMapOpened.AddRaw(this, &FUNav3DModule::OnMapOpened);
 
 #ifdef UNAV_DBG
 	FILE *pFile = nullptr;
@@ -46,6 +48,7 @@ void FUNav3DModule::StartupModule() {
 }
 
 void FUNav3DModule::ShutdownModule() {
+	FEditorDelegates::OnMapOpened.RemoveAll(this);
 	UToolMenus::UnRegisterStartupCallback(this);
 	UToolMenus::UnregisterOwner(this);
 	FUNav3DStyle::Shutdown();
@@ -64,6 +67,10 @@ void FUNav3DModule::PluginButtonClicked(){
 	DataProcessing::Cleanup();
 }
 
+void FUNav3DModule::OnMapOpened(const FString& Filename, bool AsTemplate) {
+	DataProcessing::LoadNavMeshes();
+}
+
 void FUNav3DModule::RegisterMenus() {
 	// Owner will be used for cleanup in call to UToolMenus::UnregisterOwner
 	FToolMenuOwnerScoped OwnerScoped(this);
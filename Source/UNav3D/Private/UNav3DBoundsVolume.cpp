@@ -13,6 +13,7 @@ AUNav3DBoundsVolume::AUNav3DBoundsVolume() {
 	BoundsBox = CreateDefaultSubobject<UBoxComponent>(TEXT("Bounds Box"));
 	BoundsBox->SetupAttachment(BoundsMesh);
 	BoundsBox->SetBoxExtent(FVector(5.0f, 5.0f, 5.0f));
+	WeldEpsilon = 1e-3f;
 }
 
 void AUNav3DBoundsVolume::BeginPlay() {
@@ -50,6 +51,8 @@ void AUNav3DBoundsVolume::GetOverlappingMeshes(TArray<TriMesh>& Meshes) {
 	else {
 		Meshes.Reserve(FoundActors.Num());
 	}
+	TArray<TriMesh> Candidates;
+	Candidates.Reserve(FoundActors.Num());
 	for (int i = 0; i < FoundActors.Num(); i++) {
 		AStaticMeshActor* FoundMesh = Cast<AStaticMeshActor>(FoundActors[i]);
 		if (FoundMesh == nullptr) {
@@ -70,15 +73,38 @@ void AUNav3DBoundsVolume::GetOverlappingMeshes(TArray<TriMesh>& Meshes) {
 			continue;	
 		}
 
-		TriMesh TrMesh;
+		TriMesh& TrMesh = Candidates.AddDefaulted_GetRef();
 		TrMesh.MeshActor = FoundMesh;
 		Geometry::SetBoundingBox(TrMesh.Box, FoundMesh);
-		// DoBoundingBoxesOverlap() checks if B pts are in A first, so this order is helpful for resolving positive
-		// results faster
-		if (Geometry::DoBoundingBoxesOverlap(OverlapBBox, TrMesh.Box)) {
-			Meshes.Add(TrMesh);
+	}
+	// testing the volume against all the candidates' boxes at once
+	TArray<const BoundingBox*> CandidateBoxes;
+	CandidateBoxes.Reserve(Candidates.Num());
+	for (const TriMesh& Candidate : Candidates) {
+		CandidateBoxes.Add(&Candidate.Box);
+	}
+	TArray<int> Overlaps;
+	Geometry::GetOverlappingBoxes(OverlapBBox, CandidateBoxes, Overlaps);
+	for (int i = 0; i < Overlaps.Num(); i++) {
+		Meshes.Add(Candidates[Overlaps[i]]);
+	}
+#ifdef UNAV_DEV
+	// checking the separating axis test against the raycast test it replaced, on the volume against every candidate
+	// and on every pair of meshes inside the volume, which grouping tests next
+	TArray<const BoundingBox*> CheckBoxes;
+	TArray<bool> IsInside;
+	IsInside.Init(false, CandidateBoxes.Num());
+	for (const int Overlap : Overlaps) {
+		CheckBoxes.Add(CandidateBoxes[Overlap]);
+		IsInside[Overlap] = true;
+	}
+	for (int i = 0; i < CandidateBoxes.Num(); i++) {
+		if (!IsInside[i]) {
+			CheckBoxes.Add(CandidateBoxes[i]);
 		}
 	}
+	Geometry::CompareBoxOverlapTests(OverlapBBox, CheckBoxes, Overlaps.Num());
+#endif
 	if (Meshes.Num() > 0) {
 		Data::BoundsVolumeTMesh.ResetVertexData();
 		Data::BoundsVolumeTMesh.MeshActor = this;
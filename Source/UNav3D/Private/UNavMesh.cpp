@@ -6,10 +6,6 @@ UNavMesh::UNavMesh() :
 	Vertices(nullptr)
 {}
 
-UNavMesh::UNavMesh(const UNavMesh& OtherMesh) {
-	memcpy(this, &OtherMesh, sizeof(UNavMesh));
-}
-
 UNavMesh::~UNavMesh() {
 	ResetVertexData();
 }
@@ -21,8 +17,10 @@ bool UNavMesh::operator == (const UNavMesh& OtherMesh) const {
 void UNavMesh::ResetVertexData() {
 	VertexCt = 0;
 	if (Vertices != nullptr) {
-		delete Vertices;
+		delete[] Vertices;
 		Vertices = nullptr;
 	}
+	BVH.Reset();
+	Hierarchy.Reset();
 	Grid.Reset();
 }
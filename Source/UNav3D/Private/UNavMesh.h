@@ -2,10 +2,16 @@
 
 #include "BoundingBox.h"
 #include "TriGrid.h"
+#include "TriBVH.h"
+#include "NavHierarchy.h"
+#include "MeshCache.h"
 
 struct UNavMesh {
 	UNavMesh();
-	UNavMesh(const UNavMesh& OtherMesh);
+	// a copy would share the vertex, grid, bvh and hierarchy buffers and the actor arrays, and free them all twice;
+	// navmeshes are constructed in place instead
+	UNavMesh(const UNavMesh& OtherMesh) = delete;
+	UNavMesh& operator = (const UNavMesh& OtherMesh) = delete;
 	~UNavMesh();
 
 	// checks if the TMeshes point to the same static mesh
@@ -18,6 +24,10 @@ struct UNavMesh {
 	int VertexCt;
 	FVector* Vertices;
 	TriGrid Grid;
+	TriBVH BVH; // built over Grid for ray and overlap queries
+	NavHierarchy Hierarchy; // built over Grid for long path queries
 	TArray<AStaticMeshActor*> MeshActors;
+	// per actor in MeshActors, its box and what it looked like when this mesh was built
 	TArray<BoundingBox> ActorBoxes;
+	TArray<MeshCacheKey> ActorKeys;
 };
@@ -4,6 +4,7 @@
 #include "Draw.h"
 #include "Debug.h"
 #include "Kismet/GameplayStatics.h"
+#include "DataProcessing.h"
 
 // TODO: find ADraw at open and delete
 
@@ -36,6 +37,14 @@ void UNavUI::PostLoad() {
 	}
 }
 
+void UNavUI::RebuildChangedNavMeshes() {
+	if (!DataProcessing::Init()) {
+		UNAV_GENERR("Failed to instantiate Data Processing threads.");
+	}
+	DataProcessing::IncrementalReload();
+	DataProcessing::Cleanup();
+}
+
 void UNavUI::HideAndShowAllStaticMeshes() {
 	if (Data::NMeshes.Num() > 0) {
 		// doing it this way both because meshes will be individually selectable for visibility
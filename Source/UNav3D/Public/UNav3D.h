@@ -22,6 +22,9 @@ private:
 
 	void RegisterMenus();
 
+	// loads the navmeshes saved for the map, if there are any
+	void OnMapOpened(const FString& Filename, bool AsTemplate);
+
 	TSharedPtr<FUICommandList> PluginCommands;
 	
 };
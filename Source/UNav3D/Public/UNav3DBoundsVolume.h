@@ -35,6 +35,9 @@ public:
 	UStaticMeshComponent* BoundsMesh;
 	UPROPERTY(BlueprintReadWrite, VisibleDefaultsOnly)
 	UBoxComponent* BoundsBox;
+	// Mesh vertices closer together than this are welded into one vertex when mesh data is read
+	UPROPERTY(EditAnywhere, Category="UNav3D", meta=(ClampMin="0.0"))
+	float WeldEpsilon;
 	
 
 protected:
@@ -17,6 +17,10 @@ public:
 
 	virtual void PostLoad() override;
 
+	// rebuilds only the navmeshes affected by actors added, removed or moved since the last build
+	UFUNCTION(BlueprintCallable)
+	void RebuildChangedNavMeshes();
+
 	UFUNCTION(BlueprintCallable)
 	void HideAndShowAllStaticMeshes();
 